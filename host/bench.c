@@ -0,0 +1,1620 @@
+//*****************************************************************************
+//
+// bench.c - Replays input traces through the pipeline in simulated time and
+//           reports the latency and accuracy of what reaches the host.
+//
+// A trace is a time ordered list of pin and trackball changes.  It comes from
+// one of the built in generators or from a file.  The bench steps the
+// simulated board through it, running the SysTick sampler and the main loop
+// pipeline exactly as the firmware does, and acting as the USB host polling
+// every interrupt endpoint once a frame.
+//
+// The intended press and release of each switch is taken from the trace
+// itself: a level that holds for at least the settle time (-S) is real, and
+// its edge is the first transition of the bounce burst that led to it.
+// Shorter pulses are bounce or noise.  The bench then reports:
+//
+//  - press-to-report latency, from the intended edge to the host receiving a
+//    report with the new level, as p50, p99 and max,
+//  - missed edges, intended edges the host never saw,
+//  - hat edges, intended D-pad edges made while the opposite direction was
+//    held or still on its way to the host, which the hat cannot tell apart
+//    and which are kept out of the latency and missed counts,
+//  - phantom edges, changes the host saw that were not intended,
+//  - host CPU cycles spent per tick in sampling and the pipeline, as the
+//    mean and the 99th percentile, which leaves out ticks the host operating
+//    system interrupted,
+//  - trackball counts turned, scaled by the axis sensitivity, against
+//    motion reported,
+//  - with CUSTOMHID_SPINNER, spinner steps turned against steps reported,
+//  - with CUSTOMHID_ANALOG_AXES, the analog reports sent, the range of the
+//    first axis reported and how often it turned back, which noise on a pot
+//    at rest shows up as.
+//
+// A built in trace that misses an intended edge, or lets through more phantom
+// edges a second than its limit, fails the run, so a debounce regression
+// stops "make bench".
+//
+// Trace files are text, one change per line, in time order:
+//
+//     <time_us> pin <input> <level>      input 0-29 of the packed input word,
+//                                        level 1 for closed
+//     <time_us> qei <encoder> <counts>   encoder 0 for X, 1 for Y
+//     <time_us> spin <encoder> <dir>     one quadrature step of a software
+//                                        decoded encoder, dir 1 or -1
+//     <time_us> adc <axis> <raw>         12 bit reading of an analog input
+//
+// Lines starting with # are ignored.
+//
+// Reports are decoded for the default button map, with each D-pad hat turned
+// back into its four direction inputs.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "usblib/device/usbdhidmamecfg.h"
+#include "hal.h"
+#include "debounce.h"
+#include "mousemotion.h"
+#include "softquad.h"
+#include "analog.h"
+#include "pipeline.h"
+#include "hal_linux.h"
+
+//*****************************************************************************
+//
+// The SysTick and USB frame periods in microseconds.
+//
+//*****************************************************************************
+#define BENCH_TICK_US           1000
+#define BENCH_FRAME_US          1000
+
+//*****************************************************************************
+//
+// The number of packed inputs and the kinds of trace entry.
+//
+//*****************************************************************************
+#define BENCH_INPUTS            30
+#define BENCH_EVENT_PIN         0
+#define BENCH_EVENT_QEI         1
+#define BENCH_EVENT_SPIN        2
+#define BENCH_EVENT_ADC         3
+
+//*****************************************************************************
+//
+// The input capture modes of the firmware.  Sampled capture needs a build
+// with INPUT_SAMPLE_HZ.
+//
+//*****************************************************************************
+#define BENCH_CAPTURE_POLLED    0
+#define BENCH_CAPTURE_EDGE      1
+#define BENCH_CAPTURE_SAMPLED   2
+
+//*****************************************************************************
+//
+// Cycles per tick are read from the time stamp counter where there is one and
+// are nanoseconds otherwise.
+//
+//*****************************************************************************
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_CYCLE_UNITS       "cyc"
+#else
+#define BENCH_CYCLE_UNITS       "ns"
+#endif
+
+//*****************************************************************************
+//
+// One trace entry.  ui32Seq keeps entries at the same time in the order they
+// were generated.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Time;
+    uint32_t ui32Seq;
+    uint8_t ui8Kind;
+    uint8_t ui8Index;
+    int16_t i16Value;
+}
+tBenchEvent;
+
+//*****************************************************************************
+//
+// A growable trace.
+//
+//*****************************************************************************
+typedef struct
+{
+    tBenchEvent *psEvents;
+    uint32_t ui32Count;
+    uint32_t ui32Size;
+}
+tBenchTrace;
+
+//*****************************************************************************
+//
+// An intended edge of one input.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Time;
+    uint8_t ui8Input;
+    uint8_t ui8Level;
+}
+tBenchEdge;
+
+//*****************************************************************************
+//
+// The results of one run.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t *pui32Latency;
+    uint32_t ui32Latencies;
+    uint32_t ui32Edges;
+    uint32_t ui32Missed;
+    uint32_t ui32Hat;
+    uint32_t ui32Phantom;
+    uint32_t ui32Reports;
+    uint64_t ui64Cycles;
+    uint32_t *pui32TickCycles;
+    uint32_t ui32Ticks;
+    int64_t pi64CountsIn[CUSTOMHID_MOUSE_AXES];
+    int64_t pi64CountsOut[CUSTOMHID_MOUSE_AXES];
+    int32_t pi32LastMotion[2];
+    uint64_t ui64Jitter;
+    uint32_t ui32JitterPairs;
+    uint32_t ui32AnalogReports;
+    uint32_t ui32AnalogMin;
+    uint32_t ui32AnalogMax;
+    uint32_t ui32AnalogLast;
+    int32_t i32AnalogDir;
+    uint32_t ui32AnalogReversals;
+}
+tBenchResult;
+
+//*****************************************************************************
+//
+// Run options.
+//
+//*****************************************************************************
+static uint32_t g_ui32Duration = 10000000;
+static uint32_t g_ui32Settle = 5000;
+static uint32_t g_ui32FramePhase = 500;
+static uint32_t g_ui32Seed = 1;
+static uint32_t g_ui32Capture = BENCH_CAPTURE_EDGE;
+static uint32_t g_ui32Interval = REPORT_INTERVAL_MS;
+static uint32_t g_ui32EagerInputs = DEBOUNCE_EAGER_INPUTS;
+static uint32_t g_ui32Sensitivity = MOUSE_SENSITIVITY;
+
+//*****************************************************************************
+//
+// State of the run in progress, used by the report callback.
+//
+//*****************************************************************************
+static tBenchResult *g_psResult;
+static uint8_t g_pui8HostLevel[BENCH_INPUTS];
+static bool g_pbPending[BENCH_INPUTS];
+static uint8_t g_pui8PendingLevel[BENCH_INPUTS];
+static uint32_t g_pui32PendingTime[BENCH_INPUTS];
+static bool g_pbPendingHat[BENCH_INPUTS];
+static uint32_t g_ui32LatencySize;
+static uint32_t g_ui32TickSize;
+
+//*****************************************************************************
+//
+// A small deterministic random number generator so every run of a generator
+// with the same seed replays the same trace.
+//
+//*****************************************************************************
+static uint32_t g_ui32Random;
+
+static uint32_t
+BenchRandom(void)
+{
+    g_ui32Random ^= g_ui32Random << 13;
+    g_ui32Random ^= g_ui32Random >> 17;
+    g_ui32Random ^= g_ui32Random << 5;
+    return(g_ui32Random);
+}
+
+static uint32_t
+BenchRange(uint32_t ui32Min, uint32_t ui32Max)
+{
+    return(ui32Min + (BenchRandom() % (ui32Max - ui32Min + 1)));
+}
+
+//*****************************************************************************
+//
+// Returns a cycle count for timing the pipeline.
+//
+//*****************************************************************************
+static uint64_t
+BenchCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return(__rdtsc());
+#else
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return(((uint64_t)sNow.tv_sec * 1000000000) + sNow.tv_nsec);
+#endif
+}
+
+//*****************************************************************************
+//
+// Adds an entry to a trace.
+//
+//*****************************************************************************
+static void
+BenchTraceAdd(tBenchTrace *psTrace, uint32_t ui32Time, uint8_t ui8Kind,
+              uint8_t ui8Index, int32_t i32Value)
+{
+    tBenchEvent *psEvent;
+
+    if(psTrace->ui32Count == psTrace->ui32Size)
+    {
+        psTrace->ui32Size = psTrace->ui32Size ? (psTrace->ui32Size * 2) : 1024;
+        psTrace->psEvents = realloc(psTrace->psEvents,
+                                    psTrace->ui32Size * sizeof(tBenchEvent));
+        if(!psTrace->psEvents)
+        {
+            fprintf(stderr, "bench: out of memory\n");
+            exit(1);
+        }
+    }
+
+    psEvent = &psTrace->psEvents[psTrace->ui32Count];
+    psEvent->ui32Time = ui32Time;
+    psEvent->ui32Seq = psTrace->ui32Count;
+    psEvent->ui8Kind = ui8Kind;
+    psEvent->ui8Index = ui8Index;
+    psEvent->i16Value = i32Value;
+    psTrace->ui32Count++;
+}
+
+static int
+BenchEventCompare(const void *pvA, const void *pvB)
+{
+    const tBenchEvent *psA = pvA, *psB = pvB;
+
+    if(psA->ui32Time != psB->ui32Time)
+    {
+        return((psA->ui32Time < psB->ui32Time) ? -1 : 1);
+    }
+    return((psA->ui32Seq < psB->ui32Seq) ? -1 : 1);
+}
+
+//*****************************************************************************
+//
+// Adds a switch edge to a trace, preceded by a burst of bounces.  Each bounce
+// is a pair of transitions, away from the new level and back, and the burst
+// lasts between ui32MinSeg and ui32MaxSeg microseconds per transition.
+// Returns the time the switch settles.
+//
+//*****************************************************************************
+static uint32_t
+BenchSwitchEdge(tBenchTrace *psTrace, uint32_t ui32Time, uint8_t ui8Input,
+                uint8_t ui8Level, uint32_t ui32Bounces, uint32_t ui32MinSeg,
+                uint32_t ui32MaxSeg)
+{
+    uint32_t ui32Idx;
+
+    BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_PIN, ui8Input, ui8Level);
+    for(ui32Idx = 0; ui32Idx < ui32Bounces; ui32Idx++)
+    {
+        ui32Time += BenchRange(ui32MinSeg, ui32MaxSeg);
+        BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_PIN, ui8Input, !ui8Level);
+        ui32Time += BenchRange(ui32MinSeg, ui32MaxSeg);
+        BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_PIN, ui8Input, ui8Level);
+    }
+
+    return(ui32Time);
+}
+
+//*****************************************************************************
+//
+// Microswitches: one input at a time, with a short burst of fast bounces on
+// each press and fewer on release.
+//
+//*****************************************************************************
+static void
+BenchGenMicroswitch(tBenchTrace *psTrace)
+{
+    uint32_t ui32Time;
+    uint8_t ui8Input;
+
+    ui32Time = 20000;
+    while(ui32Time < g_ui32Duration)
+    {
+        ui8Input = BenchRange(0, BENCH_INPUTS - 1);
+        ui32Time = BenchSwitchEdge(psTrace, ui32Time, ui8Input, 1,
+                                   BenchRange(0, 6), 20, 400);
+        ui32Time += BenchRange(40000, 200000);
+        ui32Time = BenchSwitchEdge(psTrace, ui32Time, ui8Input, 0,
+                                   BenchRange(0, 2), 20, 200);
+        ui32Time += BenchRange(50000, 300000);
+    }
+}
+
+//*****************************************************************************
+//
+// Leaf switches: long, slow bounce bursts and brief chatter while held.
+//
+//*****************************************************************************
+static void
+BenchGenLeaf(tBenchTrace *psTrace)
+{
+    uint32_t ui32Time, ui32Release;
+    uint8_t ui8Input;
+
+    ui32Time = 20000;
+    while(ui32Time < g_ui32Duration)
+    {
+        ui8Input = BenchRange(0, BENCH_INPUTS - 1);
+        ui32Time = BenchSwitchEdge(psTrace, ui32Time, ui8Input, 1,
+                                   BenchRange(2, 12), 50, 1500);
+        ui32Release = ui32Time + BenchRange(60000, 300000);
+
+        //
+        // The contact wipes while held, opening for a few hundred
+        // microseconds at a time.
+        //
+        ui32Time += BenchRange(5000, 40000);
+        while(ui32Time + 20000 < ui32Release)
+        {
+            BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_PIN, ui8Input, 0);
+            ui32Time += BenchRange(30, 300);
+            BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_PIN, ui8Input, 1);
+            ui32Time += BenchRange(10000, 60000);
+        }
+
+        ui32Time = BenchSwitchEdge(psTrace, ui32Release, ui8Input, 0,
+                                   BenchRange(1, 8), 50, 1500);
+        ui32Time += BenchRange(50000, 300000);
+    }
+}
+
+//*****************************************************************************
+//
+// Mashing: every gamepad input of both players pressed and released
+// independently at 6 to 15 presses a second, with microswitch bounce.
+//
+//*****************************************************************************
+static void
+BenchGenMash(tBenchTrace *psTrace)
+{
+    uint32_t ui32Time;
+    uint8_t ui8Input;
+
+    for(ui8Input = 0; ui8Input < INPUT_MOUSE_BTN_S; ui8Input++)
+    {
+        ui32Time = BenchRange(1000, 100000);
+        while(ui32Time < g_ui32Duration)
+        {
+            ui32Time = BenchSwitchEdge(psTrace, ui32Time, ui8Input, 1,
+                                       BenchRange(0, 6), 20, 400);
+            ui32Time += BenchRange(30000, 80000);
+            ui32Time = BenchSwitchEdge(psTrace, ui32Time, ui8Input, 0,
+                                       BenchRange(0, 2), 20, 200);
+            ui32Time += BenchRange(30000, 80000);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Noise: clean presses of one input at a time on the first half of the
+// inputs, while spikes of 2 to 30 microseconds, as picked up from a nearby
+// coin mech or CRT, land on the open inputs of the second half every few
+// milliseconds.  The edge finder takes the spikes as too short to be meant.
+//
+//*****************************************************************************
+static void
+BenchGenNoise(tBenchTrace *psTrace)
+{
+    uint32_t ui32Time, ui32Spike, ui32Width;
+    uint8_t ui8Input;
+
+    ui32Time = 20000;
+    while(ui32Time < g_ui32Duration)
+    {
+        ui8Input = BenchRange(0, (BENCH_INPUTS / 2) - 1);
+        BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_PIN, ui8Input, 1);
+        ui32Time += BenchRange(40000, 200000);
+        BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_PIN, ui8Input, 0);
+        ui32Time += BenchRange(50000, 300000);
+    }
+
+    for(ui32Spike = BenchRange(1000, 5000); ui32Spike < g_ui32Duration;
+        ui32Spike += BenchRange(1000, 5000))
+    {
+        ui8Input = BenchRange(BENCH_INPUTS / 2, BENCH_INPUTS - 1);
+        ui32Width = BenchRange(2, 30);
+        BenchTraceAdd(psTrace, ui32Spike, BENCH_EVENT_PIN, ui8Input, 1);
+        BenchTraceAdd(psTrace, ui32Spike + ui32Width, BENCH_EVENT_PIN,
+                      ui8Input, 0);
+    }
+}
+
+//*****************************************************************************
+//
+// Trackball spins: bursts of steady rotation on both axes at up to 40 counts
+// a millisecond, in either direction, with pauses between them.
+//
+//*****************************************************************************
+static void
+BenchGenTrackball(tBenchTrace *psTrace)
+{
+    uint32_t ui32Time, ui32End, ui32Step;
+    uint8_t ui8Encoder;
+    int32_t i32Dir;
+
+    for(ui8Encoder = HAL_QEI_X; ui8Encoder <= HAL_QEI_Y; ui8Encoder++)
+    {
+        ui32Time = BenchRange(1000, 50000);
+        while(ui32Time < g_ui32Duration)
+        {
+            ui32End = ui32Time + BenchRange(200000, 800000);
+            ui32Step = BenchRange(25, 500);
+            i32Dir = (BenchRandom() & 1) ? 1 : -1;
+            for(; ui32Time < ui32End;
+                ui32Time += BenchRange(ui32Step - (ui32Step / 4),
+                                       ui32Step + (ui32Step / 4)))
+            {
+                BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_QEI, ui8Encoder,
+                              i32Dir);
+            }
+            ui32Time += BenchRange(50000, 400000);
+        }
+    }
+}
+
+#if CUSTOMHID_SPINNER
+//*****************************************************************************
+//
+// Spinner flicks: short fast spins of up to 20 steps a millisecond, easing
+// off as they go, in either direction.
+//
+//*****************************************************************************
+static void
+BenchGenSpinner(tBenchTrace *psTrace)
+{
+    uint32_t ui32Time, ui32End, ui32Step;
+    int32_t i32Dir;
+
+    ui32Time = BenchRange(1000, 50000);
+    while(ui32Time < g_ui32Duration)
+    {
+        ui32End = ui32Time + BenchRange(50000, 400000);
+        ui32Step = BenchRange(50, 200);
+        i32Dir = (BenchRandom() & 1) ? 1 : -1;
+        for(; ui32Time < ui32End;
+            ui32Time += BenchRange(ui32Step - (ui32Step / 4),
+                                   ui32Step + (ui32Step / 4)))
+        {
+            BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_SPIN, SOFTQUAD_SPINNER,
+                          i32Dir);
+            ui32Step += ui32Step / 64 + 1;
+        }
+        ui32Time += BenchRange(100000, 600000);
+    }
+}
+#endif
+
+#if CUSTOMHID_ANALOG_AXES
+//*****************************************************************************
+//
+// Pedal: the first analog input ramps between a rest and a pressed position
+// that stop short of the ends of the ADC range, and holds at each for a
+// while.  A few counts of noise ride on every reading.
+//
+//*****************************************************************************
+static void
+BenchGenPedal(tBenchTrace *psTrace)
+{
+    uint32_t ui32Time, ui32End, ui32Ramp, ui32Idx;
+    int32_t i32From, i32To, i32Level;
+
+    ui32Time = 1000;
+    i32From = 200;
+    while(ui32Time < g_ui32Duration)
+    {
+        i32To = (i32From < 2048) ? BenchRange(2048, 3900) :
+                                   BenchRange(200, 400);
+
+        //
+        // Ramp over 20 to 200 ms, then hold for 100 to 500 ms.
+        //
+        ui32Ramp = BenchRange(80, 800);
+        for(ui32Idx = 0; ui32Idx < ui32Ramp; ui32Idx++, ui32Time += 250)
+        {
+            i32Level = i32From + (((i32To - i32From) * (int32_t)ui32Idx) /
+                                  (int32_t)ui32Ramp);
+            BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_ADC, 0,
+                          i32Level + (int32_t)BenchRange(0, 6) - 3);
+        }
+        ui32End = ui32Time + BenchRange(100000, 500000);
+        for(; ui32Time < ui32End; ui32Time += 250)
+        {
+            BenchTraceAdd(psTrace, ui32Time, BENCH_EVENT_ADC, 0,
+                          i32To + (int32_t)BenchRange(0, 6) - 3);
+        }
+        i32From = i32To;
+    }
+}
+#endif
+
+//*****************************************************************************
+//
+// Reads a trace file.  Returns false if it can not be read.
+//
+//*****************************************************************************
+static bool
+BenchTraceLoad(tBenchTrace *psTrace, const char *pcFile)
+{
+    FILE *psFile;
+    char pcLine[128], pcKind[8];
+    unsigned long ulTime;
+    unsigned int uiIndex;
+    int iValue;
+    uint32_t ui32Line;
+
+    psFile = fopen(pcFile, "r");
+    if(!psFile)
+    {
+        perror(pcFile);
+        return(false);
+    }
+
+    for(ui32Line = 1; fgets(pcLine, sizeof(pcLine), psFile); ui32Line++)
+    {
+        if((pcLine[0] == '#') || (pcLine[0] == '\n'))
+        {
+            continue;
+        }
+        if(sscanf(pcLine, "%lu %7s %u %d", &ulTime, pcKind, &uiIndex,
+                  &iValue) != 4)
+        {
+            fprintf(stderr, "%s:%u: bad line\n", pcFile, ui32Line);
+            fclose(psFile);
+            return(false);
+        }
+        if(!strcmp(pcKind, "pin") && (uiIndex < BENCH_INPUTS))
+        {
+            BenchTraceAdd(psTrace, ulTime, BENCH_EVENT_PIN, uiIndex, !!iValue);
+        }
+        else if(!strcmp(pcKind, "qei") && (uiIndex <= HAL_QEI_Y))
+        {
+            BenchTraceAdd(psTrace, ulTime, BENCH_EVENT_QEI, uiIndex, iValue);
+        }
+        else if(!strcmp(pcKind, "spin") && (uiIndex < SOFTQUAD_CHANNELS) &&
+                ((iValue == 1) || (iValue == -1)))
+        {
+            BenchTraceAdd(psTrace, ulTime, BENCH_EVENT_SPIN, uiIndex, iValue);
+        }
+        else if(!strcmp(pcKind, "adc") && (uiIndex < 4) && (iValue >= 0) &&
+                (iValue <= 4095))
+        {
+            BenchTraceAdd(psTrace, ulTime, BENCH_EVENT_ADC, uiIndex, iValue);
+        }
+        else
+        {
+            fprintf(stderr, "%s:%u: bad entry\n", pcFile, ui32Line);
+            fclose(psFile);
+            return(false);
+        }
+    }
+
+    fclose(psFile);
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Finds the intended edges of every input in a sorted trace.  A level is
+// intended once it has held for the settle time, and its edge is the first
+// transition away from the previous intended level.  Returns the number of
+// edges written to psEdges, which must have room for one per pin entry.
+//
+//*****************************************************************************
+static uint32_t
+BenchEdgesFind(const tBenchTrace *psTrace, tBenchEdge *psEdges)
+{
+    uint32_t ui32Idx, ui32Next, ui32Count, ui32Start, ui32Hold;
+    uint8_t ui8Input, ui8Level, ui8Intended;
+    bool bStarted;
+
+    ui32Count = 0;
+    for(ui8Input = 0; ui8Input < BENCH_INPUTS; ui8Input++)
+    {
+        ui8Intended = 0;
+        bStarted = false;
+        ui32Start = 0;
+        for(ui32Idx = 0; ui32Idx < psTrace->ui32Count; ui32Idx++)
+        {
+            if((psTrace->psEvents[ui32Idx].ui8Kind != BENCH_EVENT_PIN) ||
+               (psTrace->psEvents[ui32Idx].ui8Index != ui8Input) ||
+               !(INPUT_SWITCHES & (1 << ui8Input)))
+            {
+                continue;
+            }
+
+            //
+            // Find how long this level holds.
+            //
+            for(ui32Next = ui32Idx + 1; ui32Next < psTrace->ui32Count;
+                ui32Next++)
+            {
+                if((psTrace->psEvents[ui32Next].ui8Kind == BENCH_EVENT_PIN) &&
+                   (psTrace->psEvents[ui32Next].ui8Index == ui8Input))
+                {
+                    break;
+                }
+            }
+            ui32Hold = (ui32Next < psTrace->ui32Count) ?
+                       (psTrace->psEvents[ui32Next].ui32Time -
+                        psTrace->psEvents[ui32Idx].ui32Time) : 0xFFFFFFFF;
+
+            ui8Level = psTrace->psEvents[ui32Idx].i16Value;
+            if(ui8Level != ui8Intended)
+            {
+                if(!bStarted)
+                {
+                    ui32Start = psTrace->psEvents[ui32Idx].ui32Time;
+                    bStarted = true;
+                }
+                if(ui32Hold >= g_ui32Settle)
+                {
+                    psEdges[ui32Count].ui32Time = ui32Start;
+                    psEdges[ui32Count].ui8Input = ui8Input;
+                    psEdges[ui32Count].ui8Level = ui8Level;
+                    ui32Count++;
+                    ui8Intended = ui8Level;
+                    bStarted = false;
+                }
+            }
+            else if(ui32Hold >= g_ui32Settle)
+            {
+                bStarted = false;
+            }
+        }
+    }
+
+    return(ui32Count);
+}
+
+static int
+BenchEdgeCompare(const void *pvA, const void *pvB)
+{
+    const tBenchEdge *psA = pvA, *psB = pvB;
+
+    if(psA->ui32Time != psB->ui32Time)
+    {
+        return((psA->ui32Time < psB->ui32Time) ? -1 : 1);
+    }
+    return((int)psA->ui8Input - (int)psB->ui8Input);
+}
+
+//*****************************************************************************
+//
+// Drives one switch pin.  A closed switch pulls its pin low.
+//
+//*****************************************************************************
+static void
+BenchPinSet(uint8_t ui8Input, uint8_t ui8Level)
+{
+    uint32_t ui32Port;
+    uint8_t ui8Pin, ui8Port;
+
+    if(ui8Input < INPUT_PAD1_BTN1_S)
+    {
+        ui32Port = HAL_PORTD;
+        ui8Pin = ui8Input - INPUT_PAD1_DPAD_S;
+    }
+    else if(ui8Input < INPUT_PAD1_BTN9_S)
+    {
+        ui32Port = HAL_PORTA;
+        ui8Pin = ui8Input - INPUT_PAD1_BTN1_S;
+    }
+    else if(ui8Input < INPUT_PAD2_DPAD_S)
+    {
+        ui32Port = HAL_PORTC;
+        ui8Pin = ui8Input - INPUT_PAD1_BTN9_S;
+    }
+    else if(ui8Input < INPUT_PAD2_BTN1_S)
+    {
+        ui32Port = HAL_PORTE;
+        ui8Pin = ui8Input - INPUT_PAD2_DPAD_S + 2;
+    }
+    else if(ui8Input < INPUT_MOUSE_BTN_S)
+    {
+        ui32Port = HAL_PORTB;
+        ui8Pin = ui8Input - INPUT_PAD2_BTN1_S;
+    }
+    else
+    {
+        ui32Port = HAL_PORTE;
+        ui8Pin = ui8Input - INPUT_MOUSE_BTN_S;
+    }
+
+    ui8Port = HALSimPortGet(ui32Port);
+    if(ui8Level)
+    {
+        ui8Port &= ~(1 << ui8Pin);
+    }
+    else
+    {
+        ui8Port |= 1 << ui8Pin;
+    }
+    HALSimPortSet(ui32Port, ui8Port);
+}
+
+//*****************************************************************************
+//
+// Turns a software decoded encoder one quadrature step by moving its pins to
+// the next state in the direction given.  Turning forward the A/B states run
+// 0, 1, 3, 2.
+//
+//*****************************************************************************
+static void
+BenchSpinStep(uint8_t ui8Encoder, int32_t i32Dir)
+{
+    static const uint8_t pui8Sequence[4] = { 0, 1, 3, 2 };
+    const tSoftQuadPins *psPins;
+    uint32_t ui32Idx;
+    uint8_t ui8Port, ui8State;
+
+    psPins = &g_psSoftQuadPins[ui8Encoder];
+    ui8Port = HALSimPortGet(psPins->ui8Port);
+    ui8State = ((ui8Port & psPins->ui8PinA) ? 1 : 0) |
+               ((ui8Port & psPins->ui8PinB) ? 2 : 0);
+    for(ui32Idx = 0; pui8Sequence[ui32Idx] != ui8State; ui32Idx++)
+    {
+    }
+    ui8State = pui8Sequence[(ui32Idx + i32Dir) & 3];
+
+    ui8Port &= ~(psPins->ui8PinA | psPins->ui8PinB);
+    ui8Port |= ((ui8State & 1) ? psPins->ui8PinA : 0) |
+               ((ui8State & 2) ? psPins->ui8PinB : 0);
+    HALSimPortSet(psPins->ui8Port, ui8Port);
+}
+
+//*****************************************************************************
+//
+// Adds the motion of each axis from a report to the reported totals.  Jitter
+// is the change in trackball motion from one report to the next while an
+// axis keeps moving the same way.
+//
+//*****************************************************************************
+static void
+BenchMotion(const uint8_t *pui8Motion)
+{
+    int32_t pi32Motion[CUSTOMHID_MOUSE_AXES];
+    uint32_t ui32Axis;
+
+    for(ui32Axis = 0; ui32Axis < CUSTOMHID_MOUSE_AXES; ui32Axis++)
+    {
+#if CUSTOMHID_MOUSE_16BIT
+        pi32Motion[ui32Axis] = (int16_t)(pui8Motion[0] | (pui8Motion[1] << 8));
+        pui8Motion += 2;
+#else
+        pi32Motion[ui32Axis] = (int8_t)pui8Motion[0];
+        pui8Motion++;
+#endif
+        g_psResult->pi64CountsOut[ui32Axis] += pi32Motion[ui32Axis];
+    }
+
+    for(ui32Axis = HAL_QEI_X; ui32Axis <= HAL_QEI_Y; ui32Axis++)
+    {
+        if((pi32Motion[ui32Axis] > 0) ?
+           (g_psResult->pi32LastMotion[ui32Axis] > 0) :
+           ((pi32Motion[ui32Axis] < 0) &&
+            (g_psResult->pi32LastMotion[ui32Axis] < 0)))
+        {
+            g_psResult->ui64Jitter +=
+                abs(pi32Motion[ui32Axis] -
+                    g_psResult->pi32LastMotion[ui32Axis]);
+            g_psResult->ui32JitterPairs++;
+        }
+        g_psResult->pi32LastMotion[ui32Axis] = pi32Motion[ui32Axis];
+    }
+}
+
+//*****************************************************************************
+//
+// Follows the first axis of an analog report.  A reversal is a change of
+// direction from one report to the next.
+//
+//*****************************************************************************
+static void
+BenchAnalog(const uint8_t *pui8Axes)
+{
+    uint32_t ui32Value;
+    int32_t i32Dir;
+
+    ui32Value = pui8Axes[0] | (pui8Axes[1] << 8);
+    if(!g_psResult->ui32AnalogReports++)
+    {
+        g_psResult->ui32AnalogMin = ui32Value;
+        g_psResult->ui32AnalogMax = ui32Value;
+    }
+    if(ui32Value < g_psResult->ui32AnalogMin)
+    {
+        g_psResult->ui32AnalogMin = ui32Value;
+    }
+    if(ui32Value > g_psResult->ui32AnalogMax)
+    {
+        g_psResult->ui32AnalogMax = ui32Value;
+    }
+
+    i32Dir = (ui32Value > g_psResult->ui32AnalogLast) ? 1 :
+             ((ui32Value < g_psResult->ui32AnalogLast) ? -1 : 0);
+    if(i32Dir && g_psResult->i32AnalogDir &&
+       (i32Dir != g_psResult->i32AnalogDir))
+    {
+        g_psResult->ui32AnalogReversals++;
+    }
+    if(i32Dir)
+    {
+        g_psResult->i32AnalogDir = i32Dir;
+    }
+    g_psResult->ui32AnalogLast = ui32Value;
+}
+
+//*****************************************************************************
+//
+// Returns the level an input is meant to be at now.
+//
+//*****************************************************************************
+static uint8_t
+BenchIntended(uint8_t ui8Input)
+{
+    return(g_pbPending[ui8Input] ? g_pui8PendingLevel[ui8Input] :
+           g_pui8HostLevel[ui8Input]);
+}
+
+//*****************************************************************************
+//
+// Returns the opposite direction of a D-pad input, or BENCH_INPUTS for any
+// other input.
+//
+//*****************************************************************************
+static uint8_t
+BenchHatOpposite(uint8_t ui8Input)
+{
+    if(((uint32_t)(ui8Input - INPUT_PAD1_DPAD_S) < 4) ||
+       ((uint32_t)(ui8Input - INPUT_PAD2_DPAD_S) < 4))
+    {
+        return(ui8Input ^ 1);
+    }
+    return(BENCH_INPUTS);
+}
+
+//*****************************************************************************
+//
+// Turns the X and Y fields of a D-pad hat back into its up, down, left and
+// right inputs, starting at ui8First, for the default button map.  Opposite
+// directions cancel, so a field of 0 may be both held or both released.
+//
+//*****************************************************************************
+static uint32_t
+BenchHatDecode(uint8_t ui8Hat, uint8_t ui8First)
+{
+    uint32_t ui32Dirs, ui32Axis, ui32Neg;
+    uint8_t ui8Field, ui8Input, ui8Held;
+
+    ui32Dirs = 0;
+    for(ui32Axis = 0; ui32Axis < 2; ui32Axis++)
+    {
+        //
+        // X is left and right, Y is up and down, each negative first.
+        //
+        ui8Field = (ui8Hat >> (ui32Axis * 2)) & 3;
+        ui32Neg = ui32Axis ? 0 : 2;
+        if(ui8Field == 1)
+        {
+            ui32Dirs |= 2 << ui32Neg;
+        }
+        else if(ui8Field == 3)
+        {
+            ui32Dirs |= 1 << ui32Neg;
+        }
+        else
+        {
+            //
+            // Keep what the host last saw if it already read as 0, otherwise
+            // go by what is meant now.
+            //
+            ui8Input = ui8First + ui32Neg;
+            if(g_pui8HostLevel[ui8Input] == g_pui8HostLevel[ui8Input + 1])
+            {
+                ui8Held = g_pui8HostLevel[ui8Input];
+            }
+            else
+            {
+                ui8Held = BenchIntended(ui8Input) &&
+                          BenchIntended(ui8Input + 1);
+            }
+            ui32Dirs |= (ui8Held ? 3 : 0) << ui32Neg;
+        }
+    }
+
+    return(ui32Dirs);
+}
+
+//*****************************************************************************
+//
+// Called for every report the simulated host receives.  Decodes the inputs
+// the report carries and matches each change against the intended edges.
+//
+//*****************************************************************************
+static void
+BenchReport(uint32_t ui32Channel, const uint8_t *pui8Report, uint32_t ui32Size,
+            uint32_t ui32Time)
+{
+    uint32_t ui32State, ui32Mask, ui32Latency;
+    uint8_t ui8Input, ui8Level;
+
+    g_psResult->ui32Reports++;
+
+    switch(pui8Report[0])
+    {
+        case 1:
+        {
+            ui32State = ((BenchHatDecode(pui8Report[1], INPUT_PAD1_DPAD_S) <<
+                          INPUT_PAD1_DPAD_S) |
+                         (pui8Report[2] << INPUT_PAD1_BTN1_S) |
+                         (pui8Report[3] << INPUT_PAD1_BTN9_S));
+            ui32Mask = 0x0000FFFF;
+            break;
+        }
+        case 2:
+        {
+            ui32State = ((BenchHatDecode(pui8Report[1], INPUT_PAD2_DPAD_S) <<
+                          INPUT_PAD2_DPAD_S) |
+                         (pui8Report[2] << INPUT_PAD2_BTN1_S));
+            ui32Mask = 0x0FFF0000;
+            break;
+        }
+        case CUSTOMHID_REPORT_ID_MOUSE:
+        {
+            ui32State = (uint32_t)pui8Report[1] << INPUT_MOUSE_BTN_S;
+            ui32Mask = 0x30000000;
+            BenchMotion(&pui8Report[2]);
+            break;
+        }
+        case CUSTOMHID_REPORT_ID_ANALOG:
+        {
+            BenchAnalog(&pui8Report[1]);
+            return;
+        }
+        case CUSTOMHID_REPORT_ID_COMBINED:
+        {
+            ui32Mask = pui8Report[2] | (pui8Report[3] << 8) |
+                       (pui8Report[4] << 16);
+            ui32State = (BenchHatDecode(pui8Report[1] & 0x0F,
+                                        INPUT_PAD1_DPAD_S) <<
+                         INPUT_PAD1_DPAD_S) |
+                        (BenchHatDecode(pui8Report[1] >> 4,
+                                        INPUT_PAD2_DPAD_S) <<
+                         INPUT_PAD2_DPAD_S) |
+                        ((ui32Mask & 0x0FFF) << INPUT_PAD1_BTN1_S) |
+                        ((ui32Mask >> 12) << INPUT_PAD2_BTN1_S);
+            ui32Mask = INPUT_ALL;
+            BenchMotion(&pui8Report[5]);
+            break;
+        }
+        default:
+        {
+            return;
+        }
+    }
+
+    for(ui8Input = 0; ui8Input < BENCH_INPUTS; ui8Input++)
+    {
+        if(!(ui32Mask & (1 << ui8Input)))
+        {
+            continue;
+        }
+        ui8Level = (ui32State >> ui8Input) & 1;
+        if(ui8Level == g_pui8HostLevel[ui8Input])
+        {
+            continue;
+        }
+        g_pui8HostLevel[ui8Input] = ui8Level;
+
+        if(g_pbPending[ui8Input] && (g_pui8PendingLevel[ui8Input] == ui8Level))
+        {
+            g_pbPending[ui8Input] = false;
+            if(g_pbPendingHat[ui8Input])
+            {
+                continue;
+            }
+            ui32Latency = ui32Time - g_pui32PendingTime[ui8Input];
+            if(g_psResult->ui32Latencies == g_ui32LatencySize)
+            {
+                g_ui32LatencySize = g_ui32LatencySize ?
+                                    (g_ui32LatencySize * 2) : 1024;
+                g_psResult->pui32Latency =
+                    realloc(g_psResult->pui32Latency,
+                            g_ui32LatencySize * sizeof(uint32_t));
+                if(!g_psResult->pui32Latency)
+                {
+                    fprintf(stderr, "bench: out of memory\n");
+                    exit(1);
+                }
+            }
+            g_psResult->pui32Latency[g_psResult->ui32Latencies++] = ui32Latency;
+        }
+        else if(g_pbPending[ui8Input] && g_pbPendingHat[ui8Input])
+        {
+            //
+            // A hat edge is read back by guesswork, so the host may see the
+            // input go either way until the pair settles.
+            //
+            continue;
+        }
+        else
+        {
+            g_psResult->ui32Phantom++;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Samples and runs the pipeline for one SysTick as the SysTick handler and
+// main loop do, and times it.
+//
+//*****************************************************************************
+static void
+BenchTick(uint32_t ui32Tick, bool bSample)
+{
+    uint64_t ui64Start, ui64Cycles;
+
+    ui64Start = BenchCycles();
+#if INPUT_SAMPLE_HZ
+    if(g_ui32Capture == BENCH_CAPTURE_SAMPLED)
+    {
+        StoreSwitchSamples();
+    }
+    else
+#endif
+    if(bSample)
+    {
+        StoreSwitches();
+    }
+    PipelineTick(ui32Tick);
+    ui64Cycles = BenchCycles() - ui64Start;
+
+    if(g_psResult->ui32Ticks == g_ui32TickSize)
+    {
+        g_ui32TickSize = g_ui32TickSize ? (g_ui32TickSize * 2) : 1024;
+        g_psResult->pui32TickCycles =
+            realloc(g_psResult->pui32TickCycles,
+                    g_ui32TickSize * sizeof(uint32_t));
+        if(!g_psResult->pui32TickCycles)
+        {
+            fprintf(stderr, "bench: out of memory\n");
+            exit(1);
+        }
+    }
+    g_psResult->pui32TickCycles[g_psResult->ui32Ticks++] =
+        (ui64Cycles > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)ui64Cycles;
+    g_psResult->ui64Cycles += ui64Cycles;
+}
+
+//*****************************************************************************
+//
+// Replays a sorted trace through the pipeline.
+//
+//*****************************************************************************
+static void
+BenchRun(const tBenchTrace *psTrace, const tBenchEdge *psEdges,
+         uint32_t ui32Edges, tBenchResult *psResult)
+{
+    uint32_t ui32Now, ui32NextTick, ui32NextFrame, ui32End, ui32Tick;
+    uint32_t ui32Event, ui32Edge, ui32Settle, ui32Channel;
+    uint8_t ui8Input, ui8Opposite;
+    const tBenchEvent *psEvent;
+
+    memset(psResult, 0, sizeof(*psResult));
+    g_psResult = psResult;
+    g_ui32LatencySize = 0;
+    g_ui32TickSize = 0;
+    memset(g_pui8HostLevel, 0, sizeof(g_pui8HostLevel));
+    memset(g_pbPending, 0, sizeof(g_pbPending));
+    memset(g_pbPendingHat, 0, sizeof(g_pbPendingHat));
+
+    HALInit(0);
+    PipelineInit();
+    DebounceEagerSet(g_ui32EagerInputs, DEBOUNCE_HOLDOFF);
+    ReportIntervalSet(g_ui32Interval);
+    MouseSensitivitySet(HAL_QEI_X, g_ui32Sensitivity);
+    MouseSensitivitySet(HAL_QEI_Y, g_ui32Sensitivity);
+    HALSimReportCallbackSet(BenchReport);
+    HALSimConfigure(true);
+    PipelineConnect(0);
+
+    ui32Tick = 0;
+    ui32Settle = DEBOUNCE_MAX_COUNT;
+    ui32NextTick = BENCH_TICK_US;
+    ui32NextFrame = g_ui32FramePhase;
+    ui32End = psTrace->ui32Count ?
+              (psTrace->psEvents[psTrace->ui32Count - 1].ui32Time + 100000) :
+              0;
+    ui32Event = 0;
+    ui32Edge = 0;
+
+    for(ui32Now = 0; ui32Now < ui32End; )
+    {
+        HALSimTimeSet(ui32Now);
+
+        //
+        // Apply the trace up to now.  In edge capture mode the first change
+        // after a quiet period is sampled at once and restarts the SysTick,
+        // and a change it accepts runs the pipeline straight away.
+        //
+        while((ui32Event < psTrace->ui32Count) &&
+              (psTrace->psEvents[ui32Event].ui32Time <= ui32Now))
+        {
+            psEvent = &psTrace->psEvents[ui32Event++];
+            if(psEvent->ui8Kind == BENCH_EVENT_QEI)
+            {
+                HALSimQEIMove(psEvent->ui8Index, psEvent->i16Value);
+                psResult->pi64CountsIn[psEvent->ui8Index] +=
+                    psEvent->i16Value;
+                continue;
+            }
+            if(psEvent->ui8Kind == BENCH_EVENT_ADC)
+            {
+                HALSimAnalogSet(psEvent->ui8Index, psEvent->i16Value);
+                continue;
+            }
+            if(psEvent->ui8Kind == BENCH_EVENT_SPIN)
+            {
+                BenchSpinStep(psEvent->ui8Index, psEvent->i16Value);
+#if CUSTOMHID_SPINNER
+                psResult->pi64CountsIn[MOUSE_AXIS_SPINNER] +=
+                    psEvent->i16Value;
+#endif
+                continue;
+            }
+
+            BenchPinSet(psEvent->ui8Index, psEvent->i16Value);
+            if(g_ui32Capture == BENCH_CAPTURE_EDGE)
+            {
+                if(!ui32Settle)
+                {
+                    ui32NextTick = ui32Now + BENCH_TICK_US;
+                    if(StoreSwitchesEdge())
+                    {
+                        BenchTick(ui32Tick, false);
+                    }
+                }
+                ui32Settle = DEBOUNCE_MAX_COUNT;
+            }
+        }
+
+        //
+        // Start waiting for each intended edge as it happens.  One still
+        // waiting when the next comes along was never seen by the host.
+        //
+        while((ui32Edge < ui32Edges) && (psEdges[ui32Edge].ui32Time <= ui32Now))
+        {
+            ui8Input = psEdges[ui32Edge].ui8Input;
+            if(g_pbPending[ui8Input] && !g_pbPendingHat[ui8Input])
+            {
+                psResult->ui32Missed++;
+            }
+            g_pbPending[ui8Input] = true;
+            g_pbPendingHat[ui8Input] = false;
+            g_pui8PendingLevel[ui8Input] = psEdges[ui32Edge].ui8Level;
+            g_pui32PendingTime[ui8Input] = psEdges[ui32Edge].ui32Time;
+            ui32Edge++;
+
+            //
+            // A D-pad edge made while the opposite direction is held, or is
+            // itself still on its way to the host, may reach the hat as the
+            // same centred field as both released.  Count both directions'
+            // edges as hat edges rather than timing them.
+            //
+            ui8Opposite = BenchHatOpposite(ui8Input);
+            if((ui8Opposite < BENCH_INPUTS) &&
+               (BenchIntended(ui8Opposite) || g_pbPending[ui8Opposite]))
+            {
+                g_pbPendingHat[ui8Input] = true;
+                psResult->ui32Hat++;
+                if(g_pbPending[ui8Opposite] && !g_pbPendingHat[ui8Opposite])
+                {
+                    g_pbPendingHat[ui8Opposite] = true;
+                    psResult->ui32Hat++;
+                }
+            }
+        }
+
+        if(ui32Now == ui32NextTick)
+        {
+            ui32Tick++;
+            ui32NextTick += BENCH_TICK_US;
+            if(g_ui32Capture != BENCH_CAPTURE_EDGE)
+            {
+                BenchTick(ui32Tick, true);
+            }
+            else if(ui32Settle)
+            {
+                ui32Settle--;
+                BenchTick(ui32Tick, true);
+            }
+            else
+            {
+                BenchTick(ui32Tick, false);
+            }
+        }
+
+        if(ui32Now == ui32NextFrame)
+        {
+            ui32NextFrame += BENCH_FRAME_US;
+            for(ui32Channel = 0; ui32Channel < CUSTOMHID_NUM_IFACES;
+                ui32Channel++)
+            {
+                HALSimHostPoll(ui32Channel);
+            }
+        }
+
+        //
+        // Move on to whatever happens next.
+        //
+        ui32Now = (ui32NextTick < ui32NextFrame) ? ui32NextTick : ui32NextFrame;
+        if((ui32Event < psTrace->ui32Count) &&
+           (psTrace->psEvents[ui32Event].ui32Time < ui32Now))
+        {
+            ui32Now = psTrace->psEvents[ui32Event].ui32Time;
+        }
+        if((ui32Edge < ui32Edges) && (psEdges[ui32Edge].ui32Time < ui32Now))
+        {
+            ui32Now = psEdges[ui32Edge].ui32Time;
+        }
+    }
+
+    for(ui32Edge = 0; ui32Edge < BENCH_INPUTS; ui32Edge++)
+    {
+        if(g_pbPending[ui32Edge] && !g_pbPendingHat[ui32Edge])
+        {
+            psResult->ui32Missed++;
+        }
+    }
+    psResult->ui32Edges = ui32Edges;
+}
+
+static int
+BenchLatencyCompare(const void *pvA, const void *pvB)
+{
+    uint32_t ui32A = *(const uint32_t *)pvA, ui32B = *(const uint32_t *)pvB;
+
+    return((ui32A < ui32B) ? -1 : (ui32A > ui32B));
+}
+
+//*****************************************************************************
+//
+// Prints one line of results.
+//
+//*****************************************************************************
+static void
+BenchPrint(const char *pcName, tBenchResult *psResult)
+{
+    uint32_t ui32P50, ui32P99, ui32Max, ui32CyclesP99;
+
+    ui32P50 = ui32P99 = ui32Max = ui32CyclesP99 = 0;
+    if(psResult->ui32Latencies)
+    {
+        qsort(psResult->pui32Latency, psResult->ui32Latencies,
+              sizeof(uint32_t), BenchLatencyCompare);
+        ui32P50 = psResult->pui32Latency[(psResult->ui32Latencies - 1) / 2];
+        ui32P99 = psResult->pui32Latency[((psResult->ui32Latencies - 1) * 99) /
+                                         100];
+        ui32Max = psResult->pui32Latency[psResult->ui32Latencies - 1];
+    }
+    if(psResult->ui32Ticks)
+    {
+        qsort(psResult->pui32TickCycles, psResult->ui32Ticks,
+              sizeof(uint32_t), BenchLatencyCompare);
+        ui32CyclesP99 =
+            psResult->pui32TickCycles[((psResult->ui32Ticks - 1) * 99) / 100];
+    }
+
+    printf("%-12s %7u %7u %7u %7u %7u %7u %7u %8u %9llu %9u",
+           pcName, psResult->ui32Edges, ui32P50, ui32P99, ui32Max,
+           psResult->ui32Missed, psResult->ui32Hat, psResult->ui32Phantom,
+           psResult->ui32Reports,
+           psResult->ui32Ticks ?
+           (unsigned long long)(psResult->ui64Cycles / psResult->ui32Ticks) :
+           0ULL,
+           ui32CyclesP99);
+    if(psResult->pi64CountsIn[HAL_QEI_X] || psResult->pi64CountsIn[HAL_QEI_Y])
+    {
+        printf("  ball in %lld,%lld out %lld,%lld",
+               (long long)((psResult->pi64CountsIn[HAL_QEI_X] *
+                            MouseSensitivityGet(HAL_QEI_X)) / 256),
+               (long long)((psResult->pi64CountsIn[HAL_QEI_Y] *
+                            MouseSensitivityGet(HAL_QEI_Y)) / 256),
+               (long long)psResult->pi64CountsOut[HAL_QEI_X],
+               (long long)psResult->pi64CountsOut[HAL_QEI_Y]);
+        printf(" jitter %.2f",
+               psResult->ui32JitterPairs ?
+               ((double)psResult->ui64Jitter / psResult->ui32JitterPairs) :
+               0.0);
+    }
+    if(psResult->ui32AnalogReports > 1)
+    {
+        printf("  analog %u range %u-%u reversals %u",
+               psResult->ui32AnalogReports, psResult->ui32AnalogMin,
+               psResult->ui32AnalogMax, psResult->ui32AnalogReversals);
+    }
+#if CUSTOMHID_SPINNER
+    if(psResult->pi64CountsIn[MOUSE_AXIS_SPINNER])
+    {
+        printf("  spin in %lld out %lld",
+               (long long)psResult->pi64CountsIn[MOUSE_AXIS_SPINNER],
+               (long long)psResult->pi64CountsOut[MOUSE_AXIS_SPINNER]);
+    }
+#endif
+    printf("\n");
+
+    free(psResult->pui32Latency);
+    psResult->pui32Latency = 0;
+    free(psResult->pui32TickCycles);
+    psResult->pui32TickCycles = 0;
+}
+
+//*****************************************************************************
+//
+// The built in trace generators, each with the phantom edges per second it is
+// allowed before the run fails, or 0 for no limit.  Polled capture lets about
+// five a second through on the leaf trace and edge capture fewer; a sample
+// from the GPIO interrupt that can confirm a release lets through twenty.
+//
+//*****************************************************************************
+static const struct
+{
+    const char *pcName;
+    void (*pfnGenerate)(tBenchTrace *psTrace);
+    uint32_t ui32PhantomLimit;
+}
+g_psGenerators[] =
+{
+    { "microswitch", BenchGenMicroswitch, 0 },
+    { "leaf", BenchGenLeaf, 8 },
+    { "mash", BenchGenMash, 0 },
+    { "noise", BenchGenNoise, 0 },
+    { "trackball", BenchGenTrackball, 0 },
+#if CUSTOMHID_SPINNER
+    { "spinner", BenchGenSpinner, 0 },
+#endif
+#if CUSTOMHID_ANALOG_AXES
+    { "pedal", BenchGenPedal, 0 },
+#endif
+};
+
+#define NUM_GENERATORS          (sizeof(g_psGenerators) /                     \
+                                 sizeof(g_psGenerators[0]))
+
+//*****************************************************************************
+//
+// Sorts a trace, finds its intended edges, replays it and prints the result.
+// The number of missed edges is written to pui32Missed.
+//
+// \return Returns the number of phantom edges.
+//
+//*****************************************************************************
+static uint32_t
+BenchTrace(const char *pcName, tBenchTrace *psTrace, uint32_t *pui32Missed)
+{
+    tBenchEdge *psEdges;
+    tBenchResult sResult;
+    uint32_t ui32Edges;
+
+    qsort(psTrace->psEvents, psTrace->ui32Count, sizeof(tBenchEvent),
+          BenchEventCompare);
+
+    psEdges = malloc((psTrace->ui32Count + 1) * sizeof(tBenchEdge));
+    if(!psEdges)
+    {
+        fprintf(stderr, "bench: out of memory\n");
+        exit(1);
+    }
+    ui32Edges = BenchEdgesFind(psTrace, psEdges);
+    qsort(psEdges, ui32Edges, sizeof(tBenchEdge), BenchEdgeCompare);
+
+    BenchRun(psTrace, psEdges, ui32Edges, &sResult);
+    BenchPrint(pcName, &sResult);
+
+    free(psEdges);
+
+    *pui32Missed = sResult.ui32Missed;
+    return(sResult.ui32Phantom);
+}
+
+static void
+BenchUsage(void)
+{
+    uint32_t ui32Idx;
+
+    fprintf(stderr,
+            "usage: bench [options] [trace-file...]\n"
+            "  -g name   run one generator:");
+    for(ui32Idx = 0; ui32Idx < NUM_GENERATORS; ui32Idx++)
+    {
+        fprintf(stderr, " %s", g_psGenerators[ui32Idx].pcName);
+    }
+    fprintf(stderr,
+            "\n"
+            "  -d sec    generated trace length (10)\n"
+            "  -r seed   generator seed (1)\n"
+            "  -m mode   capture mode, edge, polled or sampled (edge)\n"
+            "  -i ms     report interval, 1, 2, 4 or 8 (%u)\n"
+            "  -e mask   inputs using the eager debounce policy (0x%x)\n"
+            "  -p us     USB frame phase against the SysTick (500)\n"
+            "  -S us     shortest level counted as intended (5000)\n"
+            "  -s n      trackball sensitivity, 256 for 1.0 (%u)\n"
+            "With no trace files or -g, every generator is run.\n",
+            REPORT_INTERVAL_MS, DEBOUNCE_EAGER_INPUTS, MOUSE_SENSITIVITY);
+    exit(2);
+}
+
+int
+main(int argc, char *argv[])
+{
+    tBenchTrace sTrace;
+    const char *pcGenerator;
+    uint32_t ui32Idx, ui32Phantom, ui32Missed;
+    int iOpt, iRet;
+
+    pcGenerator = 0;
+    iRet = 0;
+    while(argc > 1 && argv[1][0] == '-')
+    {
+        if(argc < 3)
+        {
+            BenchUsage();
+        }
+        iOpt = argv[1][1];
+        switch(iOpt)
+        {
+            case 'g': pcGenerator = argv[2]; break;
+            case 'd': g_ui32Duration = strtoul(argv[2], 0, 0) * 1000000; break;
+            case 'r': g_ui32Seed = strtoul(argv[2], 0, 0); break;
+            case 'i': g_ui32Interval = strtoul(argv[2], 0, 0); break;
+            case 'e': g_ui32EagerInputs = strtoul(argv[2], 0, 0); break;
+            case 'p': g_ui32FramePhase = strtoul(argv[2], 0, 0); break;
+            case 'S': g_ui32Settle = strtoul(argv[2], 0, 0); break;
+            case 's': g_ui32Sensitivity = strtoul(argv[2], 0, 0); break;
+            case 'm':
+            {
+                if(!strcmp(argv[2], "edge"))
+                {
+                    g_ui32Capture = BENCH_CAPTURE_EDGE;
+                }
+                else if(!strcmp(argv[2], "polled"))
+                {
+                    g_ui32Capture = BENCH_CAPTURE_POLLED;
+                }
+#if INPUT_SAMPLE_HZ
+                else if(!strcmp(argv[2], "sampled"))
+                {
+                    g_ui32Capture = BENCH_CAPTURE_SAMPLED;
+                }
+#endif
+                else
+                {
+                    BenchUsage();
+                }
+                break;
+            }
+            default:
+            {
+                BenchUsage();
+            }
+        }
+        argc -= 2;
+        argv += 2;
+    }
+    if((g_ui32Interval != 1) && (g_ui32Interval != 2) &&
+       (g_ui32Interval != 4) && (g_ui32Interval != 8))
+    {
+        BenchUsage();
+    }
+    if((g_ui32Sensitivity < MOUSE_SENSITIVITY_MIN) ||
+       (g_ui32Sensitivity > MOUSE_SENSITIVITY_MAX))
+    {
+        BenchUsage();
+    }
+    if(pcGenerator)
+    {
+        for(ui32Idx = 0; ui32Idx < NUM_GENERATORS; ui32Idx++)
+        {
+            if(!strcmp(pcGenerator, g_psGenerators[ui32Idx].pcName))
+            {
+                break;
+            }
+        }
+        if(ui32Idx == NUM_GENERATORS)
+        {
+            BenchUsage();
+        }
+    }
+    g_ui32FramePhase %= BENCH_FRAME_US;
+    if(!g_ui32Seed)
+    {
+        g_ui32Seed = 1;
+    }
+
+    printf("%-12s %7s %7s %7s %7s %7s %7s %7s %8s %9s %9s\n", "trace",
+           "edges", "p50us", "p99us", "maxus", "missed", "hat", "phantom",
+           "reports", BENCH_CYCLE_UNITS "/tick", "p99");
+
+    if(argc > 1)
+    {
+        for(ui32Idx = 1; ui32Idx < (uint32_t)argc; ui32Idx++)
+        {
+            memset(&sTrace, 0, sizeof(sTrace));
+            if(!BenchTraceLoad(&sTrace, argv[ui32Idx]))
+            {
+                return(1);
+            }
+            BenchTrace(argv[ui32Idx], &sTrace, &ui32Missed);
+            free(sTrace.psEvents);
+        }
+        return(0);
+    }
+
+    for(ui32Idx = 0; ui32Idx < NUM_GENERATORS; ui32Idx++)
+    {
+        if(pcGenerator && strcmp(pcGenerator, g_psGenerators[ui32Idx].pcName))
+        {
+            continue;
+        }
+        memset(&sTrace, 0, sizeof(sTrace));
+        g_ui32Random = g_ui32Seed;
+        g_psGenerators[ui32Idx].pfnGenerate(&sTrace);
+        ui32Phantom = BenchTrace(g_psGenerators[ui32Idx].pcName, &sTrace,
+                                 &ui32Missed);
+        free(sTrace.psEvents);
+
+        //
+        // Fail the run if the trace missed an intended edge, or let through
+        // more phantom edges than its limit allows for the length of the
+        // trace.
+        //
+        if(ui32Missed)
+        {
+            fprintf(stderr, "bench: %s: %u missed edges\n",
+                    g_psGenerators[ui32Idx].pcName, ui32Missed);
+            iRet = 1;
+        }
+        if(g_psGenerators[ui32Idx].ui32PhantomLimit &&
+           (((uint64_t)ui32Phantom * 1000000) >
+            ((uint64_t)g_psGenerators[ui32Idx].ui32PhantomLimit *
+             g_ui32Duration)))
+        {
+            fprintf(stderr, "bench: %s: %u phantom edges, limit %u a second\n",
+                    g_psGenerators[ui32Idx].pcName, ui32Phantom,
+                    g_psGenerators[ui32Idx].ui32PhantomLimit);
+            iRet = 1;
+        }
+    }
+
+    return(iRet);
+}
@@ -0,0 +1,631 @@
+//*****************************************************************************
+//
+// hal_linux.c - Host implementation of the pipeline hardware access.
+//
+// The board is simulated.  Switch ports hold whatever levels were last set,
+// the trackball encoders count through 32 bits as the QEI modules do, and in
+// velocity mode capture their counts every velocity period as the QEI
+// interrupts would.  With INPUT_SAMPLE_HZ the switch ports are sampled into
+// a circular buffer every HAL_SAMPLE_US as time moves, as uDMA does on the
+// board.  The settings store is kept in memory and, like the
+// EEPROM, keeps its contents across HALInit().  Time only moves when told to
+// and each report channel queues
+// reports the way the Mame HID driver does: one report in flight, up to
+// HAL_SIM_TX_SLOTS more waiting, and a queued report replaced by a newer one
+// with the same ID.  Nothing runs as an interrupt, so holding them off does
+// nothing.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "usblib/device/usbdhidmamecfg.h"
+#include "hal.h"
+#include "debounce.h"
+#include "mousemotion.h"
+#include "softquad.h"
+#include "analog.h"
+#include "pipeline.h"
+#include "hal_linux.h"
+
+//*****************************************************************************
+//
+// One queued or in flight report.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t pui8Data[HAL_SIM_REPORT_MAX];
+    uint32_t ui32Size;
+}
+tHALSimReport;
+
+//*****************************************************************************
+//
+// One report channel.
+//
+//*****************************************************************************
+typedef struct
+{
+    tHALSimReport psQueue[HAL_SIM_TX_SLOTS];
+    uint32_t ui32Read;
+    uint32_t ui32Count;
+    tHALSimReport sInFlight;
+    bool bInFlight;
+}
+tHALSimChannel;
+
+//*****************************************************************************
+//
+// The simulated board.
+//
+//*****************************************************************************
+static uint32_t g_ui32SimTime;
+static uint8_t g_pui8SimPorts[HAL_NUM_PORTS];
+static uint32_t g_pui32SimQEI[2];
+static uint16_t g_pui16SimAnalog[4];
+static uint32_t g_ui32SimAnalogBlock;
+#if MOUSE_VELOCITY_ENABLE
+static uint32_t g_pui32SimQEICaptured[2];
+static uint32_t g_ui32SimVelocityNext;
+#endif
+#if INPUT_SAMPLE_HZ
+static uint8_t g_ppui8SimSamples[HAL_NUM_PORTS][HAL_SAMPLE_SLOTS];
+static uint32_t g_ui32SimSampleWrite;
+static uint32_t g_ui32SimSampleRead;
+static uint32_t g_ui32SimSampleNext;
+#endif
+static bool g_bSimConfigured;
+static tHALSimChannel g_psSimChannels[HAL_SIM_CHANNELS];
+static tHALSimReportFn g_pfnSimReport;
+static uint32_t g_ui32SimRefused;
+static uint32_t g_ui32SimWakeups;
+static uint32_t g_pui32SimConfig[HAL_CONFIG_SIZE / 4];
+static bool g_bSimConfigErased;
+
+//*****************************************************************************
+//
+// Returns the size, including the ID, of an input report.
+//
+//*****************************************************************************
+static uint32_t
+HALSimReportSize(uint8_t ui8ReportID)
+{
+    switch(ui8ReportID)
+    {
+        case 1:
+        {
+            return(4);
+        }
+        case 2:
+        {
+            return(3);
+        }
+        case CUSTOMHID_REPORT_ID_MOUSE:
+        {
+            return(CUSTOMHID_MOUSE_SIZE + 1);
+        }
+        case CUSTOMHID_REPORT_ID_ANALOG:
+        {
+            return(CUSTOMHID_ANALOG_SIZE + 1);
+        }
+        default:
+        {
+            return(CUSTOMHID_COMBINED_SIZE + 1);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Moves the oldest queued report of a channel onto the wire if nothing else
+// is in flight.
+//
+//*****************************************************************************
+static void
+HALSimTxNext(tHALSimChannel *psChannel)
+{
+    if(psChannel->bInFlight || !psChannel->ui32Count)
+    {
+        return;
+    }
+
+    psChannel->sInFlight = psChannel->psQueue[psChannel->ui32Read];
+    psChannel->ui32Read = (psChannel->ui32Read + 1) % HAL_SIM_TX_SLOTS;
+    psChannel->ui32Count--;
+    psChannel->bInFlight = true;
+}
+
+//*****************************************************************************
+//
+// Ends every velocity capture period up to the current time, handing the
+// counts of each to the motion smoothing as the QEI interrupts do.
+//
+//*****************************************************************************
+static void
+HALSimVelocityRun(void)
+{
+#if MOUSE_VELOCITY_ENABLE
+    uint32_t ui32Idx;
+
+    while((int32_t)(g_ui32SimTime - g_ui32SimVelocityNext) >= 0)
+    {
+        for(ui32Idx = HAL_QEI_X; ui32Idx <= HAL_QEI_Y; ui32Idx++)
+        {
+            MouseVelocitySample(ui32Idx,
+                                (int32_t)(g_pui32SimQEI[ui32Idx] -
+                                          g_pui32SimQEICaptured[ui32Idx]));
+            g_pui32SimQEICaptured[ui32Idx] = g_pui32SimQEI[ui32Idx];
+        }
+        g_ui32SimVelocityNext += HAL_SIM_VELOCITY_US;
+    }
+#endif
+}
+
+//*****************************************************************************
+//
+// Takes every switch sample due up to and including a time.  The ports hold
+// the levels they have had since time last moved.
+//
+//*****************************************************************************
+static void
+HALSimSampleRun(uint32_t ui32Until)
+{
+#if INPUT_SAMPLE_HZ
+    uint32_t ui32Port, ui32Slot;
+
+    while((int32_t)(ui32Until - g_ui32SimSampleNext) >= 0)
+    {
+        ui32Slot = g_ui32SimSampleWrite % HAL_SAMPLE_SLOTS;
+        for(ui32Port = 0; ui32Port < HAL_NUM_PORTS; ui32Port++)
+        {
+            g_ppui8SimSamples[ui32Port][ui32Slot] = g_pui8SimPorts[ui32Port];
+        }
+        g_ui32SimSampleWrite++;
+        g_ui32SimSampleNext += HAL_SAMPLE_US;
+    }
+#else
+    (void)ui32Until;
+#endif
+}
+
+//*****************************************************************************
+//
+// Resets the simulated board.  Every switch is open, so reads high, both
+// encoders sit at 0, the analog inputs at mid travel, time is 0 and the host
+// has not configured the device.
+//
+//*****************************************************************************
+void
+HALInit(uint32_t ui32SysClock)
+{
+    uint32_t ui32Idx;
+
+    (void)ui32SysClock;
+
+    g_ui32SimTime = 0;
+    for(ui32Idx = 0; ui32Idx < HAL_NUM_PORTS; ui32Idx++)
+    {
+        g_pui8SimPorts[ui32Idx] = 0xFF;
+    }
+    g_pui32SimQEI[HAL_QEI_X] = 0;
+    g_pui32SimQEI[HAL_QEI_Y] = 0;
+    for(ui32Idx = 0; ui32Idx < 4; ui32Idx++)
+    {
+        g_pui16SimAnalog[ui32Idx] = 2048;
+    }
+    g_ui32SimAnalogBlock = 0;
+#if MOUSE_VELOCITY_ENABLE
+    g_pui32SimQEICaptured[HAL_QEI_X] = 0;
+    g_pui32SimQEICaptured[HAL_QEI_Y] = 0;
+    g_ui32SimVelocityNext = HAL_SIM_VELOCITY_US;
+#endif
+#if INPUT_SAMPLE_HZ
+    g_ui32SimSampleWrite = 0;
+    g_ui32SimSampleRead = 0;
+    g_ui32SimSampleNext = 0;
+#endif
+    g_bSimConfigured = false;
+    memset(g_psSimChannels, 0, sizeof(g_psSimChannels));
+    g_ui32SimRefused = 0;
+    g_ui32SimWakeups = 0;
+    if(!g_bSimConfigErased)
+    {
+        HALSimConfigErase();
+    }
+}
+
+uint32_t
+HALTimeGet(void)
+{
+    return(g_ui32SimTime);
+}
+
+uint8_t
+HALGPIORead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    return(g_pui8SimPorts[ui32Port] & ui8Pins);
+}
+
+void
+HALGPIOScan(uint8_t *pui8Levels)
+{
+    memcpy(pui8Levels, g_pui8SimPorts, HAL_NUM_PORTS);
+}
+
+#if INPUT_SAMPLE_HZ
+//*****************************************************************************
+//
+// Hands over the switch samples taken since the last call.  As on the board,
+// a reader that lets the whole buffer fill loses it and is given nothing.
+//
+//*****************************************************************************
+uint32_t
+HALGPIOSamplesGet(const uint8_t **ppui8Samples, uint32_t *pui32Slot)
+{
+    uint32_t ui32Port, ui32Count;
+
+    HALSimSampleRun(g_ui32SimTime);
+
+    ui32Count = g_ui32SimSampleWrite - g_ui32SimSampleRead;
+    if(ui32Count >= HAL_SAMPLE_SLOTS)
+    {
+        g_ui32SimSampleRead = g_ui32SimSampleWrite;
+        return(0);
+    }
+
+    for(ui32Port = 0; ui32Port < HAL_NUM_PORTS; ui32Port++)
+    {
+        ppui8Samples[ui32Port] = g_ppui8SimSamples[ui32Port];
+    }
+    *pui32Slot = g_ui32SimSampleRead % HAL_SAMPLE_SLOTS;
+    g_ui32SimSampleRead = g_ui32SimSampleWrite;
+
+    return(ui32Count);
+}
+#endif
+
+uint32_t
+HALQEIPositionGet(uint32_t ui32Encoder)
+{
+    return(g_pui32SimQEI[ui32Encoder]);
+}
+
+#if CUSTOMHID_ANALOG_AXES
+//*****************************************************************************
+//
+// The ADC completes a block every HAL_SIM_ANALOG_US.  The simulation does
+// not model the averaging, so each block reads the inputs as they are now.
+//
+//*****************************************************************************
+bool
+HALAnalogRead(uint16_t *pui16Raw)
+{
+    uint32_t ui32Axis;
+
+    if((g_ui32SimTime - g_ui32SimAnalogBlock) < HAL_SIM_ANALOG_US)
+    {
+        return(false);
+    }
+    g_ui32SimAnalogBlock = g_ui32SimTime -
+                           ((g_ui32SimTime - g_ui32SimAnalogBlock) %
+                            HAL_SIM_ANALOG_US);
+
+    for(ui32Axis = 0; ui32Axis < CUSTOMHID_ANALOG_AXES; ui32Axis++)
+    {
+        pui16Raw[ui32Axis] = g_pui16SimAnalog[ui32Axis];
+    }
+    return(true);
+}
+#endif
+
+uint32_t
+HALReportChannel(uint8_t ui8ReportID)
+{
+#if CUSTOMHID_COMPOSITE
+    if(ui8ReportID == 1)
+    {
+        return(CUSTOMHID_IFACE_PAD1);
+    }
+    else if((ui8ReportID == 2) ||
+            (ui8ReportID == CUSTOMHID_REPORT_ID_ANALOG))
+    {
+        return(CUSTOMHID_IFACE_PAD2);
+    }
+    return(CUSTOMHID_IFACE_MOUSE);
+#else
+    (void)ui8ReportID;
+    return(CUSTOMHID_IFACE_ALL);
+#endif
+}
+
+bool
+HALReportIdle(uint32_t ui32Channel)
+{
+    return(!g_psSimChannels[ui32Channel].bInFlight &&
+           !g_psSimChannels[ui32Channel].ui32Count);
+}
+
+bool
+HALReportQueued(uint32_t ui32Channel, uint8_t ui8ReportID)
+{
+    tHALSimChannel *psChannel;
+    uint32_t ui32Idx;
+
+    psChannel = &g_psSimChannels[ui32Channel];
+    for(ui32Idx = 0; ui32Idx < psChannel->ui32Count; ui32Idx++)
+    {
+        if(psChannel->psQueue[(psChannel->ui32Read + ui32Idx) %
+                              HAL_SIM_TX_SLOTS].pui8Data[0] == ui8ReportID)
+        {
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+bool
+HALReportSend(uint32_t ui32Channel, uint8_t ui8ReportID, signed char *pi8Data)
+{
+    tHALSimChannel *psChannel;
+    tHALSimReport *psReport;
+    uint32_t ui32Idx, ui32Slot;
+
+    if(!g_bSimConfigured)
+    {
+        g_ui32SimRefused++;
+        return(false);
+    }
+
+    //
+    // Replace a queued report with the same ID, otherwise take a free slot.
+    //
+    psChannel = &g_psSimChannels[ui32Channel];
+    for(ui32Idx = 0; ui32Idx < psChannel->ui32Count; ui32Idx++)
+    {
+        ui32Slot = (psChannel->ui32Read + ui32Idx) % HAL_SIM_TX_SLOTS;
+        if(psChannel->psQueue[ui32Slot].pui8Data[0] == ui8ReportID)
+        {
+            break;
+        }
+    }
+    if(ui32Idx == psChannel->ui32Count)
+    {
+        if(psChannel->ui32Count == HAL_SIM_TX_SLOTS)
+        {
+            g_ui32SimRefused++;
+            return(false);
+        }
+        psChannel->ui32Count++;
+    }
+
+    psReport = &psChannel->psQueue[(psChannel->ui32Read + ui32Idx) %
+                                   HAL_SIM_TX_SLOTS];
+    psReport->ui32Size = HALSimReportSize(ui8ReportID);
+    psReport->pui8Data[0] = ui8ReportID;
+    memcpy(&psReport->pui8Data[1], pi8Data, psReport->ui32Size - 1);
+
+    HALSimTxNext(psChannel);
+
+    return(true);
+}
+
+void
+HALRemoteWakeup(void)
+{
+    g_ui32SimWakeups++;
+}
+
+bool
+HALIntDisable(void)
+{
+    return(false);
+}
+
+void
+HALIntRestore(bool bWasDisabled)
+{
+}
+
+static bool
+HALSimConfigRange(uint32_t ui32Offset, uint32_t ui32Size)
+{
+    return(!(ui32Offset & 3) && !(ui32Size & 3) &&
+           (ui32Offset <= HAL_CONFIG_SIZE) &&
+           (ui32Size <= (HAL_CONFIG_SIZE - ui32Offset)));
+}
+
+bool
+HALConfigRead(uint32_t ui32Offset, uint32_t *pui32Data, uint32_t ui32Size)
+{
+    if(!HALSimConfigRange(ui32Offset, ui32Size))
+    {
+        return(false);
+    }
+
+    memcpy(pui32Data, &g_pui32SimConfig[ui32Offset / 4], ui32Size);
+    return(true);
+}
+
+bool
+HALConfigProgram(uint32_t ui32Offset, uint32_t ui32Data)
+{
+    if(!HALSimConfigRange(ui32Offset, 4))
+    {
+        return(false);
+    }
+
+    g_pui32SimConfig[ui32Offset / 4] = ui32Data;
+    return(true);
+}
+
+uint32_t
+HALConfigStatus(void)
+{
+    return(HAL_CONFIG_DONE);
+}
+
+//*****************************************************************************
+//
+// Sets the time, or moves it on by a number of microseconds.
+//
+//*****************************************************************************
+void
+HALSimTimeSet(uint32_t ui32Time)
+{
+    HALSimSampleRun(ui32Time - 1);
+    g_ui32SimTime = ui32Time;
+    HALSimVelocityRun();
+}
+
+void
+HALSimTimeAdvance(uint32_t ui32Us)
+{
+    HALSimSampleRun(g_ui32SimTime + ui32Us - 1);
+    g_ui32SimTime += ui32Us;
+    HALSimVelocityRun();
+}
+
+//*****************************************************************************
+//
+// Sets or returns the pin levels of a switch port.  A closed switch pulls its
+// pin low.  With CUSTOMHID_SPINNER every change is also passed to the
+// software quadrature decoder, as the port interrupt does on the board.
+//
+//*****************************************************************************
+void
+HALSimPortSet(uint32_t ui32Port, uint8_t ui8Level)
+{
+    g_pui8SimPorts[ui32Port] = ui8Level;
+#if CUSTOMHID_SPINNER
+    SoftQuadUpdate(ui32Port, ui8Level);
+#endif
+}
+
+uint8_t
+HALSimPortGet(uint32_t ui32Port)
+{
+    return(g_pui8SimPorts[ui32Port]);
+}
+
+//*****************************************************************************
+//
+// Turns a trackball encoder by a number of counts in either direction.
+//
+//*****************************************************************************
+void
+HALSimQEIMove(uint32_t ui32Encoder, int32_t i32Counts)
+{
+    g_pui32SimQEI[ui32Encoder] += i32Counts;
+}
+
+//*****************************************************************************
+//
+// Sets the raw 12 bit reading of an analog input.
+//
+//*****************************************************************************
+void
+HALSimAnalogSet(uint32_t ui32Axis, uint16_t ui16Raw)
+{
+    g_pui16SimAnalog[ui32Axis] = ui16Raw;
+}
+
+//*****************************************************************************
+//
+// Configures or unconfigures the device as the host would.  Unconfiguring
+// drops anything queued.
+//
+//*****************************************************************************
+void
+HALSimConfigure(bool bConfigured)
+{
+    g_bSimConfigured = bConfigured;
+    if(!bConfigured)
+    {
+        memset(g_psSimChannels, 0, sizeof(g_psSimChannels));
+    }
+}
+
+//*****************************************************************************
+//
+// Sets the function given each report the host receives.
+//
+//*****************************************************************************
+void
+HALSimReportCallbackSet(tHALSimReportFn pfnReport)
+{
+    g_pfnSimReport = pfnReport;
+}
+
+//*****************************************************************************
+//
+// Polls a channel's endpoint as the host would once a frame.  Any report in
+// flight is received and acknowledged and the next queued report goes out.
+// Returns true if a report was received.
+//
+//*****************************************************************************
+bool
+HALSimHostPoll(uint32_t ui32Channel)
+{
+    tHALSimChannel *psChannel;
+
+    psChannel = &g_psSimChannels[ui32Channel];
+    if(!psChannel->bInFlight)
+    {
+        return(false);
+    }
+
+    psChannel->bInFlight = false;
+    if(g_pfnSimReport)
+    {
+        g_pfnSimReport(ui32Channel, psChannel->sInFlight.pui8Data,
+                       psChannel->sInFlight.ui32Size, g_ui32SimTime);
+    }
+    PipelineReportAcked(ui32Channel);
+    HALSimTxNext(psChannel);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Erases the settings store, as a board fresh from the factory would have.
+//
+//*****************************************************************************
+void
+HALSimConfigErase(void)
+{
+    memset(g_pui32SimConfig, 0xFF, sizeof(g_pui32SimConfig));
+    g_bSimConfigErased = true;
+}
+
+//*****************************************************************************
+//
+// Returns the reports waiting on a channel, not counting one in flight.
+//
+//*****************************************************************************
+uint32_t
+HALSimQueued(uint32_t ui32Channel)
+{
+    return(g_psSimChannels[ui32Channel].ui32Count);
+}
+
+//*****************************************************************************
+//
+// Returns the number of reports refused, and of remote wakeups requested,
+// since HALInit().
+//
+//*****************************************************************************
+uint32_t
+HALSimRefused(void)
+{
+    return(g_ui32SimRefused);
+}
+
+uint32_t
+HALSimWakeups(void)
+{
+    return(g_ui32SimWakeups);
+}
@@ -0,0 +1,71 @@
+//*****************************************************************************
+//
+// hal_linux.h - Controls for the simulated hardware of the host build.
+//
+// hal_linux.c implements hal.h over a simulated board.  A test or benchmark
+// drives the switch pins, trackball counts, analog inputs and microsecond
+// time through these calls, acts as the USB host by polling the report
+// channels, and is given every report the host receives through a callback.
+//
+//*****************************************************************************
+
+#ifndef __HAL_LINUX_H__
+#define __HAL_LINUX_H__
+
+//*****************************************************************************
+//
+// The number of report channels, the reports each channel queues before it
+// refuses more, and the largest report including its ID.  These follow the
+// HID driver.
+//
+//*****************************************************************************
+#define HAL_SIM_CHANNELS        3
+#define HAL_SIM_TX_SLOTS        4
+#define HAL_SIM_REPORT_MAX      (((CUSTOMHID_ANALOG_SIZE >                    \
+                                   CUSTOMHID_COMBINED_SIZE) ?                 \
+                                  CUSTOMHID_ANALOG_SIZE :                     \
+                                  CUSTOMHID_COMBINED_SIZE) + 1)
+
+//*****************************************************************************
+//
+// The velocity capture period of the simulated encoders in microseconds.
+//
+//*****************************************************************************
+#define HAL_SIM_VELOCITY_US     (1000000 / MOUSE_VELOCITY_HZ)
+
+//*****************************************************************************
+//
+// The time the simulated ADC takes to fill a block, in microseconds.
+//
+//*****************************************************************************
+#define HAL_SIM_ANALOG_US       ((1000000 * ANALOG_BLOCK) / ANALOG_SAMPLE_HZ)
+
+//*****************************************************************************
+//
+// The function called for each report the simulated host receives.  pui8Report
+// starts with the report ID and is ui32Size bytes long.
+//
+//*****************************************************************************
+typedef void (*tHALSimReportFn)(uint32_t ui32Channel, const uint8_t *pui8Report,
+                                uint32_t ui32Size, uint32_t ui32Time);
+
+//*****************************************************************************
+//
+// Prototypes for the simulation controls.
+//
+//*****************************************************************************
+extern void HALSimTimeSet(uint32_t ui32Time);
+extern void HALSimTimeAdvance(uint32_t ui32Us);
+extern void HALSimPortSet(uint32_t ui32Port, uint8_t ui8Level);
+extern uint8_t HALSimPortGet(uint32_t ui32Port);
+extern void HALSimQEIMove(uint32_t ui32Encoder, int32_t i32Counts);
+extern void HALSimAnalogSet(uint32_t ui32Axis, uint16_t ui16Raw);
+extern void HALSimConfigure(bool bConfigured);
+extern void HALSimReportCallbackSet(tHALSimReportFn pfnReport);
+extern bool HALSimHostPoll(uint32_t ui32Channel);
+extern void HALSimConfigErase(void);
+extern uint32_t HALSimQueued(uint32_t ui32Channel);
+extern uint32_t HALSimRefused(void);
+extern uint32_t HALSimWakeups(void);
+
+#endif // __HAL_LINUX_H__
@@ -30,8 +30,9 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
-// This file was automatically generated by the Tiva C Series PinMux Utility
-// Version: 1.0.2
+// The pins were first set up by code from the Tiva C Series PinMux Utility
+// Version 1.0.2.  They are now set up from the pin map below, one masked
+// write of each register per port.
 //
 //*****************************************************************************
 
@@ -42,14 +43,65 @@
 #include "inc/hw_memmap.h"
 #include "inc/hw_gpio.h"
 #include "driverlib/sysctl.h"
-#include "driverlib/pin_map.h"
 #include "driverlib/rom_map.h"
-#include "driverlib/gpio.h"
+#include "hal.h"
+#include "debounce.h"
+#include "usblib/device/usbdhidmamecfg.h"
+#include "analog.h"
+#include "pipeline.h"
+
+//*****************************************************************************
+//
+// The use of the pins of one port.  Inputs are pulled up, outputs and
+// alternate function pins are plain push-pull, and analog pins have the
+// digital side turned off.  ui32PCTL holds the alternate function numbers of
+// the alternate function pins, four bits a pin.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Base;
+    uint8_t ui8Inputs;
+    uint8_t ui8Outputs;
+    uint8_t ui8Alternate;
+    uint8_t ui8Analog;
+    uint32_t ui32PCTL;
+}
+tPinMapPort;
+
+//*****************************************************************************
+//
+// The pin map.  The switch inputs of ports A-E come from the switch pin map in
+// pipeline.h.  The rest are the trackball encoders on QEI0 (PD6-7) and QEI1
+// (PC5-6), USB on PD4-5, the onboard button on PF4 and the RGB LED on PF1-3.
+//
+//*****************************************************************************
+static const tPinMapPort g_psPinMap[] =
+{
+    { GPIO_PORTA_AHB_BASE, PINMAP_PINS(HAL_PORTA), 0x00, 0x00, 0x00,
+      0x00000000 },
+    { GPIO_PORTB_AHB_BASE, PINMAP_PINS(HAL_PORTB), 0x00, 0x00, 0x00,
+      0x00000000 },
+    { GPIO_PORTC_AHB_BASE, PINMAP_PINS(HAL_PORTC), 0x00, 0x60, 0x00,
+      0x06600000 },
+    { GPIO_PORTD_AHB_BASE, PINMAP_PINS(HAL_PORTD), 0x00, 0xC0, 0x30,
+      0x66000000 },
+    { GPIO_PORTE_AHB_BASE, PINMAP_PINS(HAL_PORTE), 0x00, 0x00, 0x00,
+      0x00000000 },
+    { GPIO_PORTF_AHB_BASE, 0x10, 0x0E, 0x00, 0x00,
+      0x00000000 }
+};
+
+#define PINMAP_NUM_PORTS        (sizeof(g_psPinMap) / sizeof(g_psPinMap[0]))
 
 //*****************************************************************************
 void
 PortFunctionInit(void)
 {
+    const tPinMapPort *psPort;
+    uint32_t ui32Idx, ui32Base, ui32PCTLMask, ui32Pin;
+    uint8_t ui8Pins;
+
     //
     // Enable Peripheral Clocks 
     //
@@ -63,270 +115,60 @@ PortFunctionInit(void)
     MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
 
     //
-    // Enable port PA1 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTA_BASE, GPIO_PIN_1);
-    MAP_GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_1, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PA2 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTA_BASE, GPIO_PIN_2);
-    MAP_GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_2, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PA4 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTA_BASE, GPIO_PIN_4);
-    MAP_GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_4, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PA7 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTA_BASE, GPIO_PIN_7);
-    MAP_GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_7, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PA6 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTA_BASE, GPIO_PIN_6);
-    MAP_GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_6, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PA5 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTA_BASE, GPIO_PIN_5);
-    MAP_GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_5, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PA0 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTA_BASE, GPIO_PIN_0);
-    MAP_GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_0, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PA3 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTA_BASE, GPIO_PIN_3);
-    MAP_GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_3, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PB5 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTB_BASE, GPIO_PIN_5);
-    MAP_GPIOPadConfigSet(GPIO_PORTB_BASE, GPIO_PIN_5, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PB2 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTB_BASE, GPIO_PIN_2);
-    MAP_GPIOPadConfigSet(GPIO_PORTB_BASE, GPIO_PIN_2, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PB7 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTB_BASE, GPIO_PIN_7);
-    MAP_GPIOPadConfigSet(GPIO_PORTB_BASE, GPIO_PIN_7, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PB4 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTB_BASE, GPIO_PIN_4);
-    MAP_GPIOPadConfigSet(GPIO_PORTB_BASE, GPIO_PIN_4, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PB3 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTB_BASE, GPIO_PIN_3);
-    MAP_GPIOPadConfigSet(GPIO_PORTB_BASE, GPIO_PIN_3, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PB1 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTB_BASE, GPIO_PIN_1);
-    MAP_GPIOPadConfigSet(GPIO_PORTB_BASE, GPIO_PIN_1, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PB6 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTB_BASE, GPIO_PIN_6);
-    MAP_GPIOPadConfigSet(GPIO_PORTB_BASE, GPIO_PIN_6, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PB0 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTB_BASE, GPIO_PIN_0);
-    MAP_GPIOPadConfigSet(GPIO_PORTB_BASE, GPIO_PIN_0, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PC1 for GPIOInput
-    //
-
-    //
-    //First open the lock and select the bits we want to modify in the GPIO commit register.
-    //
-    HWREG(GPIO_PORTC_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-    HWREG(GPIO_PORTC_BASE + GPIO_O_CR) = 0x2;
-
-    //
-    //Now modify the configuration of the pins that we unlocked.
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTC_BASE, GPIO_PIN_1);
-    MAP_GPIOPadConfigSet(GPIO_PORTC_BASE, GPIO_PIN_1, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PC3 for GPIOInput
-    //
-
-    //
-    //First open the lock and select the bits we want to modify in the GPIO commit register.
-    //
-    HWREG(GPIO_PORTC_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-    HWREG(GPIO_PORTC_BASE + GPIO_O_CR) = 0x8;
-
-    //
-    //Now modify the configuration of the pins that we unlocked.
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTC_BASE, GPIO_PIN_3);
-    MAP_GPIOPadConfigSet(GPIO_PORTC_BASE, GPIO_PIN_3, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PC0 for GPIOInput
-    //
-
-    //
-    //First open the lock and select the bits we want to modify in the GPIO commit register.
-    //
-    HWREG(GPIO_PORTC_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-    HWREG(GPIO_PORTC_BASE + GPIO_O_CR) = 0x1;
-
-    //
-    //Now modify the configuration of the pins that we unlocked.
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTC_BASE, GPIO_PIN_0);
-    MAP_GPIOPadConfigSet(GPIO_PORTC_BASE, GPIO_PIN_0, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PC2 for GPIOInput
-    //
-
-    //
-    //First open the lock and select the bits we want to modify in the GPIO commit register.
-    //
-    HWREG(GPIO_PORTC_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-    HWREG(GPIO_PORTC_BASE + GPIO_O_CR) = 0x4;
-
-    //
-    //Now modify the configuration of the pins that we unlocked.
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTC_BASE, GPIO_PIN_2);
-    MAP_GPIOPadConfigSet(GPIO_PORTC_BASE, GPIO_PIN_2, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PD3 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTD_BASE, GPIO_PIN_3);
-    MAP_GPIOPadConfigSet(GPIO_PORTD_BASE, GPIO_PIN_3, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PD1 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTD_BASE, GPIO_PIN_1);
-    MAP_GPIOPadConfigSet(GPIO_PORTD_BASE, GPIO_PIN_1, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PD2 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTD_BASE, GPIO_PIN_2);
-    MAP_GPIOPadConfigSet(GPIO_PORTD_BASE, GPIO_PIN_2, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PD0 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTD_BASE, GPIO_PIN_0);
-    MAP_GPIOPadConfigSet(GPIO_PORTD_BASE, GPIO_PIN_0, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PE1 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTE_BASE, GPIO_PIN_1);
-    MAP_GPIOPadConfigSet(GPIO_PORTE_BASE, GPIO_PIN_1, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PE2 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTE_BASE, GPIO_PIN_2);
-    MAP_GPIOPadConfigSet(GPIO_PORTE_BASE, GPIO_PIN_2, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PE5 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTE_BASE, GPIO_PIN_5);
-    MAP_GPIOPadConfigSet(GPIO_PORTE_BASE, GPIO_PIN_5, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PE3 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTE_BASE, GPIO_PIN_3);
-    MAP_GPIOPadConfigSet(GPIO_PORTE_BASE, GPIO_PIN_3, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PE0 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTE_BASE, GPIO_PIN_0);
-    MAP_GPIOPadConfigSet(GPIO_PORTE_BASE, GPIO_PIN_0, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    //
-    // Enable port PE4 for GPIOInput
-    //
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTE_BASE, GPIO_PIN_4);
-    MAP_GPIOPadConfigSet(GPIO_PORTE_BASE, GPIO_PIN_4, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    // Enable Left Button
-    MAP_GPIOPinTypeGPIOInput(GPIO_PORTF_BASE,GPIO_PIN_4);
-    MAP_GPIOPadConfigSet(GPIO_PORTF_BASE, GPIO_PIN_4, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
-
-    // Enable Output Status Light
-    MAP_GPIOPinTypeGPIOOutput(GPIO_PORTF_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3);
-
-    //
-    // Enable port PD6 for QEI0 PHA0
-    //
-    MAP_GPIOPinConfigure(GPIO_PD6_PHA0);
-    MAP_GPIOPinTypeQEI(GPIO_PORTD_BASE, GPIO_PIN_6);
-
-    //
-    // Enable port PD7 for QEI0 PHB0
-    // First open the lock and select the bits we want to modify in the GPIO commit register.
-    //
-    HWREG(GPIO_PORTD_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-    HWREG(GPIO_PORTD_BASE + GPIO_O_CR) = 0x80;
-
-    //
-    // Now modify the configuration of the pins that we unlocked.
-    //
-    MAP_GPIOPinConfigure(GPIO_PD7_PHB0);
-    MAP_GPIOPinTypeQEI(GPIO_PORTD_BASE, GPIO_PIN_7);
-
-    //
-    // Enable port PC5 for QEI1 PHA1
-    //
-    MAP_GPIOPinConfigure(GPIO_PC5_PHA1);
-    MAP_GPIOPinTypeQEI(GPIO_PORTC_BASE, GPIO_PIN_5);
-
-    //
-    // Enable port PC6 for QEI1 PHB1
-    //
-    MAP_GPIOPinConfigure(GPIO_PC6_PHB1);
-    MAP_GPIOPinTypeQEI(GPIO_PORTC_BASE, GPIO_PIN_6);
-
-    //
-    // Enable port PD5 for USB0 USB0DP
-    //
-    MAP_GPIOPinTypeUSBAnalog(GPIO_PORTD_BASE, GPIO_PIN_5);
-
-    //
-    // Enable port PD4 for USB0 USB0DM
-    //
-    MAP_GPIOPinTypeUSBAnalog(GPIO_PORTD_BASE, GPIO_PIN_4);
+    // Move ports A-F onto the AHB aperture, which takes a load in one bus
+    // cycle rather than two or more through APB.  Once moved a port no longer
+    // answers at its APB address, so every access uses GPIO_PORTx_AHB_BASE.
+    //
+    MAP_SysCtlGPIOAHBEnable(SYSCTL_PERIPH_GPIOA);
+    MAP_SysCtlGPIOAHBEnable(SYSCTL_PERIPH_GPIOB);
+    MAP_SysCtlGPIOAHBEnable(SYSCTL_PERIPH_GPIOC);
+    MAP_SysCtlGPIOAHBEnable(SYSCTL_PERIPH_GPIOD);
+    MAP_SysCtlGPIOAHBEnable(SYSCTL_PERIPH_GPIOE);
+    MAP_SysCtlGPIOAHBEnable(SYSCTL_PERIPH_GPIOF);
+
+    for(ui32Idx = 0; ui32Idx < PINMAP_NUM_PORTS; ui32Idx++)
+    {
+        psPort = &g_psPinMap[ui32Idx];
+        ui32Base = psPort->ui32Base;
+        ui8Pins = (psPort->ui8Inputs | psPort->ui8Outputs |
+                   psPort->ui8Alternate | psPort->ui8Analog);
+
+        ui32PCTLMask = 0;
+        for(ui32Pin = 0; ui32Pin < 8; ui32Pin++)
+        {
+            if(psPort->ui8Alternate & (1 << ui32Pin))
+            {
+                ui32PCTLMask |= 0xF << (ui32Pin * 4);
+            }
+        }
+
+        //
+        // PC0-3 (JTAG) and PD7 (NMI) are locked.  Open the lock and commit
+        // every pin in the map, which has no effect on unlocked pins.
+        //
+        HWREG(ui32Base + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+        HWREG(ui32Base + GPIO_O_CR) = ui8Pins;
+
+        //
+        // Each register is written once for the whole port, leaving the
+        // pins that are not in the map alone.  Every pin keeps its reset
+        // drive strength of 2mA.
+        //
+        HWREG(ui32Base + GPIO_O_DIR) =
+            (HWREG(ui32Base + GPIO_O_DIR) & ~ui8Pins) | psPort->ui8Outputs;
+        HWREG(ui32Base + GPIO_O_AFSEL) =
+            (HWREG(ui32Base + GPIO_O_AFSEL) & ~ui8Pins) | psPort->ui8Alternate;
+        HWREG(ui32Base + GPIO_O_PCTL) =
+            (HWREG(ui32Base + GPIO_O_PCTL) & ~ui32PCTLMask) | psPort->ui32PCTL;
+        HWREG(ui32Base + GPIO_O_PUR) =
+            (HWREG(ui32Base + GPIO_O_PUR) & ~ui8Pins) | psPort->ui8Inputs;
+        HWREG(ui32Base + GPIO_O_PDR) &= ~ui8Pins;
+        HWREG(ui32Base + GPIO_O_AMSEL) =
+            (HWREG(ui32Base + GPIO_O_AMSEL) & ~ui8Pins) | psPort->ui8Analog;
+        HWREG(ui32Base + GPIO_O_DEN) =
+            ((HWREG(ui32Base + GPIO_O_DEN) & ~ui8Pins) |
+             (ui8Pins & ~psPort->ui8Analog));
+
+        HWREG(ui32Base + GPIO_O_LOCK) = 0;
+    }
 }
@@ -30,8 +30,7 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
-// This file was automatically generated by the Tiva C Series PinMux Utility
-// Version: 1.0.2
+// PortFunctionInit() sets up every pin used from the pin map in Mame_pins.c.
 //
 //*****************************************************************************
 
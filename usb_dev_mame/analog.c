@@ -0,0 +1,255 @@
+//*****************************************************************************
+//
+// analog.c - Analog inputs for pedals, steering wheels and paddles on the
+//            Mame control device.
+//
+// The HAL hands over one raw reading per axis each time the ADC has filled a
+// block, already averaged in hardware and across the block.  Each reading is
+// smoothed further, mapped through the calibration of its axis onto the
+// report range and held back by a little hysteresis, so that the host sees
+// the full travel of a worn pot without the last bit of noise.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usblib/device/usbdhidmamecfg.h"
+#include "hal.h"
+#include "analog.h"
+
+#if CUSTOMHID_ANALOG_AXES
+//*****************************************************************************
+//
+// The largest raw reading of the 12 bit ADC, and the middle of the report
+// range.
+//
+//*****************************************************************************
+#define ANALOG_RAW_MAX          4095
+#define ANALOG_MID              ((CUSTOMHID_ANALOG_MAX + 1) / 2)
+
+//*****************************************************************************
+//
+// The state of one axis.  i32Filtered is the smoothed raw reading in 24.8
+// fixed point and ui16Value the value last made reportable.
+//
+//*****************************************************************************
+typedef struct
+{
+    tAnalogCalibration sCal;
+    int32_t i32Filtered;
+    uint16_t ui16Value;
+    bool bPrimed;
+}
+tAnalogAxis;
+
+static tAnalogAxis g_psAnalogAxes[CUSTOMHID_ANALOG_AXES];
+
+//*****************************************************************************
+//
+// Maps a raw reading through the calibration of an axis onto 0 to
+// CUSTOMHID_ANALOG_MAX.
+//
+//*****************************************************************************
+static uint32_t
+AnalogCalibrate(const tAnalogCalibration *psCal, uint32_t ui32Raw)
+{
+    uint32_t ui32Low, ui32High;
+
+    ui32Low = psCal->ui16Center - psCal->ui16Deadzone;
+    ui32High = psCal->ui16Center + psCal->ui16Deadzone;
+
+    if(ui32Raw <= psCal->ui16Min)
+    {
+        return(0);
+    }
+    if(ui32Raw >= psCal->ui16Max)
+    {
+        return(CUSTOMHID_ANALOG_MAX);
+    }
+    if(ui32Raw < ui32Low)
+    {
+        return(((ui32Raw - psCal->ui16Min) * ANALOG_MID) /
+               (ui32Low - psCal->ui16Min));
+    }
+    if(ui32Raw > ui32High)
+    {
+        return(ANALOG_MID +
+               (((ui32Raw - ui32High) * (CUSTOMHID_ANALOG_MAX - ANALOG_MID)) /
+                (psCal->ui16Max - ui32High)));
+    }
+    return(ANALOG_MID);
+}
+
+//*****************************************************************************
+//
+// Sets every axis to the default calibration, the full ADC range with the
+// center in the middle, and reports the middle until the first reading.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+AnalogInit(void)
+{
+    uint32_t ui32Axis;
+
+    for(ui32Axis = 0; ui32Axis < CUSTOMHID_ANALOG_AXES; ui32Axis++)
+    {
+        g_psAnalogAxes[ui32Axis].sCal.ui16Min = 0;
+        g_psAnalogAxes[ui32Axis].sCal.ui16Center = (ANALOG_RAW_MAX + 1) / 2;
+        g_psAnalogAxes[ui32Axis].sCal.ui16Max = ANALOG_RAW_MAX;
+        g_psAnalogAxes[ui32Axis].sCal.ui16Deadzone = ANALOG_DEADZONE;
+        g_psAnalogAxes[ui32Axis].i32Filtered = 0;
+        g_psAnalogAxes[ui32Axis].ui16Value = ANALOG_MID;
+        g_psAnalogAxes[ui32Axis].bPrimed = false;
+    }
+}
+
+//*****************************************************************************
+//
+// Takes the latest readings from the HAL, if there are any, and updates the
+// value of each axis.
+//
+// \return Returns true if the value of any axis changed.
+//
+//*****************************************************************************
+bool
+AnalogUpdate(void)
+{
+    uint16_t pui16Raw[CUSTOMHID_ANALOG_AXES];
+    tAnalogAxis *psAxis;
+    uint32_t ui32Axis, ui32Value;
+    bool bChanged;
+
+    if(!HALAnalogRead(pui16Raw))
+    {
+        return(false);
+    }
+
+    bChanged = false;
+    for(ui32Axis = 0; ui32Axis < CUSTOMHID_ANALOG_AXES; ui32Axis++)
+    {
+        psAxis = &g_psAnalogAxes[ui32Axis];
+
+        //
+        // The first reading is taken as it is so the axis does not have to
+        // climb up from 0 at power up.
+        //
+        if(!psAxis->bPrimed)
+        {
+            psAxis->i32Filtered = (int32_t)pui16Raw[ui32Axis] << 8;
+            psAxis->bPrimed = true;
+        }
+        else
+        {
+            psAxis->i32Filtered +=
+                (((int32_t)pui16Raw[ui32Axis] << 8) - psAxis->i32Filtered) /
+                (1 << ANALOG_FILTER_SHIFT);
+        }
+
+        ui32Value = AnalogCalibrate(&psAxis->sCal,
+                                    (psAxis->i32Filtered + 128) >> 8);
+
+        //
+        // The ends of the range are always reached so a pedal at the stop
+        // reads as fully released or fully pressed.
+        //
+        if((ui32Value == psAxis->ui16Value) ||
+           ((ui32Value != 0) && (ui32Value != CUSTOMHID_ANALOG_MAX) &&
+            ((ui32Value + ANALOG_HYSTERESIS) >= psAxis->ui16Value) &&
+            (ui32Value <=
+             ((uint32_t)psAxis->ui16Value + ANALOG_HYSTERESIS))))
+        {
+            continue;
+        }
+        psAxis->ui16Value = ui32Value;
+        bChanged = true;
+    }
+
+    return(bChanged);
+}
+
+//*****************************************************************************
+//
+// Writes the value of every axis into an analog report, 16 bit little
+// endian.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+AnalogReportPack(signed char *pi8Report)
+{
+    uint32_t ui32Axis;
+
+    for(ui32Axis = 0; ui32Axis < CUSTOMHID_ANALOG_AXES; ui32Axis++)
+    {
+        *pi8Report++ = g_psAnalogAxes[ui32Axis].ui16Value;
+        *pi8Report++ = g_psAnalogAxes[ui32Axis].ui16Value >> 8;
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the filtered raw reading of an axis, for calibrating it.
+//
+//*****************************************************************************
+uint32_t
+AnalogRawGet(uint32_t ui32Axis)
+{
+    return((g_psAnalogAxes[ui32Axis].i32Filtered + 128) >> 8);
+}
+
+//*****************************************************************************
+//
+// Checks a calibration.  The dead zone must leave some travel either side of
+// the center.
+//
+// \param psCal is the calibration in raw ADC counts.
+//
+// \return Returns true if the calibration can be used.
+//
+//*****************************************************************************
+bool
+AnalogCalibrationValid(const tAnalogCalibration *psCal)
+{
+    return((psCal->ui16Max <= ANALOG_RAW_MAX) &&
+           ((uint32_t)psCal->ui16Min + psCal->ui16Deadzone <
+            psCal->ui16Center) &&
+           ((uint32_t)psCal->ui16Center + psCal->ui16Deadzone <
+            psCal->ui16Max));
+}
+
+//*****************************************************************************
+//
+// Sets the calibration of an axis.
+//
+// \param ui32Axis is the axis, from 0 to CUSTOMHID_ANALOG_AXES - 1.
+// \param psCal is the calibration in raw ADC counts.
+//
+// \return Returns true if the calibration was valid and is now in use.
+//
+//*****************************************************************************
+bool
+AnalogCalibrationSet(uint32_t ui32Axis, const tAnalogCalibration *psCal)
+{
+    if((ui32Axis >= CUSTOMHID_ANALOG_AXES) || !AnalogCalibrationValid(psCal))
+    {
+        return(false);
+    }
+
+    g_psAnalogAxes[ui32Axis].sCal = *psCal;
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns the calibration of an axis.
+//
+//*****************************************************************************
+void
+AnalogCalibrationGet(uint32_t ui32Axis, tAnalogCalibration *psCal)
+{
+    *psCal = g_psAnalogAxes[ui32Axis].sCal;
+}
+#endif
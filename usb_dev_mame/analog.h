@@ -0,0 +1,118 @@
+//*****************************************************************************
+//
+// analog.h - Analog inputs for pedals, steering wheels and paddles on the
+//            Mame control device.
+//
+//*****************************************************************************
+
+#ifndef __ANALOG_H__
+#define __ANALOG_H__
+
+//*****************************************************************************
+//
+// The analog inputs take the player two joystick pins, in the order PE2
+// (AIN1), PE3 (AIN0), PE4 (AIN9) and PE5 (AIN8), so that a driving or paddle
+// cabinet keeps every button.  These are the pins given over to them.
+//
+//*****************************************************************************
+#if CUSTOMHID_ANALOG_AXES == 4
+#define ANALOG_PORTE_PINS       0x3C
+#elif CUSTOMHID_ANALOG_AXES == 2
+#define ANALOG_PORTE_PINS       0x0C
+#elif CUSTOMHID_ANALOG_AXES == 1
+#define ANALOG_PORTE_PINS       0x04
+#else
+#define ANALOG_PORTE_PINS       0x00
+#endif
+
+//*****************************************************************************
+//
+// Sampling.  A timer starts a conversion of every input ANALOG_SAMPLE_HZ
+// times a second and the ADC averages ANALOG_OVERSAMPLE conversions of each
+// in hardware.  uDMA moves ANALOG_BLOCK of these sequences at a time into
+// one half of a double buffer, so the processor is only involved once a
+// block.  The defaults give a new block every millisecond.
+//
+//*****************************************************************************
+#ifndef ANALOG_SAMPLE_HZ
+#define ANALOG_SAMPLE_HZ        4000
+#endif
+
+#ifndef ANALOG_OVERSAMPLE
+#define ANALOG_OVERSAMPLE       16
+#endif
+
+#ifndef ANALOG_BLOCK
+#define ANALOG_BLOCK            4
+#endif
+
+#if (ANALOG_OVERSAMPLE != 0) && (ANALOG_OVERSAMPLE != 2) &&                   \
+    (ANALOG_OVERSAMPLE != 4) && (ANALOG_OVERSAMPLE != 8) &&                   \
+    (ANALOG_OVERSAMPLE != 16) && (ANALOG_OVERSAMPLE != 32) &&                 \
+    (ANALOG_OVERSAMPLE != 64)
+#error "ANALOG_OVERSAMPLE must be 0 or a power of two from 2 to 64"
+#endif
+
+#if (ANALOG_BLOCK < 1) || ((ANALOG_BLOCK * CUSTOMHID_ANALOG_AXES) > 1024)
+#error "ANALOG_BLOCK must be at least 1 and fit one uDMA transfer"
+#endif
+
+//*****************************************************************************
+//
+// Filtering.  Each new reading moves the filtered value
+// 1/2^ANALOG_FILTER_SHIFT of the way towards it, and a reported axis only
+// moves once the calibrated value is more than ANALOG_HYSTERESIS away from
+// it, so that a pot at rest does not flicker between neighbouring values.
+//
+//*****************************************************************************
+#ifndef ANALOG_FILTER_SHIFT
+#define ANALOG_FILTER_SHIFT     3
+#endif
+
+#ifndef ANALOG_HYSTERESIS
+#define ANALOG_HYSTERESIS       3
+#endif
+
+//*****************************************************************************
+//
+// The dead zone either side of the center of each axis, in raw ADC counts,
+// used until the axis is calibrated.  0 suits pedals, a steering wheel wants
+// a few counts.
+//
+//*****************************************************************************
+#ifndef ANALOG_DEADZONE
+#define ANALOG_DEADZONE         0
+#endif
+
+//*****************************************************************************
+//
+// The calibration of one axis in raw ADC counts.  ui16Min, ui16Center and
+// ui16Max report as 0, the middle and CUSTOMHID_ANALOG_MAX, with each side of
+// the center scaled separately.  Readings within ui16Deadzone of the center
+// report as the middle.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint16_t ui16Min;
+    uint16_t ui16Center;
+    uint16_t ui16Max;
+    uint16_t ui16Deadzone;
+}
+tAnalogCalibration;
+
+//*****************************************************************************
+//
+// Prototypes for the analog input functions.
+//
+//*****************************************************************************
+extern void AnalogInit(void);
+extern bool AnalogUpdate(void);
+extern void AnalogReportPack(signed char *pi8Report);
+extern uint32_t AnalogRawGet(uint32_t ui32Axis);
+extern bool AnalogCalibrationValid(const tAnalogCalibration *psCal);
+extern bool AnalogCalibrationSet(uint32_t ui32Axis,
+                                 const tAnalogCalibration *psCal);
+extern void AnalogCalibrationGet(uint32_t ui32Axis, tAnalogCalibration *psCal);
+
+#endif // __ANALOG_H__
@@ -0,0 +1,219 @@
+//*****************************************************************************
+//
+// buttonmap.c - Mapping of the switch inputs onto the report controls of the
+//               Mame control device.
+//
+// The debounced input word follows the wiring.  Before it is packed into
+// reports it is turned into a control word, one lookup per byte of the input
+// word in a table of 256 entries that gives the controls driven by every
+// combination of the eight inputs of that byte.  The tables are rebuilt
+// whenever the button map changes, so a remap costs nothing per report.
+//
+// There is a set of tables for each of BUTTON_MAP_SLOTS maps, built ahead of
+// time, so that changing to another map is one pointer store.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "buttonmap.h"
+
+//*****************************************************************************
+//
+// The number of bytes of the packed input word, each with its own table.
+//
+//*****************************************************************************
+#define BUTTON_MAP_TABLES       ((BUTTON_MAP_INPUTS + 7) / 8)
+
+#if BUTTON_MAP_TABLES != 4
+#error "ButtonMapApply() looks up exactly four bytes of the input word"
+#endif
+
+//*****************************************************************************
+//
+// The tables of every slot, 4KB each, and the tables of the slot in use.
+//
+//*****************************************************************************
+static uint32_t g_pppui32ButtonMapTable[BUTTON_MAP_SLOTS][BUTTON_MAP_TABLES]
+                                       [256];
+static uint32_t (* volatile g_ppui32ButtonMapActive)[256];
+
+//*****************************************************************************
+//
+// The hat fields for each combination of up, down, left and right: X in bits
+// 0-1 and Y in bits 2-3, each 2 bit two's complement from -1 to 1.  Opposite
+// directions held together cancel out.
+//
+//*****************************************************************************
+static const uint8_t g_pui8ButtonMapHat[16] =
+{
+    0x00, 0x0C, 0x04, 0x00, 0x03, 0x0F, 0x07, 0x03,
+    0x01, 0x0D, 0x05, 0x01, 0x00, 0x0C, 0x04, 0x00
+};
+
+//*****************************************************************************
+//
+// Rebuilds the lookup tables of a slot from a map.  Each entry is the entry
+// with its lowest input cleared plus the control of that input, so every
+// table takes one pass.
+//
+//*****************************************************************************
+static void
+ButtonMapBuild(uint32_t ui32Slot, const uint8_t *pui8Map)
+{
+    uint32_t ui32Table, ui32Value, ui32Bit, ui32Input, ui32Control;
+    uint32_t (*ppui32Table)[256];
+
+    ppui32Table = g_pppui32ButtonMapTable[ui32Slot];
+    for(ui32Table = 0; ui32Table < BUTTON_MAP_TABLES; ui32Table++)
+    {
+        ppui32Table[ui32Table][0] = 0;
+        for(ui32Value = 1; ui32Value < 256; ui32Value++)
+        {
+            for(ui32Bit = 0; !(ui32Value & (1 << ui32Bit)); ui32Bit++)
+            {
+            }
+            ui32Input = (ui32Table * 8) + ui32Bit;
+
+            ui32Control = 0;
+            if((ui32Input < BUTTON_MAP_INPUTS) &&
+               (pui8Map[ui32Input] != BUTTON_MAP_NONE))
+            {
+                ui32Control = 1 << pui8Map[ui32Input];
+            }
+
+            ppui32Table[ui32Table][ui32Value] =
+                (ppui32Table[ui32Table][ui32Value & (ui32Value - 1)] |
+                 ui32Control);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Sets up the default map, each input to the control of the same number, in
+// every slot and selects slot 0.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+ButtonMapInit(void)
+{
+    uint8_t pui8Map[BUTTON_MAP_INPUTS];
+    uint32_t ui32Input, ui32Slot;
+
+    for(ui32Input = 0; ui32Input < BUTTON_MAP_INPUTS; ui32Input++)
+    {
+        pui8Map[ui32Input] = ui32Input;
+    }
+    for(ui32Slot = 0; ui32Slot < BUTTON_MAP_SLOTS; ui32Slot++)
+    {
+        ButtonMapBuild(ui32Slot, pui8Map);
+    }
+    g_ppui32ButtonMapActive = g_pppui32ButtonMapTable[0];
+}
+
+//*****************************************************************************
+//
+// Checks a button map.
+//
+// \param pui8Map is the map, BUTTON_MAP_INPUTS entries.
+//
+// \return Returns true if every entry is a control below BUTTON_MAP_CONTROLS
+// or BUTTON_MAP_NONE.
+//
+//*****************************************************************************
+bool
+ButtonMapValid(const uint8_t *pui8Map)
+{
+    uint32_t ui32Input;
+
+    for(ui32Input = 0; ui32Input < BUTTON_MAP_INPUTS; ui32Input++)
+    {
+        if((pui8Map[ui32Input] >= BUTTON_MAP_CONTROLS) &&
+           (pui8Map[ui32Input] != BUTTON_MAP_NONE))
+        {
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Replaces the button map of a slot.
+//
+// \param ui32Slot is the slot, below BUTTON_MAP_SLOTS.
+// \param pui8Map is the new map, BUTTON_MAP_INPUTS entries each holding a
+// control below BUTTON_MAP_CONTROLS or BUTTON_MAP_NONE.
+//
+// The tables of the slot are rebuilt in place, which takes a few thousand
+// cycles, so the slot should not be the one in use while ButtonMapApply()
+// can run.
+//
+// \return Returns false, changing nothing, if any entry is out of range.
+//
+//*****************************************************************************
+bool
+ButtonMapSet(uint32_t ui32Slot, const uint8_t *pui8Map)
+{
+    if((ui32Slot >= BUTTON_MAP_SLOTS) || !ButtonMapValid(pui8Map))
+    {
+        return(false);
+    }
+
+    ButtonMapBuild(ui32Slot, pui8Map);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Changes to the map of another slot.  Its tables are already built, so this
+// is a single store and may be called from any context.
+//
+// \param ui32Slot is the slot, below BUTTON_MAP_SLOTS.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+ButtonMapSelect(uint32_t ui32Slot)
+{
+    if(ui32Slot < BUTTON_MAP_SLOTS)
+    {
+        g_ppui32ButtonMapActive = g_pppui32ButtonMapTable[ui32Slot];
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the control word for a packed input word.  The slot is read once,
+// so a ButtonMapSelect() part way through does not mix two maps.
+//
+//*****************************************************************************
+uint32_t
+ButtonMapApply(uint32_t ui32Inputs)
+{
+    uint32_t (*ppui32Table)[256];
+
+    ppui32Table = g_ppui32ButtonMapActive;
+    return(ppui32Table[0][ui32Inputs & 0xFF] |
+           ppui32Table[1][(ui32Inputs >> 8) & 0xFF] |
+           ppui32Table[2][(ui32Inputs >> 16) & 0xFF] |
+           ppui32Table[3][(ui32Inputs >> 24) & 0xFF]);
+}
+
+//*****************************************************************************
+//
+// Returns the X and Y hat fields for a D-pad, given its four direction bits
+// from the bottom of ui32Directions.
+//
+//*****************************************************************************
+uint8_t
+ButtonMapHat(uint32_t ui32Directions)
+{
+    return(g_pui8ButtonMapHat[ui32Directions & 0x0F]);
+}
@@ -0,0 +1,58 @@
+//*****************************************************************************
+//
+// buttonmap.h - Mapping of the switch inputs onto the report controls of the
+//               Mame control device.
+//
+//*****************************************************************************
+
+#ifndef __BUTTONMAP_H__
+#define __BUTTONMAP_H__
+
+//*****************************************************************************
+//
+// The controls of the reports, as bits of the control word the reports are
+// packed from.  Each D-pad is up, down, left and right from its lowest bit
+// and is sent as the X and Y fields of its hat.  Player one has buttons 1-12
+// and player two buttons 1-8.
+//
+//*****************************************************************************
+#define BUTTON_MAP_PAD1_DPAD_S  0
+#define BUTTON_MAP_PAD1_BTN1_S  4
+#define BUTTON_MAP_PAD2_DPAD_S  16
+#define BUTTON_MAP_PAD2_BTN1_S  20
+#define BUTTON_MAP_MOUSE_BTN_S  28
+#define BUTTON_MAP_CONTROLS     30
+
+//*****************************************************************************
+//
+// A button map holds one entry per bit of the packed input word, giving the
+// control that input drives or BUTTON_MAP_NONE.  Several inputs may drive
+// the same control.  The default map sends each input to the control of the
+// same number, so the D-pad pins are up, down, left and right in pin order.
+//
+//*****************************************************************************
+#define BUTTON_MAP_INPUTS       30
+#define BUTTON_MAP_NONE         0xFF
+
+//*****************************************************************************
+//
+// The number of maps held ready, one for each settings profile and a spare
+// that a new map is built in before it takes the place of an old one.  Each
+// takes 4KB of RAM for its lookup tables.
+//
+//*****************************************************************************
+#define BUTTON_MAP_SLOTS        5
+
+//*****************************************************************************
+//
+// Prototypes for the button map functions.
+//
+//*****************************************************************************
+extern void ButtonMapInit(void);
+extern bool ButtonMapValid(const uint8_t *pui8Map);
+extern bool ButtonMapSet(uint32_t ui32Slot, const uint8_t *pui8Map);
+extern void ButtonMapSelect(uint32_t ui32Slot);
+extern uint32_t ButtonMapApply(uint32_t ui32Inputs);
+extern uint8_t ButtonMapHat(uint32_t ui32Directions);
+
+#endif // __BUTTONMAP_H__
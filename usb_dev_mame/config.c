@@ -0,0 +1,383 @@
+//*****************************************************************************
+//
+// config.c - Persistent configuration store for the Mame control device.
+//
+// The settings that can be tuned at runtime, the settings profiles and the
+// one in use, and the analog calibration, are saved together as one
+// versioned record with a CRC-32.  Each module keeps its own settings in RAM.
+// ConfigInit() reads every slot once at boot and hands the newest good record
+// to the modules, and ConfigSave() gathers them back when one has changed.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usblib/device/usbdhidmamecfg.h"
+#include "hal.h"
+#include "debounce.h"
+#include "mousemotion.h"
+#include "analog.h"
+#include "buttonmap.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "config.h"
+
+//*****************************************************************************
+//
+// The number of profiles and analog calibrations the record has room for,
+// whatever the build uses.
+//
+//*****************************************************************************
+#define CONFIG_PROFILES         4
+#define CONFIG_ANALOG_AXES      4
+
+#if (PROFILE_COUNT > CONFIG_PROFILES) ||                                      \
+    (CUSTOMHID_ANALOG_AXES > CONFIG_ANALOG_AXES)
+#error "The configuration record is too small for this build"
+#endif
+
+//*****************************************************************************
+//
+// The record as saved in each slot, 228 bytes.  ui32Sequence counts up by
+// one with every save, and ui32CRC covers everything before it.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Magic;
+    uint16_t ui16Version;
+    uint16_t ui16Size;
+    uint32_t ui32Sequence;
+    uint8_t ui8Profile;
+    uint8_t pui8Reserved[3];
+    tProfile psProfiles[CONFIG_PROFILES];
+    tAnalogCalibration psAnalog[CONFIG_ANALOG_AXES];
+    uint32_t ui32CRC;
+}
+tConfig;
+
+//*****************************************************************************
+//
+// The trackball settings record saved at the start of the store by earlier
+// firmware.  It is taken over when there is no configuration record yet.
+//
+//*****************************************************************************
+#define CONFIG_MOUSE_MAGIC      0x4D430001
+
+typedef struct
+{
+    uint32_t ui32Magic;
+    uint16_t pui16Sensitivity[2];
+    uint32_t ui32Curve;
+}
+tConfigMouse;
+
+//*****************************************************************************
+//
+// The CRC-32 (IEEE 802.3) of each value of four bits, for working through a
+// record a nibble at a time.
+//
+//*****************************************************************************
+static const uint32_t g_pui32ConfigCRCTable[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+//*****************************************************************************
+//
+// The number of words in a record, and the value of g_ui32ConfigWord when no
+// save is being written.
+//
+//*****************************************************************************
+#define CONFIG_WORDS            (sizeof(tConfig) / sizeof(uint32_t))
+#define CONFIG_WORD_IDLE        0xFFFFFFFF
+
+//*****************************************************************************
+//
+// The slot and sequence number of the newest record, whether a setting has
+// changed since it was written and the time of the last change.  The flag
+// and time may be set from the USB interrupt.
+//
+//*****************************************************************************
+static uint32_t g_ui32ConfigSlot;
+static uint32_t g_ui32ConfigSequence;
+static volatile bool g_bConfigChanged;
+static volatile uint32_t g_ui32ConfigChangeTime;
+
+//*****************************************************************************
+//
+// The record being saved, the slot it is going to and the next word of it to
+// write, or CONFIG_WORD_IDLE.
+//
+//*****************************************************************************
+static tConfig g_sConfigSave;
+static uint32_t g_ui32ConfigSaveSlot;
+static uint32_t g_ui32ConfigWord;
+
+//*****************************************************************************
+//
+// Returns the CRC-32 of a record, up to its CRC.
+//
+//*****************************************************************************
+static uint32_t
+ConfigCRC(const tConfig *psConfig)
+{
+    const uint8_t *pui8Data;
+    uint32_t ui32CRC, ui32Idx;
+
+    pui8Data = (const uint8_t *)psConfig;
+    ui32CRC = 0xFFFFFFFF;
+    for(ui32Idx = 0; ui32Idx < (sizeof(tConfig) - sizeof(uint32_t)); ui32Idx++)
+    {
+        ui32CRC ^= pui8Data[ui32Idx];
+        ui32CRC = (ui32CRC >> 4) ^ g_pui32ConfigCRCTable[ui32CRC & 0x0F];
+        ui32CRC = (ui32CRC >> 4) ^ g_pui32ConfigCRCTable[ui32CRC & 0x0F];
+    }
+
+    return(~ui32CRC);
+}
+
+//*****************************************************************************
+//
+// Hands the settings in a record to the modules that use them.  Each setting
+// is checked on its own, so one bad profile or calibration does not throw
+// away the rest.
+//
+//*****************************************************************************
+static void
+ConfigApply(const tConfig *psConfig)
+{
+    uint32_t ui32Profile;
+#if CUSTOMHID_ANALOG_AXES
+    uint32_t ui32Axis;
+#endif
+
+    for(ui32Profile = 0; ui32Profile < PROFILE_COUNT; ui32Profile++)
+    {
+        ProfileSet(ui32Profile, &psConfig->psProfiles[ui32Profile]);
+    }
+    ProfileSelect(psConfig->ui8Profile);
+#if CUSTOMHID_ANALOG_AXES
+    for(ui32Axis = 0; ui32Axis < CUSTOMHID_ANALOG_AXES; ui32Axis++)
+    {
+        AnalogCalibrationSet(ui32Axis, &psConfig->psAnalog[ui32Axis]);
+    }
+#endif
+}
+
+//*****************************************************************************
+//
+// Fills a record with the settings in use.
+//
+//*****************************************************************************
+static void
+ConfigGather(tConfig *psConfig)
+{
+    uint32_t ui32Idx;
+
+    psConfig->ui8Profile = ProfileActiveGet();
+    psConfig->pui8Reserved[0] = 0;
+    psConfig->pui8Reserved[1] = 0;
+    psConfig->pui8Reserved[2] = 0;
+
+    //
+    // Any profiles the build does not use are saved as copies of profile 0.
+    //
+    for(ui32Idx = 0; ui32Idx < CONFIG_PROFILES; ui32Idx++)
+    {
+        ProfileGet((ui32Idx < PROFILE_COUNT) ? ui32Idx : 0,
+                   &psConfig->psProfiles[ui32Idx]);
+    }
+
+    for(ui32Idx = 0; ui32Idx < CONFIG_ANALOG_AXES; ui32Idx++)
+    {
+        psConfig->psAnalog[ui32Idx].ui16Min = 0;
+        psConfig->psAnalog[ui32Idx].ui16Center = 0;
+        psConfig->psAnalog[ui32Idx].ui16Max = 0;
+        psConfig->psAnalog[ui32Idx].ui16Deadzone = 0;
+    }
+#if CUSTOMHID_ANALOG_AXES
+    for(ui32Idx = 0; ui32Idx < CUSTOMHID_ANALOG_AXES; ui32Idx++)
+    {
+        AnalogCalibrationGet(ui32Idx, &psConfig->psAnalog[ui32Idx]);
+    }
+#endif
+}
+
+//*****************************************************************************
+//
+// Loads the saved configuration over the defaults.  Every slot is read once
+// and the newest record with a good CRC is applied.  With no record, the
+// trackball settings of earlier firmware are taken over if there are any,
+// and saved as a record by the next ConfigSave().  The modules must already
+// have set up their defaults.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+ConfigInit(void)
+{
+    tConfig sSlot, sNewest;
+    tConfigMouse sMouse;
+    uint32_t ui32Slot;
+    bool bFound;
+
+    //
+    // With no record the first save goes to slot 0.
+    //
+    g_ui32ConfigSlot = CONFIG_SLOTS - 1;
+    g_ui32ConfigSequence = 0;
+    g_bConfigChanged = false;
+    g_ui32ConfigWord = CONFIG_WORD_IDLE;
+    bFound = false;
+
+    for(ui32Slot = 0; ui32Slot < CONFIG_SLOTS; ui32Slot++)
+    {
+        if(!HALConfigRead(ui32Slot * CONFIG_SLOT_SIZE, (uint32_t *)&sSlot,
+                          sizeof(sSlot)))
+        {
+            return;
+        }
+
+        //
+        // The sequence numbers are compared by their difference so that the
+        // newest still wins after they wrap.
+        //
+        if((sSlot.ui32Magic != CONFIG_MAGIC) ||
+           (sSlot.ui16Version != CONFIG_VERSION) ||
+           (sSlot.ui16Size != sizeof(tConfig)) ||
+           (bFound &&
+            ((int32_t)(sSlot.ui32Sequence - g_ui32ConfigSequence) <= 0)) ||
+           (sSlot.ui32CRC != ConfigCRC(&sSlot)))
+        {
+            continue;
+        }
+
+        sNewest = sSlot;
+        g_ui32ConfigSlot = ui32Slot;
+        g_ui32ConfigSequence = sSlot.ui32Sequence;
+        bFound = true;
+    }
+
+    if(bFound)
+    {
+        ConfigApply(&sNewest);
+        g_bConfigChanged = false;
+    }
+    else if(HALConfigRead(0, (uint32_t *)&sMouse, sizeof(sMouse)) &&
+            (sMouse.ui32Magic == CONFIG_MOUSE_MAGIC))
+    {
+        MouseAccelCurveSet(sMouse.ui32Curve);
+        MouseSensitivitySet(0, sMouse.pui16Sensitivity[0]);
+        MouseSensitivitySet(1, sMouse.pui16Sensitivity[1]);
+        ConfigChanged();
+    }
+}
+
+//*****************************************************************************
+//
+// Notes that a setting has changed, to be saved by ConfigSave() once the
+// settings have been left alone for CONFIG_SAVE_DELAY_MS.  This may be called
+// from the USB interrupt.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+ConfigChanged(void)
+{
+    g_ui32ConfigChangeTime = HALTimeGet();
+    g_bConfigChanged = true;
+}
+
+//*****************************************************************************
+//
+// Saves the settings in use to the next slot if any has changed since the
+// last save and none for CONFIG_SAVE_DELAY_MS.  Programming a word of the
+// store can take milliseconds, so this is called on every pass of the main
+// loop and writes at most one word each time, returning at once while the
+// last is still being programmed.  A record takes tens of milliseconds to
+// write and the reports never wait on it.  The record in the slot before
+// stays good until the new one is complete, so a power loss part way through
+// falls back to the previous settings.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+ConfigSave(void)
+{
+    uint32_t ui32Status;
+
+    if(g_ui32ConfigWord == CONFIG_WORD_IDLE)
+    {
+        if(!g_bConfigChanged ||
+           ((HALTimeGet() - g_ui32ConfigChangeTime) <
+            (CONFIG_SAVE_DELAY_MS * 1000)))
+        {
+            return;
+        }
+
+        //
+        // Clear the flag first so that a change made while the store is
+        // being written is saved next time.  The record is gathered now, so
+        // the one written is wholly from this moment.
+        //
+        g_bConfigChanged = false;
+
+        g_sConfigSave.ui32Magic = CONFIG_MAGIC;
+        g_sConfigSave.ui16Version = CONFIG_VERSION;
+        g_sConfigSave.ui16Size = sizeof(tConfig);
+        g_sConfigSave.ui32Sequence = g_ui32ConfigSequence + 1;
+        ConfigGather(&g_sConfigSave);
+        g_sConfigSave.ui32CRC = ConfigCRC(&g_sConfigSave);
+
+        g_ui32ConfigSaveSlot = (g_ui32ConfigSlot + 1) % CONFIG_SLOTS;
+        g_ui32ConfigWord = 0;
+    }
+    else
+    {
+        //
+        // Wait for the last word, and give up on the record if it failed.
+        // The slot before is still the newest, and the settings are saved
+        // again after the delay.
+        //
+        ui32Status = HALConfigStatus();
+        if(ui32Status == HAL_CONFIG_BUSY)
+        {
+            return;
+        }
+        if(ui32Status == HAL_CONFIG_FAILED)
+        {
+            g_ui32ConfigWord = CONFIG_WORD_IDLE;
+            ConfigChanged();
+            return;
+        }
+    }
+
+    //
+    // The CRC is the last word written, so the slot only holds a good record
+    // once every word is in.
+    //
+    if(g_ui32ConfigWord == CONFIG_WORDS)
+    {
+        g_ui32ConfigSlot = g_ui32ConfigSaveSlot;
+        g_ui32ConfigSequence = g_sConfigSave.ui32Sequence;
+        g_ui32ConfigWord = CONFIG_WORD_IDLE;
+        return;
+    }
+
+    if(!HALConfigProgram((g_ui32ConfigSaveSlot * CONFIG_SLOT_SIZE) +
+                         (g_ui32ConfigWord * sizeof(uint32_t)),
+                         ((const uint32_t *)&g_sConfigSave)[g_ui32ConfigWord]))
+    {
+        g_ui32ConfigWord = CONFIG_WORD_IDLE;
+        ConfigChanged();
+        return;
+    }
+    g_ui32ConfigWord++;
+}
@@ -0,0 +1,57 @@
+//*****************************************************************************
+//
+// config.h - Persistent configuration store for the Mame control device.
+//
+//*****************************************************************************
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+//*****************************************************************************
+//
+// The configuration is saved as one record in each of CONFIG_SLOTS slots of
+// CONFIG_SLOT_SIZE bytes at the start of the HAL settings store.  Every save
+// goes to the slot after the last one written, so that the writes are spread
+// over all of them, and the newest record with a good CRC is loaded at boot.
+// The slots fill the whole store.
+//
+//*****************************************************************************
+#define CONFIG_SLOT_SIZE        256
+#define CONFIG_SLOTS            8
+#define CONFIG_STORE_SIZE       (CONFIG_SLOT_SIZE * CONFIG_SLOTS)
+
+#if CONFIG_STORE_SIZE > HAL_CONFIG_SIZE
+#error "The configuration slots do not fit in the HAL settings store"
+#endif
+
+//*****************************************************************************
+//
+// The format of the record.  CONFIG_MAGIC marks a record and CONFIG_VERSION
+// changes whenever its layout does, so that a record from other firmware is
+// ignored and the defaults used instead.
+//
+//*****************************************************************************
+#define CONFIG_MAGIC            0x4746434D
+#define CONFIG_VERSION          2
+
+//*****************************************************************************
+//
+// How long the settings must be left alone before a change is saved.  A run
+// of changes, such as stepping through the profiles with the hotkey, is
+// saved once as a single record when it ends.
+//
+//*****************************************************************************
+#ifndef CONFIG_SAVE_DELAY_MS
+#define CONFIG_SAVE_DELAY_MS    2000
+#endif
+
+//*****************************************************************************
+//
+// Prototypes for the configuration store functions.
+//
+//*****************************************************************************
+extern void ConfigInit(void);
+extern void ConfigChanged(void);
+extern void ConfigSave(void);
+
+#endif // __CONFIG_H__
@@ -0,0 +1,179 @@
+//*****************************************************************************
+//
+// cycleprofile.c - Cycle counts of the interrupt and main loop hot paths.
+//
+// Each timed section keeps a count, minimum, maximum and running total of the
+// cycles it took, read from the free running DWT cycle counter.  The host
+// reads them through a vendor feature report on the HID interface, so worst
+// case execution times can be checked on a working cabinet.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usblib/device/usbdhidmamecfg.h"
+#include "cycleprofile.h"
+
+#if CYCLE_PROFILE_ENABLE
+
+#if CYCLE_PROFILE_REPORT_SIZE != (CUSTOMHID_CYCLES_SIZE + 1)
+#error "CYCLE_PROFILE_REPORT_SIZE does not match CUSTOMHID_CYCLES_SIZE"
+#endif
+
+//*****************************************************************************
+//
+// The debug registers that enable the cycle counter.
+//
+//*****************************************************************************
+#define CYCLE_PROFILE_DEMCR     (*((volatile uint32_t *)0xE000EDFC))
+#define CYCLE_PROFILE_DEMCR_TRCENA                                            \
+                                0x01000000
+#define CYCLE_PROFILE_DWT_CTRL  (*((volatile uint32_t *)0xE0001000))
+#define CYCLE_PROFILE_DWT_CTRL_CYCCNTENA                                      \
+                                0x00000001
+
+//*****************************************************************************
+//
+// The figures kept for each section.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Count;
+    uint32_t ui32Min;
+    uint32_t ui32Max;
+    uint64_t ui64Total;
+}
+tCycleProfile;
+
+static volatile tCycleProfile g_psCycleProfile[CYCLE_PROFILE_SECTIONS];
+
+//*****************************************************************************
+//
+// The feature report handed to the USB library.  This has to stay put until
+// the control transfer is finished, so it is not built on the stack.
+//
+//*****************************************************************************
+static uint8_t g_pui8CycleProfileReport[CYCLE_PROFILE_REPORT_SIZE];
+
+//*****************************************************************************
+//
+// Starts the cycle counter and clears every section.
+//
+//*****************************************************************************
+void
+CycleProfileInit(void)
+{
+    CYCLE_PROFILE_DEMCR |= CYCLE_PROFILE_DEMCR_TRCENA;
+    CYCLE_PROFILE_CYCCNT = 0;
+    CYCLE_PROFILE_DWT_CTRL |= CYCLE_PROFILE_DWT_CTRL_CYCCNTENA;
+
+    CycleProfileReset();
+}
+
+//*****************************************************************************
+//
+// Clears every section.
+//
+//*****************************************************************************
+void
+CycleProfileReset(void)
+{
+    uint32_t ui32Section;
+
+    for(ui32Section = 0; ui32Section < CYCLE_PROFILE_SECTIONS; ui32Section++)
+    {
+        g_psCycleProfile[ui32Section].ui32Count = 0;
+        g_psCycleProfile[ui32Section].ui32Min = 0xFFFFFFFF;
+        g_psCycleProfile[ui32Section].ui32Max = 0;
+        g_psCycleProfile[ui32Section].ui64Total = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Counts one run of a section.
+//
+// \param ui32Section is the section that was timed, one of the
+// CYCLE_PROFILE_ values.
+// \param ui32Cycles is the number of cycles it took.
+//
+// Each section is only timed from one interrupt or from the main loop, so
+// the figures for a section are never updated by two contexts at once.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+CycleProfileRecord(uint32_t ui32Section, uint32_t ui32Cycles)
+{
+    volatile tCycleProfile *psProfile;
+
+    psProfile = &g_psCycleProfile[ui32Section];
+
+    if(psProfile->ui32Count == 0xFFFFFFFF)
+    {
+        return;
+    }
+    psProfile->ui32Count++;
+    psProfile->ui64Total += ui32Cycles;
+    if(ui32Cycles < psProfile->ui32Min)
+    {
+        psProfile->ui32Min = ui32Cycles;
+    }
+    if(ui32Cycles > psProfile->ui32Max)
+    {
+        psProfile->ui32Max = ui32Cycles;
+    }
+}
+
+//*****************************************************************************
+//
+// Writes a 32 bit value little endian and returns the next byte.
+//
+//*****************************************************************************
+static uint8_t *
+CycleProfilePut(uint8_t *pui8Report, uint32_t ui32Value)
+{
+    *pui8Report++ = ui32Value;
+    *pui8Report++ = ui32Value >> 8;
+    *pui8Report++ = ui32Value >> 16;
+    *pui8Report++ = ui32Value >> 24;
+    return(pui8Report);
+}
+
+//*****************************************************************************
+//
+// Builds the cycle profile feature report and returns a pointer to it.  The
+// report is CYCLE_PROFILE_REPORT_SIZE bytes long, including the report ID.
+//
+//*****************************************************************************
+uint8_t *
+CycleProfileReportGet(void)
+{
+    uint32_t ui32Section, ui32Count;
+    uint8_t *pui8Report;
+
+    g_pui8CycleProfileReport[0] = CUSTOMHID_REPORT_ID_CYCLES;
+    g_pui8CycleProfileReport[1] = CYCLE_PROFILE_REPORT_VERSION;
+    g_pui8CycleProfileReport[2] = CYCLE_PROFILE_SECTIONS;
+
+    pui8Report = &g_pui8CycleProfileReport[3];
+    for(ui32Section = 0; ui32Section < CYCLE_PROFILE_SECTIONS; ui32Section++)
+    {
+        ui32Count = g_psCycleProfile[ui32Section].ui32Count;
+        pui8Report = CycleProfilePut(pui8Report, ui32Count);
+        pui8Report = CycleProfilePut(pui8Report, ui32Count ?
+                                     g_psCycleProfile[ui32Section].ui32Min :
+                                     0);
+        pui8Report = CycleProfilePut(pui8Report, ui32Count ?
+                                     (uint32_t)(g_psCycleProfile[ui32Section].
+                                                ui64Total / ui32Count) : 0);
+        pui8Report = CycleProfilePut(pui8Report,
+                                     g_psCycleProfile[ui32Section].ui32Max);
+    }
+
+    return(g_pui8CycleProfileReport);
+}
+
+#endif // CYCLE_PROFILE_ENABLE
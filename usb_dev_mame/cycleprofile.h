@@ -0,0 +1,95 @@
+//*****************************************************************************
+//
+// cycleprofile.h - Cycle counts of the interrupt and main loop hot paths.
+//
+// Set CYCLE_PROFILE_ENABLE to 1 to time each section with the DWT cycle
+// counter.  When it is 0 the macros below expand to nothing and no code or
+// data is added.
+//
+//*****************************************************************************
+
+#ifndef __CYCLEPROFILE_H__
+#define __CYCLEPROFILE_H__
+
+#ifndef CYCLE_PROFILE_ENABLE
+#define CYCLE_PROFILE_ENABLE    0
+#endif
+
+//*****************************************************************************
+//
+// The timed sections.
+//
+// CYCLE_PROFILE_SYSTICK is the whole of SysTickIntHandler().
+//
+// CYCLE_PROFILE_CHANGE is CustomHidChangeHandler(), the check and queueing of
+// reports from the main loop.
+//
+// CYCLE_PROFILE_USB_INT is USB0DeviceIntHandler(), including the HID driver
+// and application callbacks it makes.
+//
+// CYCLE_PROFILE_STATE_CHANGE is each call to USBDHIDCustomHidStateChange().
+//
+//*****************************************************************************
+#define CYCLE_PROFILE_SYSTICK   0
+#define CYCLE_PROFILE_CHANGE    1
+#define CYCLE_PROFILE_USB_INT   2
+#define CYCLE_PROFILE_STATE_CHANGE                                            \
+                                3
+#define CYCLE_PROFILE_SECTIONS  4
+
+//*****************************************************************************
+//
+// The format version in byte 1 of the feature report.  The report is:
+//
+//  byte 0      CUSTOMHID_REPORT_ID_CYCLES
+//  byte 1      CYCLE_PROFILE_REPORT_VERSION
+//  byte 2      CYCLE_PROFILE_SECTIONS
+//  byte 3 on   for each section in turn the count, minimum, average and
+//              maximum in cycles, each 32 bit little endian.
+//
+// Writing the feature report, with any contents, clears the counts.
+//
+//*****************************************************************************
+#define CYCLE_PROFILE_REPORT_VERSION                                          \
+                                1
+#define CYCLE_PROFILE_REPORT_SIZE                                             \
+                                (3 + (CYCLE_PROFILE_SECTIONS * 16))
+
+#if CYCLE_PROFILE_ENABLE
+//*****************************************************************************
+//
+// The DWT cycle counter.
+//
+//*****************************************************************************
+#define CYCLE_PROFILE_CYCCNT    (*((volatile uint32_t *)0xE0001004))
+
+//*****************************************************************************
+//
+// Start timing a section by reading the cycle counter into a new local
+// variable, and stop by recording the cycles since then against a section.
+//
+//*****************************************************************************
+#define CYCLE_PROFILE_BEGIN(name)                                             \
+                                uint32_t name = CYCLE_PROFILE_CYCCNT
+#define CYCLE_PROFILE_END(section, name)                                      \
+                                CycleProfileRecord((section),                 \
+                                                   CYCLE_PROFILE_CYCCNT -     \
+                                                   (name))
+#define CYCLE_PROFILE_INIT()    CycleProfileInit()
+
+//*****************************************************************************
+//
+// Prototypes for the cycle profile functions.
+//
+//*****************************************************************************
+extern void CycleProfileInit(void);
+extern void CycleProfileReset(void);
+extern void CycleProfileRecord(uint32_t ui32Section, uint32_t ui32Cycles);
+extern uint8_t *CycleProfileReportGet(void);
+#else
+#define CYCLE_PROFILE_BEGIN(name)
+#define CYCLE_PROFILE_END(section, name)
+#define CYCLE_PROFILE_INIT()
+#endif
+
+#endif // __CYCLEPROFILE_H__
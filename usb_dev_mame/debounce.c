@@ -0,0 +1,184 @@
+//*****************************************************************************
+//
+// debounce.c - Bit-parallel switch debouncing for the Mame control device.
+//
+// All inputs are packed into a single 32-bit word and debounced together
+// using vertical counters: three words hold bit 0, bit 1 and bit 2 of a
+// separate counter for every input.  The number of samples needed to accept
+// a press or a release is held the same way, so every input can have its own
+// policy.  The cost of a sample is a fixed few dozen instructions however
+// many inputs are in use.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "debounce.h"
+
+//*****************************************************************************
+//
+// Resets the debounce state.
+//
+// \param psState is the debounce state to initialize.
+// \param ui32Initial is the debounced state to start from.
+//
+// Every input starts with the DEBOUNCE_INTEGRATE policy.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+DebounceInit(tDebounceState *psState, uint32_t ui32Initial)
+{
+    psState->ui32Count0 = 0;
+    psState->ui32Count1 = 0;
+    psState->ui32Count2 = 0;
+    psState->ui32State = ui32Initial;
+    DebounceThresholdSet(psState, 0xFFFFFFFF, MAX_CHECKS, 1);
+}
+
+//*****************************************************************************
+//
+// Sets the number of samples needed to accept a change on a group of inputs.
+//
+// \param psState is the debounce state to update.
+// \param ui32Inputs has a bit set for each input to change.
+// \param ui32Press is the number of consecutive closed samples needed to
+// accept a press, from 1 to DEBOUNCE_MAX_COUNT.
+// \param ui32Release is the number of consecutive open samples needed to
+// accept a release, from 1 to DEBOUNCE_MAX_COUNT.
+//
+// Counts outside the valid range are clamped.  If this is called while the
+// sampler is running, a sample that lands part way through sees a mix of old
+// and new counts for the affected inputs only.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+DebounceThresholdSet(tDebounceState *psState, uint32_t ui32Inputs,
+                     uint32_t ui32Press, uint32_t ui32Release)
+{
+    uint32_t ui32Bit;
+
+    if(ui32Press < 1)
+    {
+        ui32Press = 1;
+    }
+    else if(ui32Press > DEBOUNCE_MAX_COUNT)
+    {
+        ui32Press = DEBOUNCE_MAX_COUNT;
+    }
+
+    if(ui32Release < 1)
+    {
+        ui32Release = 1;
+    }
+    else if(ui32Release > DEBOUNCE_MAX_COUNT)
+    {
+        ui32Release = DEBOUNCE_MAX_COUNT;
+    }
+
+    for(ui32Bit = 0; ui32Bit < 3; ui32Bit++)
+    {
+        if(ui32Press & (1 << ui32Bit))
+        {
+            psState->pui32Press[ui32Bit] |= ui32Inputs;
+        }
+        else
+        {
+            psState->pui32Press[ui32Bit] &= ~ui32Inputs;
+        }
+
+        if(ui32Release & (1 << ui32Bit))
+        {
+            psState->pui32Release[ui32Bit] |= ui32Inputs;
+        }
+        else
+        {
+            psState->pui32Release[ui32Bit] &= ~ui32Inputs;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Selects the debounce policy for a group of inputs.
+//
+// \param psState is the debounce state to update.
+// \param ui32Inputs has a bit set for each input to change.
+// \param ui32Policy is DEBOUNCE_INTEGRATE or DEBOUNCE_EAGER.
+// \param ui32HoldOff is the number of open samples an eager input needs
+// before a release is accepted.  It is ignored for integrating inputs.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+DebouncePolicySet(tDebounceState *psState, uint32_t ui32Inputs,
+                  uint32_t ui32Policy, uint32_t ui32HoldOff)
+{
+    if(ui32Policy == DEBOUNCE_EAGER)
+    {
+        DebounceThresholdSet(psState, ui32Inputs, 1, ui32HoldOff);
+    }
+    else
+    {
+        DebounceThresholdSet(psState, ui32Inputs, MAX_CHECKS, 1);
+    }
+}
+
+//*****************************************************************************
+//
+// Feeds one sample of every input into the debouncer.
+//
+// \param psState is the debounce state to update.
+// \param ui32Sample holds the raw inputs, one bit per input with 1 meaning
+// closed.
+//
+// An input changes state once it has disagreed with its debounced state for
+// the press or release count set for it.  With the default integrating policy
+// this matches ANDing together the last MAX_CHECKS samples of each input.
+//
+// \return Returns the debounced state after this sample.
+//
+//*****************************************************************************
+uint32_t
+DebounceUpdate(tDebounceState *psState, uint32_t ui32Sample)
+{
+    uint32_t ui32Delta, ui32Count0, ui32Count1, ui32Count2, ui32Toggle;
+    uint32_t ui32State;
+
+    //
+    // Inputs that disagree with their debounced state count up, the rest
+    // are cleared back to zero.
+    //
+    ui32Delta = ui32Sample ^ psState->ui32State;
+    ui32Count0 = ~psState->ui32Count0 & ui32Delta;
+    ui32Count1 = (psState->ui32Count1 ^ psState->ui32Count0) & ui32Delta;
+    ui32Count2 = (psState->ui32Count2 ^
+                  (psState->ui32Count1 & psState->ui32Count0)) & ui32Delta;
+
+    //
+    // Find the inputs whose count has reached the release count if they are
+    // closed or the press count if they are open.
+    //
+    ui32State = psState->ui32State;
+    ui32Toggle = ui32Delta &
+                 ~((ui32Count0 ^ ((ui32State & psState->pui32Release[0]) |
+                                  (~ui32State & psState->pui32Press[0]))) |
+                   (ui32Count1 ^ ((ui32State & psState->pui32Release[1]) |
+                                  (~ui32State & psState->pui32Press[1]))) |
+                   (ui32Count2 ^ ((ui32State & psState->pui32Release[2]) |
+                                  (~ui32State & psState->pui32Press[2]))));
+
+    //
+    // Flip the inputs that changed and restart their counters.
+    //
+    psState->ui32State ^= ui32Toggle;
+    psState->ui32Count0 = ui32Count0 & ~ui32Toggle;
+    psState->ui32Count1 = ui32Count1 & ~ui32Toggle;
+    psState->ui32Count2 = ui32Count2 & ~ui32Toggle;
+
+    return(psState->ui32State);
+}
@@ -0,0 +1,103 @@
+//*****************************************************************************
+//
+// debounce.h - Bit-parallel switch debouncing for the Mame control device.
+//
+//*****************************************************************************
+
+#ifndef __DEBOUNCE_H__
+#define __DEBOUNCE_H__
+
+//*****************************************************************************
+//
+// The largest sample count the three bit vertical counters can hold.  No
+// input takes more than this many samples to change state.
+//
+//*****************************************************************************
+#define DEBOUNCE_MAX_COUNT      7
+
+//*****************************************************************************
+//
+// The number of consecutive closed samples needed before a press is accepted
+// by an integrating input.
+//
+//*****************************************************************************
+#ifndef MAX_CHECKS
+#define MAX_CHECKS              5
+#endif
+
+#if (MAX_CHECKS < 1) || (MAX_CHECKS > DEBOUNCE_MAX_COUNT)
+#error "MAX_CHECKS must be between 1 and 7"
+#endif
+
+//*****************************************************************************
+//
+// The number of consecutive open samples an eager input must see before a
+// release is accepted.  This is the hold-off that locks out contact bounce
+// after a press.
+//
+//*****************************************************************************
+#ifndef DEBOUNCE_HOLDOFF
+#define DEBOUNCE_HOLDOFF        5
+#endif
+
+#if (DEBOUNCE_HOLDOFF < 1) || (DEBOUNCE_HOLDOFF > DEBOUNCE_MAX_COUNT)
+#error "DEBOUNCE_HOLDOFF must be between 1 and 7"
+#endif
+
+//*****************************************************************************
+//
+// Debounce policies accepted by DebouncePolicySet().
+//
+// DEBOUNCE_INTEGRATE waits for MAX_CHECKS closed samples before reporting a
+// press and reports a release on the first open sample.
+//
+// DEBOUNCE_EAGER reports a press on the first closed sample and only accepts
+// a release after the hold-off has passed with the switch open throughout.
+//
+//*****************************************************************************
+#define DEBOUNCE_INTEGRATE      0
+#define DEBOUNCE_EAGER          1
+
+//*****************************************************************************
+//
+// Debounce state for up to 32 inputs packed into one word.  Bit n of each
+// counter plane holds one bit of the count for input n, so every input is
+// counted by the same handful of logical operations.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The three planes of the per-input sample counters.
+    //
+    uint32_t ui32Count0;
+    uint32_t ui32Count1;
+    uint32_t ui32Count2;
+
+    //
+    // The debounced input state, one bit per input with 1 meaning closed.
+    //
+    uint32_t ui32State;
+
+    //
+    // Planes of the per-input sample counts needed to accept a press and a
+    // release, laid out the same way as the counters.
+    //
+    uint32_t pui32Press[3];
+    uint32_t pui32Release[3];
+}
+tDebounceState;
+
+//*****************************************************************************
+//
+// Prototypes for the debounce functions.
+//
+//*****************************************************************************
+extern void DebounceInit(tDebounceState *psState, uint32_t ui32Initial);
+extern uint32_t DebounceUpdate(tDebounceState *psState, uint32_t ui32Sample);
+extern void DebounceThresholdSet(tDebounceState *psState, uint32_t ui32Inputs,
+                                 uint32_t ui32Press, uint32_t ui32Release);
+extern void DebouncePolicySet(tDebounceState *psState, uint32_t ui32Inputs,
+                              uint32_t ui32Policy, uint32_t ui32HoldOff);
+
+#endif // __DEBOUNCE_H__
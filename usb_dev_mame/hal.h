@@ -0,0 +1,107 @@
+//*****************************************************************************
+//
+// hal.h - Hardware access used by the input pipeline.
+//
+// The pipeline in pipeline.c only reaches the hardware through these calls.
+// hal_tiva.c implements them with driverlib and the USB HID driver for the
+// Launchpad.  host/hal_linux.c implements them with simulated ports, encoders
+// and HID endpoints so the pipeline can be built and exercised on a PC.
+//
+//*****************************************************************************
+
+#ifndef __HAL_H__
+#define __HAL_H__
+
+//*****************************************************************************
+//
+// The switch input ports, as passed to HALGPIORead() and indexing the levels
+// read by HALGPIOScan().
+//
+//*****************************************************************************
+#define HAL_PORTA               0
+#define HAL_PORTB               1
+#define HAL_PORTC               2
+#define HAL_PORTD               3
+#define HAL_PORTE               4
+#define HAL_NUM_PORTS           5
+
+//*****************************************************************************
+//
+// Set INPUT_SAMPLE_HZ to have the hardware sample every switch port that many
+// times a second for the sampled capture mode.  Timers pace uDMA copies of
+// the port data registers into a circular buffer of HAL_SAMPLE_SLOTS samples
+// per port, HAL_SAMPLE_US apart, which HALGPIOSamplesGet() hands over a
+// block at a time.  0 leaves the sampler out.
+//
+//*****************************************************************************
+#ifndef INPUT_SAMPLE_HZ
+#define INPUT_SAMPLE_HZ         0
+#endif
+
+#if INPUT_SAMPLE_HZ
+#if (INPUT_SAMPLE_HZ < 10000) || (INPUT_SAMPLE_HZ > 50000) ||                 \
+    (1000000 % INPUT_SAMPLE_HZ) || (INPUT_SAMPLE_HZ % 500)
+#error "INPUT_SAMPLE_HZ must be 10000, 12500, 20000, 25000, 40000 or 50000"
+#endif
+
+#define HAL_SAMPLE_US           (1000000 / INPUT_SAMPLE_HZ)
+#define HAL_SAMPLE_SLOTS        (INPUT_SAMPLE_HZ / 250)
+#endif
+
+//*****************************************************************************
+//
+// The trackball encoders, as passed to HALQEIPositionGet().  The position is
+// a free running 32 bit count, so the difference of two readings is the
+// motion between them.
+//
+//*****************************************************************************
+#define HAL_QEI_X               0
+#define HAL_QEI_Y               1
+
+//*****************************************************************************
+//
+// The size in bytes of the non-volatile settings store read by
+// HALConfigRead() and written a word at a time by HALConfigProgram().
+// Offsets and sizes must be multiples of four bytes.  A location never
+// written reads as all ones.
+//
+//*****************************************************************************
+#define HAL_CONFIG_SIZE         2048
+
+//*****************************************************************************
+//
+// The state of the last word written to the settings store, as returned by
+// HALConfigStatus().
+//
+//*****************************************************************************
+#define HAL_CONFIG_DONE         0
+#define HAL_CONFIG_BUSY         1
+#define HAL_CONFIG_FAILED       2
+
+//*****************************************************************************
+//
+// Prototypes for the hardware access functions.
+//
+//*****************************************************************************
+extern void HALInit(uint32_t ui32SysClock);
+extern uint32_t HALTimeGet(void);
+extern uint8_t HALGPIORead(uint32_t ui32Port, uint8_t ui8Pins);
+extern void HALGPIOScan(uint8_t *pui8Levels);
+extern uint32_t HALGPIOSamplesGet(const uint8_t **ppui8Samples,
+                                  uint32_t *pui32Slot);
+extern uint32_t HALQEIPositionGet(uint32_t ui32Encoder);
+extern bool HALAnalogRead(uint16_t *pui16Raw);
+extern uint32_t HALReportChannel(uint8_t ui8ReportID);
+extern bool HALReportIdle(uint32_t ui32Channel);
+extern bool HALReportQueued(uint32_t ui32Channel, uint8_t ui8ReportID);
+extern bool HALReportSend(uint32_t ui32Channel, uint8_t ui8ReportID,
+                          signed char *pi8Data);
+extern void HALRemoteWakeup(void);
+extern bool HALIntDisable(void);
+extern void HALIntRestore(bool bWasDisabled);
+extern bool HALConfigRead(uint32_t ui32Offset, uint32_t *pui32Data,
+                          uint32_t ui32Size);
+extern bool HALConfigProgram(uint32_t ui32Offset, uint32_t ui32Data);
+extern uint32_t HALConfigStatus(void);
+
+#endif // __HAL_H__
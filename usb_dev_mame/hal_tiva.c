@@ -0,0 +1,909 @@
+//*****************************************************************************
+//
+// hal_tiva.c - Launchpad implementation of the pipeline hardware access.
+//
+// The switch ports are read directly through the AHB aperture, the trackball
+// through QEI0 and QEI1, time through wide timer 5, settings are kept in the
+// EEPROM and reports go to the Mame HID driver.  In velocity mode the QEI
+// modules also interrupt at the end of every velocity capture period.  With
+// CUSTOMHID_SPINNER the spinner pins interrupt on every edge and are decoded
+// in software.  With CUSTOMHID_ANALOG_AXES timer 1 triggers ADC0 and uDMA
+// carries the results into a double buffer.  With INPUT_SAMPLE_HZ timers 0, 2
+// and 3 pace uDMA copies of the switch ports into a circular buffer.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_adc.h"
+#include "inc/hw_gpio.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_timer.h"
+#include "driverlib/adc.h"
+#include "driverlib/eeprom.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/qei.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/udma.h"
+#include "usblib/usblib.h"
+#include "usblib/usbhid.h"
+#include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdcomp.h"
+#include "usblib/device/usbdhid.h"
+#include "usblib/device/usbdhidmame.h"
+#include "usb_mame_structs.h"
+#include "hal.h"
+#include "mousemotion.h"
+#include "softquad.h"
+#include "analog.h"
+#include "cycleprofile.h"
+
+//*****************************************************************************
+//
+// The offset of the data register that reads or writes every pin of a port.
+//
+//*****************************************************************************
+#define HAL_GPIO_DATA_ALL       (GPIO_O_DATA + (0xFF << 2))
+
+//*****************************************************************************
+//
+// The GPIO port for each HAL_PORT value.
+//
+//*****************************************************************************
+static const uint32_t g_pui32HALPorts[HAL_NUM_PORTS] =
+{
+    GPIO_PORTA_AHB_BASE, GPIO_PORTB_AHB_BASE, GPIO_PORTC_AHB_BASE,
+    GPIO_PORTD_AHB_BASE, GPIO_PORTE_AHB_BASE
+};
+
+#if CUSTOMHID_SPINNER
+static const uint32_t g_pui32HALPortInts[HAL_NUM_PORTS] =
+{
+    INT_GPIOA, INT_GPIOB, INT_GPIOC, INT_GPIOD, INT_GPIOE
+};
+
+//*****************************************************************************
+//
+// The software decoded encoder pins on each port.
+//
+//*****************************************************************************
+static uint8_t g_pui8HALSoftQuadPins[HAL_NUM_PORTS];
+#endif
+
+//*****************************************************************************
+//
+// The QEI module for each HAL_QEI value.
+//
+//*****************************************************************************
+static const uint32_t g_pui32HALEncoders[2] =
+{
+    QEI0_BASE, QEI1_BASE
+};
+
+#if MOUSE_VELOCITY_ENABLE
+static const uint32_t g_pui32HALEncoderInts[2] =
+{
+    INT_QEI0, INT_QEI1
+};
+#endif
+
+#if CUSTOMHID_ANALOG_AXES || INPUT_SAMPLE_HZ
+//*****************************************************************************
+//
+// The uDMA control table, shared by the analog inputs and the switch
+// sampler.  The controller requires it to be aligned to 1024 bytes.
+//
+//*****************************************************************************
+#pragma DATA_ALIGN(g_psHALDMAControl, 1024)
+static tDMAControlTable g_psHALDMAControl[64];
+#endif
+
+#if INPUT_SAMPLE_HZ
+//*****************************************************************************
+//
+// The uDMA channel, and its timer, that copies each switch port.  All five
+// timers time out on the same clock, and the controller serves the lowest
+// channel first, so port E is always the last copied of each sample and its
+// channel tells how far every port has got.
+//
+//*****************************************************************************
+static const uint32_t g_pui32HALSampleChannels[HAL_NUM_PORTS] =
+{
+    UDMA_SEC_CHANNEL_TMR2A, UDMA_SEC_CHANNEL_TMR3A, UDMA_SEC_CHANNEL_TMR3B,
+    UDMA_CHANNEL_TMR0A, UDMA_CHANNEL_TMR0B
+};
+
+static const uint32_t g_pui32HALSampleMaps[HAL_NUM_PORTS] =
+{
+    UDMA_CH4_TIMER2A, UDMA_CH2_TIMER3A, UDMA_CH3_TIMER3B, UDMA_CH18_TIMER0A,
+    UDMA_CH19_TIMER0B
+};
+
+//*****************************************************************************
+//
+// The circular sample buffer of each port.  Each half is filled through one
+// of the ping-pong control structures of the port's channel.  The reader is
+// g_ui32HALSampleRead samples into half g_ui32HALSampleHalf.
+//
+//*****************************************************************************
+#define HAL_SAMPLE_HALF         (HAL_SAMPLE_SLOTS / 2)
+
+static uint8_t g_ppui8HALSamples[HAL_NUM_PORTS][HAL_SAMPLE_SLOTS];
+static uint32_t g_ui32HALSampleHalf;
+static uint32_t g_ui32HALSampleRead;
+#endif
+
+#if CUSTOMHID_ANALOG_AXES
+//*****************************************************************************
+//
+// The ADC input of each analog axis: PE2, PE3, PE4 and PE5.
+//
+//*****************************************************************************
+static const uint32_t g_pui32HALAnalogInputs[4] =
+{
+    ADC_CTL_CH1, ADC_CTL_CH0, ADC_CTL_CH9, ADC_CTL_CH8
+};
+
+//*****************************************************************************
+//
+// The analog double buffer, one half for the primary and one for the
+// alternate uDMA control structure, and the half that was filled last.
+// g_bHALAnalogNew is set each time a half is filled.
+//
+//*****************************************************************************
+#define HAL_ANALOG_SAMPLES      (ANALOG_BLOCK * CUSTOMHID_ANALOG_AXES)
+
+static uint16_t g_ppui16HALAnalog[2][HAL_ANALOG_SAMPLES];
+static volatile uint32_t g_ui32HALAnalogHalf;
+static volatile bool g_bHALAnalogNew;
+
+//*****************************************************************************
+//
+// The ADC asks for a uDMA burst of one sample per axis at the end of each
+// sequence.
+//
+//*****************************************************************************
+#if CUSTOMHID_ANALOG_AXES == 4
+#define HAL_ANALOG_ARB          UDMA_ARB_4
+#elif CUSTOMHID_ANALOG_AXES == 2
+#define HAL_ANALOG_ARB          UDMA_ARB_2
+#else
+#define HAL_ANALOG_ARB          UDMA_ARB_1
+#endif
+#endif
+
+//*****************************************************************************
+//
+// The HID device for each report channel.  A channel is the ui32Interface of
+// the device, so the driver callbacks can name it too.
+//
+//*****************************************************************************
+static tUSBDHIDCustomHidDevice * const g_ppsHALDevices[CUSTOMHID_NUM_IFACES] =
+{
+#if CUSTOMHID_COMPOSITE
+    &g_sGamepad1Device, &g_sGamepad2Device, &g_sMouseDevice
+#else
+    &g_sCustomHidDevice
+#endif
+};
+
+//*****************************************************************************
+//
+// True once the EEPROM has been brought up without error.
+//
+//*****************************************************************************
+static bool g_bHALConfigReady;
+
+#if CUSTOMHID_ANALOG_AXES
+//*****************************************************************************
+//
+// Points one half of the analog double buffer back at the start for uDMA to
+// fill again.
+//
+//*****************************************************************************
+static void
+HALAnalogArm(uint32_t ui32Half)
+{
+    uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 |
+                           (ui32Half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT),
+                           UDMA_MODE_PINGPONG,
+                           (void *)(ADC0_BASE + ADC_O_SSFIFO0),
+                           g_ppui16HALAnalog[ui32Half], HAL_ANALOG_SAMPLES);
+}
+
+//*****************************************************************************
+//
+// Takes over the analog pins from the switches and starts the ADC.  Sequence
+// 0 converts every axis in turn each time timer 1 times out, and uDMA moves
+// the results to the double buffer in ping-pong mode.
+//
+//*****************************************************************************
+static void
+HALAnalogInit(uint32_t ui32SysClock)
+{
+    uint32_t ui32Axis;
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER1);
+
+    GPIOPinTypeADC(GPIO_PORTE_AHB_BASE, ANALOG_PORTE_PINS);
+
+    ADCSequenceDisable(ADC0_BASE, 0);
+    ADCHardwareOversampleConfigure(ADC0_BASE, ANALOG_OVERSAMPLE);
+    ADCSequenceConfigure(ADC0_BASE, 0, ADC_TRIGGER_TIMER, 0);
+    for(ui32Axis = 0; ui32Axis < CUSTOMHID_ANALOG_AXES; ui32Axis++)
+    {
+        ADCSequenceStepConfigure(ADC0_BASE, 0, ui32Axis,
+                                 g_pui32HALAnalogInputs[ui32Axis] |
+                                 ((ui32Axis == (CUSTOMHID_ANALOG_AXES - 1)) ?
+                                  (ADC_CTL_IE | ADC_CTL_END) : 0));
+    }
+
+    uDMAChannelAssign(UDMA_CH14_ADC0_0);
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_ADC0, UDMA_ATTR_ALL);
+    uDMAChannelControlSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT,
+                          UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 |
+                          HAL_ANALOG_ARB);
+    uDMAChannelControlSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT,
+                          UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 |
+                          HAL_ANALOG_ARB);
+    HALAnalogArm(0);
+    HALAnalogArm(1);
+    uDMAChannelEnable(UDMA_CHANNEL_ADC0);
+
+    ADCSequenceDMAEnable(ADC0_BASE, 0);
+    ADCSequenceEnable(ADC0_BASE, 0);
+    IntEnable(INT_ADC0SS0);
+
+    TimerConfigure(TIMER1_BASE, TIMER_CFG_PERIODIC);
+    TimerLoadSet(TIMER1_BASE, TIMER_A, (ui32SysClock / ANALOG_SAMPLE_HZ) - 1);
+    TimerControlTrigger(TIMER1_BASE, TIMER_A, true);
+    TimerEnable(TIMER1_BASE, TIMER_A);
+}
+#endif
+
+#if INPUT_SAMPLE_HZ
+//*****************************************************************************
+//
+// Points one half of a port's sample buffer back at the start for uDMA to
+// fill again.
+//
+//*****************************************************************************
+static void
+HALSampleArm(uint32_t ui32Port, uint32_t ui32Half)
+{
+    uDMAChannelTransferSet(g_pui32HALSampleChannels[ui32Port] |
+                           (ui32Half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT),
+                           UDMA_MODE_PINGPONG,
+                           (void *)(g_pui32HALPorts[ui32Port] +
+                                    HAL_GPIO_DATA_ALL),
+                           &g_ppui8HALSamples[ui32Port][ui32Half *
+                                                        HAL_SAMPLE_HALF],
+                           HAL_SAMPLE_HALF);
+}
+
+//*****************************************************************************
+//
+// Starts the sampler from the beginning of the buffers.  The timers are
+// stopped while the channels are armed, so that no port can take a sample
+// the others miss, and then restarted in step.
+//
+//*****************************************************************************
+static void
+HALSampleStart(void)
+{
+    uint32_t ui32Port;
+
+    TimerDisable(TIMER0_BASE, TIMER_BOTH);
+    TimerDisable(TIMER2_BASE, TIMER_A);
+    TimerDisable(TIMER3_BASE, TIMER_BOTH);
+
+    for(ui32Port = 0; ui32Port < HAL_NUM_PORTS; ui32Port++)
+    {
+        uDMAChannelDisable(g_pui32HALSampleChannels[ui32Port]);
+        HALSampleArm(ui32Port, 0);
+        HALSampleArm(ui32Port, 1);
+        uDMAChannelEnable(g_pui32HALSampleChannels[ui32Port]);
+    }
+    g_ui32HALSampleHalf = 0;
+    g_ui32HALSampleRead = 0;
+
+    TimerEnable(TIMER0_BASE, TIMER_BOTH);
+    TimerEnable(TIMER2_BASE, TIMER_A);
+    TimerEnable(TIMER3_BASE, TIMER_BOTH);
+    TimerSynchronize(TIMER0_BASE, TIMER_0A_SYNC | TIMER_0B_SYNC |
+                                  TIMER_2A_SYNC | TIMER_3A_SYNC |
+                                  TIMER_3B_SYNC);
+}
+
+//*****************************************************************************
+//
+// Sets up the switch sampler.  Timers 0A, 0B, 2A, 3A and 3B run as 16 bit
+// periodic timers with the same period, and each time out asks its uDMA
+// channel to copy one port.  The processor is not involved until the
+// samples are read.
+//
+//*****************************************************************************
+static void
+HALSampleInit(uint32_t ui32SysClock)
+{
+    uint32_t ui32Port, ui32Load;
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER2);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER3);
+
+    ui32Load = (ui32SysClock / INPUT_SAMPLE_HZ) - 1;
+    TimerConfigure(TIMER0_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PERIODIC |
+                                TIMER_CFG_B_PERIODIC);
+    TimerConfigure(TIMER2_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PERIODIC);
+    TimerConfigure(TIMER3_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PERIODIC |
+                                TIMER_CFG_B_PERIODIC);
+    TimerLoadSet(TIMER0_BASE, TIMER_BOTH, ui32Load);
+    TimerLoadSet(TIMER2_BASE, TIMER_A, ui32Load);
+    TimerLoadSet(TIMER3_BASE, TIMER_BOTH, ui32Load);
+
+    for(ui32Port = 0; ui32Port < HAL_NUM_PORTS; ui32Port++)
+    {
+        uDMAChannelAssign(g_pui32HALSampleMaps[ui32Port]);
+        uDMAChannelAttributeDisable(g_pui32HALSampleChannels[ui32Port],
+                                    UDMA_ATTR_ALL);
+        uDMAChannelControlSet(g_pui32HALSampleChannels[ui32Port] |
+                              UDMA_PRI_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_NONE |
+                              UDMA_DST_INC_8 | UDMA_ARB_1);
+        uDMAChannelControlSet(g_pui32HALSampleChannels[ui32Port] |
+                              UDMA_ALT_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_NONE |
+                              UDMA_DST_INC_8 | UDMA_ARB_1);
+    }
+
+    HALSampleStart();
+}
+#endif
+
+//*****************************************************************************
+//
+// Starts the microsecond time, the trackball encoders, the spinner pins, the
+// analog inputs, the switch sampler and the EEPROM.  The switch and encoder
+// pins must already have been set up by PortFunctionInit().
+//
+// \param ui32SysClock is the system clock rate in Hz.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+HALInit(uint32_t ui32SysClock)
+{
+    uint32_t ui32Idx;
+#if CUSTOMHID_SPINNER
+    const tSoftQuadPins *psPins;
+    uint32_t ui32Base;
+    uint8_t ui8Pins;
+#endif
+
+    //
+    // Wide timer 5A counts down once a microsecond through the whole 32-bit
+    // range.  In split mode the prescaler is a true prescaler for down counts.
+    //
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_WTIMER5);
+    TimerConfigure(WTIMER5_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PERIODIC);
+    TimerPrescaleSet(WTIMER5_BASE, TIMER_A, (ui32SysClock / 1000000) - 1);
+    TimerLoadSet(WTIMER5_BASE, TIMER_A, 0xFFFFFFFF);
+    TimerEnable(WTIMER5_BASE, TIMER_A);
+
+    for(ui32Idx = 0; ui32Idx < 2; ui32Idx++)
+    {
+        //DISable peripheral and int before configuration
+        QEIDisable(g_pui32HALEncoders[ui32Idx]);
+        QEIIntDisable(g_pui32HALEncoders[ui32Idx],
+                      QEI_INTERROR | QEI_INTDIR | QEI_INTTIMER | QEI_INTINDEX);
+
+        // Configure quadrature encoder to count through the full 32 bits so
+        // the position never wraps between two readings
+        QEIConfigure(g_pui32HALEncoders[ui32Idx],
+                     (QEI_CONFIG_CAPTURE_A_B | QEI_CONFIG_NO_RESET |
+                      QEI_CONFIG_QUADRATURE | QEI_CONFIG_NO_SWAP),
+                     0xFFFFFFFF);
+
+#if MOUSE_VELOCITY_ENABLE
+        // Capture velocity MOUSE_VELOCITY_HZ times a second and interrupt at
+        // the end of each capture period
+        QEIVelocityConfigure(g_pui32HALEncoders[ui32Idx], QEI_VELDIV_1,
+                             ui32SysClock / MOUSE_VELOCITY_HZ);
+        QEIVelocityEnable(g_pui32HALEncoders[ui32Idx]);
+        QEIIntEnable(g_pui32HALEncoders[ui32Idx], QEI_INTTIMER);
+        IntEnable(g_pui32HALEncoderInts[ui32Idx]);
+#endif
+
+        // Enable the quadrature encoder.
+        QEIEnable(g_pui32HALEncoders[ui32Idx]);
+        QEIPositionSet(g_pui32HALEncoders[ui32Idx], 0);
+    }
+
+#if CUSTOMHID_SPINNER
+    //
+    // The spinner pins are pulled up like the switches and interrupt on both
+    // edges whatever the input capture mode, since the decoder must see every
+    // edge.
+    //
+    for(ui32Idx = 0; ui32Idx < SOFTQUAD_CHANNELS; ui32Idx++)
+    {
+        psPins = &g_psSoftQuadPins[ui32Idx];
+        ui32Base = g_pui32HALPorts[psPins->ui8Port];
+        ui8Pins = psPins->ui8PinA | psPins->ui8PinB;
+
+        GPIOPinTypeGPIOInput(ui32Base, ui8Pins);
+        GPIOPadConfigSet(ui32Base, ui8Pins, GPIO_STRENGTH_2MA,
+                         GPIO_PIN_TYPE_STD_WPU);
+        GPIOIntTypeSet(ui32Base, ui8Pins, GPIO_BOTH_EDGES);
+        GPIOIntClear(ui32Base, ui8Pins);
+        GPIOIntEnable(ui32Base, ui8Pins);
+        IntEnable(g_pui32HALPortInts[psPins->ui8Port]);
+        g_pui8HALSoftQuadPins[psPins->ui8Port] |= ui8Pins;
+    }
+#endif
+
+#if CUSTOMHID_ANALOG_AXES || INPUT_SAMPLE_HZ
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    uDMAEnable();
+    uDMAControlBaseSet(g_psHALDMAControl);
+#endif
+
+#if CUSTOMHID_ANALOG_AXES
+    HALAnalogInit(ui32SysClock);
+#endif
+
+#if INPUT_SAMPLE_HZ
+    HALSampleInit(ui32SysClock);
+#endif
+
+    //
+    // EEPROMInit() recovers from a write cut short by a power loss, and fails
+    // if that is not possible.  Settings then fall back to their defaults.
+    //
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_EEPROM0);
+    g_bHALConfigReady = (EEPROMInit() == EEPROM_INIT_OK);
+}
+
+//*****************************************************************************
+//
+// Returns the free running microsecond time.
+//
+//*****************************************************************************
+uint32_t
+HALTimeGet(void)
+{
+    return(~HWREG(WTIMER5_BASE + TIMER_O_TAR));
+}
+
+//*****************************************************************************
+//
+// Returns the level of the given pins of a switch port.  The pins select the
+// address of the data register read, so the others read as 0.
+//
+//*****************************************************************************
+uint8_t
+HALGPIORead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    return(HWREGB(g_pui32HALPorts[ui32Port] + GPIO_O_DATA + (ui8Pins << 2)));
+}
+
+//*****************************************************************************
+//
+// Reads every pin of every switch port, one load per port, into pui8Levels
+// indexed by HAL_PORT value.
+//
+//*****************************************************************************
+void
+HALGPIOScan(uint8_t *pui8Levels)
+{
+    pui8Levels[HAL_PORTA] = HWREGB(GPIO_PORTA_AHB_BASE + HAL_GPIO_DATA_ALL);
+    pui8Levels[HAL_PORTB] = HWREGB(GPIO_PORTB_AHB_BASE + HAL_GPIO_DATA_ALL);
+    pui8Levels[HAL_PORTC] = HWREGB(GPIO_PORTC_AHB_BASE + HAL_GPIO_DATA_ALL);
+    pui8Levels[HAL_PORTD] = HWREGB(GPIO_PORTD_AHB_BASE + HAL_GPIO_DATA_ALL);
+    pui8Levels[HAL_PORTE] = HWREGB(GPIO_PORTE_AHB_BASE + HAL_GPIO_DATA_ALL);
+}
+
+#if INPUT_SAMPLE_HZ
+//*****************************************************************************
+//
+// Hands over the switch samples taken since the last call.  ppui8Samples is
+// filled with the circular buffer of each port, indexed by HAL_PORT value,
+// and pui32Slot with the slot of the first new sample.  The samples run on
+// from there, wrapping at HAL_SAMPLE_SLOTS.  They stay put until the next
+// call, as uDMA does not come back to a half the reader has left until the
+// other half is full.
+//
+// Returns the number of new samples, the last of which was taken less than
+// HAL_SAMPLE_US ago.  If the reader has fallen so far behind that both
+// halves filled, the sampler is started over and 0 is returned.
+//
+//*****************************************************************************
+uint32_t
+HALGPIOSamplesGet(const uint8_t **ppui8Samples, uint32_t *pui32Slot)
+{
+    uint32_t ui32Channel, ui32Half, ui32Written, ui32Count, ui32Port;
+
+    ui32Channel = g_pui32HALSampleChannels[HAL_PORTE];
+    if(!uDMAChannelIsEnabled(ui32Channel))
+    {
+        HALSampleStart();
+        return(0);
+    }
+
+    for(ui32Port = 0; ui32Port < HAL_NUM_PORTS; ui32Port++)
+    {
+        ppui8Samples[ui32Port] = g_ppui8HALSamples[ui32Port];
+    }
+
+    ui32Half = g_ui32HALSampleHalf;
+    *pui32Slot = (ui32Half * HAL_SAMPLE_HALF) + g_ui32HALSampleRead;
+    ui32Written = HAL_SAMPLE_HALF -
+                  uDMAChannelSizeGet(ui32Channel |
+                                     (ui32Half ? UDMA_ALT_SELECT :
+                                                 UDMA_PRI_SELECT));
+    ui32Count = ui32Written - g_ui32HALSampleRead;
+    g_ui32HALSampleRead = ui32Written;
+    if(ui32Written < HAL_SAMPLE_HALF)
+    {
+        return(ui32Count);
+    }
+
+    //
+    // This half is full and uDMA has moved on to the other, so hand it back
+    // to be filled once the other is full, and count what has been written
+    // to the other so far.
+    //
+    for(ui32Port = 0; ui32Port < HAL_NUM_PORTS; ui32Port++)
+    {
+        HALSampleArm(ui32Port, ui32Half);
+    }
+    ui32Half ^= 1;
+    ui32Written = HAL_SAMPLE_HALF -
+                  uDMAChannelSizeGet(ui32Channel |
+                                     (ui32Half ? UDMA_ALT_SELECT :
+                                                 UDMA_PRI_SELECT));
+    if(ui32Written == HAL_SAMPLE_HALF)
+    {
+        HALSampleStart();
+        return(0);
+    }
+    g_ui32HALSampleHalf = ui32Half;
+    g_ui32HALSampleRead = ui32Written;
+
+    return(ui32Count + ui32Written);
+}
+#endif
+
+//*****************************************************************************
+//
+// Reads the count of a trackball encoder.
+//
+//*****************************************************************************
+uint32_t
+HALQEIPositionGet(uint32_t ui32Encoder)
+{
+    return(QEIPositionGet(g_pui32HALEncoders[ui32Encoder]));
+}
+
+#if CUSTOMHID_ANALOG_AXES
+//*****************************************************************************
+//
+// The ADC0 sequence 0 interrupt handler, called each time uDMA has filled one
+// half of the analog double buffer.  The half is noted as the latest and
+// armed again at once.  uDMA does not come back to it until the other half
+// is full, which leaves a whole block time to read it.
+//
+//*****************************************************************************
+void
+ADC0SS0IntHandler(void)
+{
+    uint32_t ui32Half;
+
+    ADCIntClear(ADC0_BASE, 0);
+
+    for(ui32Half = 0; ui32Half < 2; ui32Half++)
+    {
+        if(uDMAChannelModeGet(UDMA_CHANNEL_ADC0 |
+                              (ui32Half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT)) ==
+           UDMA_MODE_STOP)
+        {
+            g_ui32HALAnalogHalf = ui32Half;
+            g_bHALAnalogNew = true;
+            HALAnalogArm(ui32Half);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Averages each axis over the half of the analog double buffer filled last.
+// Returns false if no half has been filled since the last call.
+//
+//*****************************************************************************
+bool
+HALAnalogRead(uint16_t *pui16Raw)
+{
+    const uint16_t *pui16Block;
+    uint32_t ui32Axis, ui32Idx, ui32Sum;
+
+    if(!g_bHALAnalogNew)
+    {
+        return(false);
+    }
+    g_bHALAnalogNew = false;
+
+    pui16Block = g_ppui16HALAnalog[g_ui32HALAnalogHalf];
+    for(ui32Axis = 0; ui32Axis < CUSTOMHID_ANALOG_AXES; ui32Axis++)
+    {
+        ui32Sum = 0;
+        for(ui32Idx = ui32Axis; ui32Idx < HAL_ANALOG_SAMPLES;
+            ui32Idx += CUSTOMHID_ANALOG_AXES)
+        {
+            ui32Sum += pui16Block[ui32Idx];
+        }
+        pui16Raw[ui32Axis] = ui32Sum / ANALOG_BLOCK;
+    }
+
+    return(true);
+}
+#endif
+
+#if MOUSE_VELOCITY_ENABLE
+//*****************************************************************************
+//
+// Hands the velocity captured by an encoder to the motion smoothing.  The
+// QEI counts edges without sign, so the direction of the last edge is taken
+// as the direction of them all.
+//
+//*****************************************************************************
+static void
+HALQEIVelocityInt(uint32_t ui32Encoder)
+{
+    uint32_t ui32Base;
+
+    ui32Base = g_pui32HALEncoders[ui32Encoder];
+    QEIIntClear(ui32Base, QEI_INTTIMER);
+    MouseVelocitySample(ui32Encoder, (int32_t)QEIVelocityGet(ui32Base) *
+                                     QEIDirectionGet(ui32Base));
+}
+
+//*****************************************************************************
+//
+// The QEI0 and QEI1 interrupt handlers, called at the end of every velocity
+// capture period.
+//
+//*****************************************************************************
+void
+QEI0IntHandler(void)
+{
+    HALQEIVelocityInt(HAL_QEI_X);
+}
+
+void
+QEI1IntHandler(void)
+{
+    HALQEIVelocityInt(HAL_QEI_Y);
+}
+#endif
+
+#if CUSTOMHID_SPINNER
+//*****************************************************************************
+//
+// The port C interrupt handler.  Spinner edges are decoded here and edges on
+// any other pin of the port are passed on to the switch input handler.  The
+// levels are read after the clear so an edge that lands in between raises
+// the interrupt again rather than being lost.
+//
+//*****************************************************************************
+extern void GPIOInputIntHandler(void);
+
+void
+HALGPIOCIntHandler(void)
+{
+    uint32_t ui32Status;
+
+    ui32Status = GPIOIntStatus(GPIO_PORTC_AHB_BASE, true);
+    GPIOIntClear(GPIO_PORTC_AHB_BASE,
+                 ui32Status & g_pui8HALSoftQuadPins[HAL_PORTC]);
+    SoftQuadUpdate(HAL_PORTC,
+                   HWREGB(GPIO_PORTC_AHB_BASE + HAL_GPIO_DATA_ALL));
+
+    if(ui32Status & ~g_pui8HALSoftQuadPins[HAL_PORTC])
+    {
+        GPIOInputIntHandler();
+    }
+}
+#endif
+
+//*****************************************************************************
+//
+// Returns the report channel, that is the HID interface, that carries a
+// report ID.
+//
+//*****************************************************************************
+uint32_t
+HALReportChannel(uint8_t ui8ReportID)
+{
+#if CUSTOMHID_COMPOSITE
+    if(ui8ReportID == 1)
+    {
+        return(CUSTOMHID_IFACE_PAD1);
+    }
+    else if((ui8ReportID == 2) ||
+            (ui8ReportID == CUSTOMHID_REPORT_ID_ANALOG))
+    {
+        return(CUSTOMHID_IFACE_PAD2);
+    }
+    return(CUSTOMHID_IFACE_MOUSE);
+#else
+    return(CUSTOMHID_IFACE_ALL);
+#endif
+}
+
+//*****************************************************************************
+//
+// Returns true if a channel has no report queued or in flight.
+//
+//*****************************************************************************
+bool
+HALReportIdle(uint32_t ui32Channel)
+{
+    return(USBDHIDCustomHidTxIdle((void *)g_ppsHALDevices[ui32Channel]));
+}
+
+//*****************************************************************************
+//
+// Returns true if a report with the given ID is queued on a channel and not
+// yet sent, so that queueing another would replace it.
+//
+//*****************************************************************************
+bool
+HALReportQueued(uint32_t ui32Channel, uint8_t ui8ReportID)
+{
+    return(USBDHIDCustomHidTxQueued((void *)g_ppsHALDevices[ui32Channel],
+                                    ui8ReportID));
+}
+
+//*****************************************************************************
+//
+// Queues a report on a channel.  Returns false if the driver could not take
+// it because its queue is full or the host has not configured the device, or
+// if it could not start sending it.  In that last case the report stays in
+// the driver's queue, but nothing starts it again until the next report on
+// the channel, so the caller must offer it again.
+//
+//*****************************************************************************
+bool
+HALReportSend(uint32_t ui32Channel, uint8_t ui8ReportID, signed char *pi8Data)
+{
+    uint32_t ui32Retcode;
+    CYCLE_PROFILE_BEGIN(ui32ProfileStart);
+
+    ui32Retcode = USBDHIDCustomHidStateChange(
+                      (void *)g_ppsHALDevices[ui32Channel], ui8ReportID,
+                      pi8Data);
+
+    CYCLE_PROFILE_END(CYCLE_PROFILE_STATE_CHANGE, ui32ProfileStart);
+
+    return(ui32Retcode == CUSTOMHID_SUCCESS);
+}
+
+//*****************************************************************************
+//
+// Asks the host to resume a suspended bus.  Remote wakeup applies to the
+// whole device so any interface will do.
+//
+//*****************************************************************************
+void
+HALRemoteWakeup(void)
+{
+    USBDHIDCustomHidRemoteWakeupRequest((void *)g_ppsHALDevices[0]);
+}
+
+//*****************************************************************************
+//
+// Holds off every interrupt, for a change that sampling and the USB
+// interrupt must see all at once.  Returns true if they were already held
+// off, to pass to HALIntRestore().
+//
+//*****************************************************************************
+bool
+HALIntDisable(void)
+{
+    return(IntMasterDisable());
+}
+
+//*****************************************************************************
+//
+// Ends a HALIntDisable(), unless interrupts were already held off before it.
+//
+//*****************************************************************************
+void
+HALIntRestore(bool bWasDisabled)
+{
+    if(!bWasDisabled)
+    {
+        IntMasterEnable();
+    }
+}
+
+//*****************************************************************************
+//
+// Returns true if a range of the settings store is word aligned and lies
+// within the store.
+//
+//*****************************************************************************
+static bool
+HALConfigRange(uint32_t ui32Offset, uint32_t ui32Size)
+{
+    return(g_bHALConfigReady && !(ui32Offset & 3) && !(ui32Size & 3) &&
+           (ui32Offset <= HAL_CONFIG_SIZE) &&
+           (ui32Size <= (HAL_CONFIG_SIZE - ui32Offset)));
+}
+
+//*****************************************************************************
+//
+// Reads from the settings store in the EEPROM.  Returns false if the range
+// is not valid or the EEPROM could not be started.
+//
+//*****************************************************************************
+bool
+HALConfigRead(uint32_t ui32Offset, uint32_t *pui32Data, uint32_t ui32Size)
+{
+    if(!HALConfigRange(ui32Offset, ui32Size))
+    {
+        return(false);
+    }
+
+    EEPROMRead(pui32Data, ui32Offset, ui32Size);
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Starts writing one word of the settings store in the EEPROM and returns
+// without waiting for it.  A word can take milliseconds to program, so the
+// caller checks HALConfigStatus() before starting the next.  Returns false if
+// the offset is not valid or the last word is still being written.
+//
+//*****************************************************************************
+bool
+HALConfigProgram(uint32_t ui32Offset, uint32_t ui32Data)
+{
+    if(!HALConfigRange(ui32Offset, 4) ||
+       (EEPROMStatusGet() & EEPROM_RC_WORKING))
+    {
+        return(false);
+    }
+
+    EEPROMProgramNonBlocking(ui32Data, ui32Offset);
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns HAL_CONFIG_BUSY while the last word started by HALConfigProgram()
+// is being written, then HAL_CONFIG_DONE or HAL_CONFIG_FAILED.
+//
+//*****************************************************************************
+uint32_t
+HALConfigStatus(void)
+{
+    uint32_t ui32Status;
+
+    ui32Status = EEPROMStatusGet();
+    if(ui32Status & EEPROM_RC_WORKING)
+    {
+        return(HAL_CONFIG_BUSY);
+    }
+
+    return((ui32Status & (EEPROM_RC_NOPERM | EEPROM_RC_WRBUSY)) ?
+           HAL_CONFIG_FAILED : HAL_CONFIG_DONE);
+}
@@ -0,0 +1,244 @@
+//*****************************************************************************
+//
+// inputevent.c - Timestamped input change events for the Mame control device.
+//
+// Every accepted change of an input is written to a ring of events carrying
+// the input, its new level and the microsecond time at which the change was
+// first sampled.  Time is the free running microsecond count from
+// HALTimeGet(), which wraps every 71 minutes, so differences of two times
+// are always correct.
+//
+// The ring has a single producer, the sampling interrupts, and a single
+// consumer, the main loop.  The producer only ever writes the head index
+// and the consumer only the tail, so neither side needs to lock the other
+// out.  The GPIO and SysTick interrupts that both sample run at the same
+// priority, never preempt one another, and so count as one producer.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hal.h"
+#include "inputevent.h"
+
+//*****************************************************************************
+//
+// A change that the debouncer has not accepted this many microseconds after
+// it was first seen was only a glitch, and its edge time is forgotten.
+//
+//*****************************************************************************
+#ifndef INPUT_EVENT_GLITCH_US
+#define INPUT_EVENT_GLITCH_US   20000
+#endif
+
+//*****************************************************************************
+//
+// The event ring.  g_ui32EventHead is only written by InputEventSample() and
+// g_ui32EventTail only by InputEventRead().  Both run freely and are masked
+// when used as an index.
+//
+//*****************************************************************************
+static tInputEvent g_psEvents[INPUT_EVENT_SLOTS];
+static volatile uint32_t g_ui32EventHead;
+static volatile uint32_t g_ui32EventTail;
+static volatile uint32_t g_ui32EventDropped;
+
+//*****************************************************************************
+//
+// The accepted input word seen on the last sample, the inputs that have moved
+// away from their accepted level without being accepted yet, and when each of
+// those moves was first seen.
+//
+//*****************************************************************************
+static uint32_t g_ui32LastDebounced;
+static uint32_t g_ui32EdgePending;
+static uint32_t g_pui32EdgeTime[32];
+
+//*****************************************************************************
+//
+// Empties the ring.  HALInit() must have started the microsecond time.
+//
+// \param ui32Initial is the debounced input word to start from.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+InputEventInit(uint32_t ui32Initial)
+{
+    g_ui32EventHead = 0;
+    g_ui32EventTail = 0;
+    g_ui32EventDropped = 0;
+    g_ui32LastDebounced = ui32Initial;
+    g_ui32EdgePending = 0;
+}
+
+//*****************************************************************************
+//
+// Returns the free running microsecond time.
+//
+//*****************************************************************************
+uint32_t
+InputEventTimeGet(void)
+{
+    return(HALTimeGet());
+}
+
+//*****************************************************************************
+//
+// Records the changes in one input sample taken at a given time.  This is
+// the producer side of the ring and must be called from the sampling
+// interrupts only.
+//
+// \param ui32Raw is the raw sample with a set bit for each closed input.
+// \param ui32Debounced is the debounced input word after this sample.
+// \param ui32Now is the microsecond time the sample was taken.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+InputEventSampleAt(uint32_t ui32Raw, uint32_t ui32Debounced, uint32_t ui32Now)
+{
+    uint32_t ui32Bits, ui32Accepted, ui32Head;
+    uint32_t ui32Delay;
+    uint8_t ui8Input;
+    tInputEvent *psEvent;
+
+    //
+    // A move that has not been accepted long after it was first seen was
+    // only a glitch, so forget when it happened.
+    //
+    ui32Bits = g_ui32EdgePending;
+    for(ui8Input = 0; ui32Bits; ui8Input++, ui32Bits >>= 1)
+    {
+        if((ui32Bits & 1) &&
+           ((ui32Now - g_pui32EdgeTime[ui8Input]) > INPUT_EVENT_GLITCH_US))
+        {
+            g_ui32EdgePending &= ~((uint32_t)1 << ui8Input);
+        }
+    }
+
+    //
+    // Note when each input first leaves its accepted level.
+    //
+    ui32Bits = (ui32Raw ^ ui32Debounced) & ~g_ui32EdgePending;
+    g_ui32EdgePending |= ui32Bits;
+    for(ui8Input = 0; ui32Bits; ui8Input++, ui32Bits >>= 1)
+    {
+        if(ui32Bits & 1)
+        {
+            g_pui32EdgeTime[ui8Input] = ui32Now;
+        }
+    }
+
+    //
+    // Queue an event for every change the debouncer accepted on this sample.
+    //
+    ui32Accepted = ui32Debounced ^ g_ui32LastDebounced;
+    g_ui32LastDebounced = ui32Debounced;
+    ui32Bits = ui32Accepted;
+    for(ui8Input = 0; ui32Bits; ui8Input++, ui32Bits >>= 1)
+    {
+        if(!(ui32Bits & 1))
+        {
+            continue;
+        }
+
+        ui32Head = g_ui32EventHead;
+        if((ui32Head - g_ui32EventTail) >= INPUT_EVENT_SLOTS)
+        {
+            g_ui32EventDropped++;
+            continue;
+        }
+
+        psEvent = &g_psEvents[ui32Head & (INPUT_EVENT_SLOTS - 1)];
+        if(g_ui32EdgePending & ((uint32_t)1 << ui8Input))
+        {
+            psEvent->ui32Time = g_pui32EdgeTime[ui8Input];
+        }
+        else
+        {
+            psEvent->ui32Time = ui32Now;
+        }
+        ui32Delay = ui32Now - psEvent->ui32Time;
+        psEvent->ui16Debounce = (ui32Delay > 0xFFFF) ? 0xFFFF : ui32Delay;
+        psEvent->ui8Input = ui8Input;
+        psEvent->ui8Level = (ui32Debounced >> ui8Input) & 1;
+
+        //
+        // The entry is complete before the consumer can see it.
+        //
+        g_ui32EventHead = ui32Head + 1;
+    }
+    g_ui32EdgePending &= ~ui32Accepted;
+}
+
+//*****************************************************************************
+//
+// Records the changes in one input sample taken now.
+//
+// \param ui32Raw is the raw sample with a set bit for each closed input.
+// \param ui32Debounced is the debounced input word after this sample.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+InputEventSample(uint32_t ui32Raw, uint32_t ui32Debounced)
+{
+    InputEventSampleAt(ui32Raw, ui32Debounced, InputEventTimeGet());
+}
+
+//*****************************************************************************
+//
+// Takes the oldest event from the ring.  This is the consumer side of the
+// ring and must only be called from the main loop.
+//
+// \param psEvent is filled with the event.
+//
+// \return Returns false if the ring was empty.
+//
+//*****************************************************************************
+bool
+InputEventRead(tInputEvent *psEvent)
+{
+    uint32_t ui32Tail;
+
+    ui32Tail = g_ui32EventTail;
+    if(ui32Tail == g_ui32EventHead)
+    {
+        return(false);
+    }
+
+    *psEvent = g_psEvents[ui32Tail & (INPUT_EVENT_SLOTS - 1)];
+
+    //
+    // Only release the slot once it has been copied out.
+    //
+    g_ui32EventTail = ui32Tail + 1;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns the number of events waiting in the ring.
+//
+//*****************************************************************************
+uint32_t
+InputEventCount(void)
+{
+    return(g_ui32EventHead - g_ui32EventTail);
+}
+
+//*****************************************************************************
+//
+// Returns the number of events lost because the ring was full.
+//
+//*****************************************************************************
+uint32_t
+InputEventDropped(void)
+{
+    return(g_ui32EventDropped);
+}
@@ -0,0 +1,67 @@
+//*****************************************************************************
+//
+// inputevent.h - Timestamped input change events for the Mame control device.
+//
+//*****************************************************************************
+
+#ifndef __INPUTEVENT_H__
+#define __INPUTEVENT_H__
+
+//*****************************************************************************
+//
+// The number of events the ring can hold.  This must be a power of two.
+//
+//*****************************************************************************
+#ifndef INPUT_EVENT_SLOTS
+#define INPUT_EVENT_SLOTS       64
+#endif
+
+#if (INPUT_EVENT_SLOTS & (INPUT_EVENT_SLOTS - 1)) != 0
+#error "INPUT_EVENT_SLOTS must be a power of two"
+#endif
+
+//*****************************************************************************
+//
+// One accepted change of a single input.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The microsecond time of the first sample that saw the new level.
+    //
+    uint32_t ui32Time;
+
+    //
+    // Microseconds from that first sample until the debouncer accepted the
+    // change, saturating at 0xFFFF.
+    //
+    uint16_t ui16Debounce;
+
+    //
+    // The input, as its bit number in the packed input word.
+    //
+    uint8_t ui8Input;
+
+    //
+    // The new level, 1 for closed and 0 for open.
+    //
+    uint8_t ui8Level;
+}
+tInputEvent;
+
+//*****************************************************************************
+//
+// Prototypes for the input event functions.
+//
+//*****************************************************************************
+extern void InputEventInit(uint32_t ui32Initial);
+extern uint32_t InputEventTimeGet(void);
+extern void InputEventSample(uint32_t ui32Raw, uint32_t ui32Debounced);
+extern void InputEventSampleAt(uint32_t ui32Raw, uint32_t ui32Debounced,
+                               uint32_t ui32Now);
+extern bool InputEventRead(tInputEvent *psEvent);
+extern uint32_t InputEventCount(void);
+extern uint32_t InputEventDropped(void);
+
+#endif // __INPUTEVENT_H__
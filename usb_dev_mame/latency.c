@@ -0,0 +1,113 @@
+//*****************************************************************************
+//
+// latency.c - Input latency histograms for the Mame control device.
+//
+// Each stage of getting an input change to the host is timed in microseconds
+// and counted into a histogram with power of two buckets.  The host reads
+// the histograms through a vendor feature report on the HID interface, which
+// makes it possible to check an installed cabinet without a logic analyser.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usblib/device/usbdhidmamecfg.h"
+#include "latency.h"
+
+#if LATENCY_REPORT_SIZE != (CUSTOMHID_LATENCY_SIZE + 1)
+#error "LATENCY_REPORT_SIZE does not match CUSTOMHID_LATENCY_SIZE"
+#endif
+
+//*****************************************************************************
+//
+// The histogram counts.
+//
+//*****************************************************************************
+static volatile uint16_t g_ppui16Latency[LATENCY_NUM_HISTS][LATENCY_BUCKETS];
+
+//*****************************************************************************
+//
+// The feature report handed to the USB library.  This has to stay put until
+// the control transfer is finished, so it is not built on the stack.
+//
+//*****************************************************************************
+static uint8_t g_pui8LatencyReport[LATENCY_REPORT_SIZE];
+
+//*****************************************************************************
+//
+// Clears every histogram.
+//
+//*****************************************************************************
+void
+LatencyReset(void)
+{
+    uint32_t ui32Hist, ui32Bucket;
+
+    for(ui32Hist = 0; ui32Hist < LATENCY_NUM_HISTS; ui32Hist++)
+    {
+        for(ui32Bucket = 0; ui32Bucket < LATENCY_BUCKETS; ui32Bucket++)
+        {
+            g_ppui16Latency[ui32Hist][ui32Bucket] = 0;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Counts one measurement.
+//
+// \param ui32Hist is the stage that was timed, one of the LATENCY_ values.
+// \param ui32Us is the time taken in microseconds.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+LatencyRecord(uint32_t ui32Hist, uint32_t ui32Us)
+{
+    uint32_t ui32Bucket;
+
+    //
+    // The bucket is the position of the highest set bit.
+    //
+    for(ui32Bucket = 0; (ui32Us >> 1) && (ui32Bucket < (LATENCY_BUCKETS - 1));
+        ui32Bucket++)
+    {
+        ui32Us >>= 1;
+    }
+
+    if(g_ppui16Latency[ui32Hist][ui32Bucket] != 0xFFFF)
+    {
+        g_ppui16Latency[ui32Hist][ui32Bucket]++;
+    }
+}
+
+//*****************************************************************************
+//
+// Builds the latency feature report and returns a pointer to it.  The report
+// is LATENCY_REPORT_SIZE bytes long, including the report ID.
+//
+//*****************************************************************************
+uint8_t *
+LatencyReportGet(void)
+{
+    uint32_t ui32Hist, ui32Bucket;
+    uint8_t *pui8Count;
+
+    g_pui8LatencyReport[0] = CUSTOMHID_REPORT_ID_LATENCY;
+    g_pui8LatencyReport[1] = LATENCY_REPORT_VERSION;
+    g_pui8LatencyReport[2] = LATENCY_BUCKETS;
+    g_pui8LatencyReport[3] = LATENCY_NUM_HISTS;
+
+    pui8Count = &g_pui8LatencyReport[4];
+    for(ui32Hist = 0; ui32Hist < LATENCY_NUM_HISTS; ui32Hist++)
+    {
+        for(ui32Bucket = 0; ui32Bucket < LATENCY_BUCKETS; ui32Bucket++)
+        {
+            *pui8Count++ = g_ppui16Latency[ui32Hist][ui32Bucket] & 0xFF;
+            *pui8Count++ = g_ppui16Latency[ui32Hist][ui32Bucket] >> 8;
+        }
+    }
+
+    return(g_pui8LatencyReport);
+}
@@ -0,0 +1,66 @@
+//*****************************************************************************
+//
+// latency.h - Input latency histograms for the Mame control device.
+//
+//*****************************************************************************
+
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+//*****************************************************************************
+//
+// The stages that are timed, one histogram each.
+//
+// LATENCY_EDGE_TO_DEBOUNCE is from the first sample of a change until the
+// debouncer accepts it.
+//
+// LATENCY_DEBOUNCE_TO_QUEUE is from the accepted change until the report
+// carrying it is handed to the HID driver.
+//
+// LATENCY_QUEUE_TO_ACK is from handing a report to an idle HID driver until
+// the host acknowledges it.
+//
+//*****************************************************************************
+#define LATENCY_EDGE_TO_DEBOUNCE                                              \
+                                0
+#define LATENCY_DEBOUNCE_TO_QUEUE                                             \
+                                1
+#define LATENCY_QUEUE_TO_ACK    2
+#define LATENCY_NUM_HISTS       3
+
+//*****************************************************************************
+//
+// The number of buckets in each histogram.  Bucket 0 counts times under
+// 2 us, bucket n times from 2^n up to 2^(n+1) us and the last bucket
+// everything from 32.768 ms up.
+//
+//*****************************************************************************
+#define LATENCY_BUCKETS         16
+
+//*****************************************************************************
+//
+// The format version in byte 1 of the feature report.  The report is:
+//
+//  byte 0      CUSTOMHID_REPORT_ID_LATENCY
+//  byte 1      LATENCY_REPORT_VERSION
+//  byte 2      LATENCY_BUCKETS
+//  byte 3      LATENCY_NUM_HISTS
+//  byte 4 on   the bucket counts, 16 bit little endian, histogram by
+//              histogram.  Counts stop at 65535.
+//
+// Writing the feature report, with any contents, clears the histograms.
+//
+//*****************************************************************************
+#define LATENCY_REPORT_VERSION  1
+#define LATENCY_REPORT_SIZE     (4 + (LATENCY_NUM_HISTS * LATENCY_BUCKETS * 2))
+
+//*****************************************************************************
+//
+// Prototypes for the latency functions.
+//
+//*****************************************************************************
+extern void LatencyReset(void);
+extern void LatencyRecord(uint32_t ui32Hist, uint32_t ui32Us);
+extern uint8_t *LatencyReportGet(void);
+
+#endif // __LATENCY_H__
@@ -0,0 +1,524 @@
+//*****************************************************************************
+//
+// mousemotion.c - Trackball velocity smoothing, acceleration and sensitivity
+//                 for the Mame control device.
+//
+// Motion is handled per axis in 24.8 fixed point counts.  Counts read from
+// the encoder are held as pending until released, either all at once or, in
+// velocity mode, at the smoothed rate captured by the QEI module.  Released
+// motion is multiplied by the gain the acceleration curve gives for the
+// current speed and by the sensitivity of the axis, and the part below a
+// whole count is kept for the next call so that no motion is lost to
+// rounding.
+//
+// The sensitivities and the curve can be read and written through a feature
+// report, and are saved in the configuration store so that each cabinet keeps
+// its own tuning.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usblib/device/usbdhidmamecfg.h"
+#include "hal.h"
+#include "mousemotion.h"
+#include "config.h"
+
+#if MOUSE_CONFIG_REPORT_SIZE != (CUSTOMHID_MOUSE_CONFIG_SIZE + 1)
+#error "MOUSE_CONFIG_REPORT_SIZE does not match CUSTOMHID_MOUSE_CONFIG_SIZE"
+#endif
+
+//*****************************************************************************
+//
+// One count in the fixed point used for motion and gains.
+//
+//*****************************************************************************
+#define MOUSE_ONE               256
+
+//*****************************************************************************
+//
+// A captured velocity in counts per capture period, scaled to fixed point
+// counts per millisecond.
+//
+//*****************************************************************************
+#define MOUSE_VELOCITY_SCALE    (MOUSE_ONE * (MOUSE_VELOCITY_HZ / 1000))
+
+//*****************************************************************************
+//
+// Below this smoothed speed, a quarter count per millisecond, the ball is
+// taken to have stopped.
+//
+//*****************************************************************************
+#define MOUSE_VELOCITY_STOP     (MOUSE_ONE / 4)
+
+//*****************************************************************************
+//
+// Limits that keep the fixed point arithmetic in range.  A longer gap
+// between calls is treated as this many microseconds, and more counts than
+// this in one call are clamped.
+//
+//*****************************************************************************
+#define MOUSE_ELAPSED_MAX       100000
+#define MOUSE_COUNTS_MAX        0x007FFFFF
+
+//*****************************************************************************
+//
+// The acceleration curves, as gains where MOUSE_ONE is 1.0, indexed by speed
+// in counts per millisecond.
+//
+//*****************************************************************************
+static const uint16_t g_ppui16MouseAccel[MOUSE_ACCEL_CURVES]
+                                        [MOUSE_ACCEL_STEPS] =
+{
+    //
+    // MOUSE_ACCEL_LINEAR
+    //
+    {
+        256, 256, 256, 256, 256, 256, 256, 256,
+        256, 256, 256, 256, 256, 256, 256, 256,
+        256, 256, 256, 256, 256, 256, 256, 256,
+        256, 256, 256, 256, 256, 256, 256, 256
+    },
+
+    //
+    // MOUSE_ACCEL_MILD
+    //
+    {
+        256, 256, 256, 260, 265, 269, 274, 278,
+        282, 287, 291, 296, 300, 305, 309, 313,
+        318, 322, 327, 331, 335, 340, 344, 349,
+        353, 358, 362, 366, 371, 375, 380, 384
+    },
+
+    //
+    // MOUSE_ACCEL_STRONG
+    //
+    {
+        256, 256, 256, 256, 258, 260, 263, 267,
+        272, 278, 285, 293, 302, 311, 322, 333,
+        345, 359, 373, 388, 404, 421, 439, 457,
+        477, 498, 519, 541, 565, 589, 614, 640
+    },
+
+    //
+    // MOUSE_ACCEL_PRECISE
+    //
+    {
+        128, 144, 160, 176, 192, 208, 224, 240,
+        256, 256, 256, 256, 256, 256, 256, 256,
+        256, 256, 256, 256, 256, 256, 256, 256,
+        256, 256, 256, 256, 256, 256, 256, 256
+    }
+};
+
+//*****************************************************************************
+//
+// The motion state of one axis.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The smoothed velocity in fixed point counts per millisecond.  Written
+    // by the QEI interrupt in velocity mode.
+    //
+    volatile int32_t i32Velocity;
+
+    //
+    // Counts read from the encoder and not yet released.
+    //
+    int32_t i32Pending;
+
+    //
+    // Accelerated motion below a whole count, carried to the next call.
+    //
+    int32_t i32Fraction;
+}
+tMouseAxis;
+
+static tMouseAxis g_psMouseAxes[2];
+
+//*****************************************************************************
+//
+// The acceleration curve and the sensitivity of each axis in use.
+//
+//*****************************************************************************
+static volatile uint32_t g_ui32MouseCurve;
+static volatile uint16_t g_pui16MouseSensitivity[2];
+
+//*****************************************************************************
+//
+// The settings written by the feature report, waiting for MouseConfigUpdate()
+// to put them in use.  The flag is set from the USB interrupt once the
+// values are in place.
+//
+//*****************************************************************************
+static uint32_t g_ui32MouseConfigCurve;
+static uint16_t g_pui16MouseConfigSensitivity[2];
+static volatile bool g_bMouseConfigPending;
+
+//*****************************************************************************
+//
+// The buffer the settings feature report is built in.
+//
+//*****************************************************************************
+static uint8_t g_pui8MouseConfigReport[MOUSE_CONFIG_REPORT_SIZE];
+
+//*****************************************************************************
+//
+// Resets the motion state of both axes and the settings to the
+// MOUSE_ACCEL_CURVE and MOUSE_SENSITIVITY defaults.  Saved settings are
+// applied over these by ConfigInit().
+//
+// \return None.
+//
+//*****************************************************************************
+void
+MouseMotionInit(void)
+{
+    g_ui32MouseCurve = MOUSE_ACCEL_CURVE;
+    g_pui16MouseSensitivity[0] = MOUSE_SENSITIVITY_X;
+    g_pui16MouseSensitivity[1] = MOUSE_SENSITIVITY_Y;
+    g_bMouseConfigPending = false;
+
+    MouseMotionReset();
+}
+
+//*****************************************************************************
+//
+// Drops any motion that has been read but not yet released, and forgets the
+// velocity.  Used when the host starts listening so that older motion is not
+// sent.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+MouseMotionReset(void)
+{
+    uint32_t ui32Axis;
+
+    for(ui32Axis = 0; ui32Axis < 2; ui32Axis++)
+    {
+        g_psMouseAxes[ui32Axis].i32Velocity = 0;
+        g_psMouseAxes[ui32Axis].i32Pending = 0;
+        g_psMouseAxes[ui32Axis].i32Fraction = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Adds a velocity capture to the smoothed velocity of an axis.
+//
+// \param ui32Axis is the axis, HAL_QEI_X or HAL_QEI_Y.
+// \param i32Counts is the signed number of counts in the last capture
+// period of 1/MOUSE_VELOCITY_HZ seconds.
+//
+// This is called from the QEI interrupt at the end of every capture period.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+MouseVelocitySample(uint32_t ui32Axis, int32_t i32Counts)
+{
+    int32_t i32Velocity;
+
+    i32Velocity = g_psMouseAxes[ui32Axis].i32Velocity;
+    i32Velocity += ((i32Counts * MOUSE_VELOCITY_SCALE) - i32Velocity) /
+                   MOUSE_VELOCITY_WEIGHT;
+    g_psMouseAxes[ui32Axis].i32Velocity = i32Velocity;
+}
+
+#if MOUSE_VELOCITY_ENABLE
+//*****************************************************************************
+//
+// Returns how much of the pending motion of an axis to release after
+// ui32Elapsed microseconds at the smoothed velocity.
+//
+//*****************************************************************************
+static int32_t
+MouseVelocityRelease(tMouseAxis *psAxis, uint32_t ui32Elapsed)
+{
+    int32_t i32Velocity, i32Release, i32Lag;
+
+    i32Velocity = psAxis->i32Velocity;
+
+    //
+    // Release everything once the ball stops or turns back so that nothing
+    // is left hanging.
+    //
+    if(((i32Velocity < MOUSE_VELOCITY_STOP) &&
+        (i32Velocity > -MOUSE_VELOCITY_STOP)) ||
+       ((i32Velocity ^ psAxis->i32Pending) < 0))
+    {
+        return(psAxis->i32Pending);
+    }
+
+    i32Release = (int32_t)(((int64_t)i32Velocity * ui32Elapsed) / 1000);
+    if((i32Release > 0) ? (i32Release > psAxis->i32Pending) :
+                          (i32Release < psAxis->i32Pending))
+    {
+        i32Release = psAxis->i32Pending;
+    }
+
+    //
+    // Never fall more than MOUSE_VELOCITY_LAG counts behind the encoder.
+    //
+    i32Lag = psAxis->i32Pending - i32Release;
+    if(i32Lag > (MOUSE_VELOCITY_LAG * MOUSE_ONE))
+    {
+        i32Release = psAxis->i32Pending - (MOUSE_VELOCITY_LAG * MOUSE_ONE);
+    }
+    else if(i32Lag < -(MOUSE_VELOCITY_LAG * MOUSE_ONE))
+    {
+        i32Release = psAxis->i32Pending + (MOUSE_VELOCITY_LAG * MOUSE_ONE);
+    }
+
+    return(i32Release);
+}
+#endif
+
+//*****************************************************************************
+//
+// Turns encoder counts into the motion to report.
+//
+// \param ui32Axis is the axis, HAL_QEI_X or HAL_QEI_Y.
+// \param i32Counts is the signed number of counts read from the encoder
+// since the last call.
+// \param ui32Elapsed is the time in microseconds since the last call.
+//
+// In velocity mode the counts are released at the smoothed velocity,
+// otherwise they are released at once.  The released motion is then scaled
+// by the acceleration curve and the sensitivity of the axis.
+//
+// \return Returns the whole counts of motion to report.
+//
+//*****************************************************************************
+int32_t
+MouseMotionFilter(uint32_t ui32Axis, int32_t i32Counts, uint32_t ui32Elapsed)
+{
+    tMouseAxis *psAxis;
+    int32_t i32Release, i32Out;
+    uint32_t ui32Speed;
+
+    psAxis = &g_psMouseAxes[ui32Axis];
+
+    if(ui32Elapsed > MOUSE_ELAPSED_MAX)
+    {
+        ui32Elapsed = MOUSE_ELAPSED_MAX;
+    }
+    else if(!ui32Elapsed)
+    {
+        ui32Elapsed = 1;
+    }
+    if(i32Counts > MOUSE_COUNTS_MAX)
+    {
+        i32Counts = MOUSE_COUNTS_MAX;
+    }
+    else if(i32Counts < -MOUSE_COUNTS_MAX)
+    {
+        i32Counts = -MOUSE_COUNTS_MAX;
+    }
+
+    psAxis->i32Pending += i32Counts * MOUSE_ONE;
+#if MOUSE_VELOCITY_ENABLE
+    i32Release = MouseVelocityRelease(psAxis, ui32Elapsed);
+#else
+    i32Release = psAxis->i32Pending;
+#endif
+    psAxis->i32Pending -= i32Release;
+
+    //
+    // Look up the gain for the speed of the released motion.
+    //
+    ui32Speed = (uint32_t)(((int64_t)((i32Release < 0) ? -i32Release :
+                                                         i32Release) * 1000) /
+                           ((int64_t)ui32Elapsed * MOUSE_ONE));
+    if(ui32Speed >= MOUSE_ACCEL_STEPS)
+    {
+        ui32Speed = MOUSE_ACCEL_STEPS - 1;
+    }
+
+    psAxis->i32Fraction +=
+        (int32_t)(((int64_t)i32Release *
+                   g_ppui16MouseAccel[g_ui32MouseCurve][ui32Speed] *
+                   g_pui16MouseSensitivity[ui32Axis]) /
+                  (MOUSE_ONE * MOUSE_ONE));
+    i32Out = psAxis->i32Fraction / MOUSE_ONE;
+    psAxis->i32Fraction -= i32Out * MOUSE_ONE;
+
+    return(i32Out);
+}
+
+//*****************************************************************************
+//
+// Selects the acceleration curve.
+//
+// \param ui32Curve is one of the MOUSE_ACCEL_ values.
+//
+// \return Returns false, leaving the curve unchanged, if ui32Curve is not a
+// valid curve.
+//
+//*****************************************************************************
+bool
+MouseAccelCurveSet(uint32_t ui32Curve)
+{
+    if(ui32Curve >= MOUSE_ACCEL_CURVES)
+    {
+        return(false);
+    }
+
+    g_ui32MouseCurve = ui32Curve;
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns the acceleration curve in use.
+//
+//*****************************************************************************
+uint32_t
+MouseAccelCurveGet(void)
+{
+    return(g_ui32MouseCurve);
+}
+
+//*****************************************************************************
+//
+// Sets the sensitivity of an axis.
+//
+// \param ui32Axis is the axis, HAL_QEI_X or HAL_QEI_Y.
+// \param ui32Sensitivity is the multiplier in 8.8 fixed point, from
+// MOUSE_SENSITIVITY_MIN to MOUSE_SENSITIVITY_MAX.
+//
+// Motion below a whole count is carried between reports, so a sensitivity
+// below 1.0 slows the ball without losing any of its motion.
+//
+// \return Returns false, leaving the sensitivity unchanged, if
+// ui32Sensitivity is out of range.
+//
+//*****************************************************************************
+bool
+MouseSensitivitySet(uint32_t ui32Axis, uint32_t ui32Sensitivity)
+{
+    if((ui32Sensitivity < MOUSE_SENSITIVITY_MIN) ||
+       (ui32Sensitivity > MOUSE_SENSITIVITY_MAX))
+    {
+        return(false);
+    }
+
+    g_pui16MouseSensitivity[ui32Axis] = ui32Sensitivity;
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns the sensitivity of an axis in 8.8 fixed point.
+//
+//*****************************************************************************
+uint32_t
+MouseSensitivityGet(uint32_t ui32Axis)
+{
+    return(g_pui16MouseSensitivity[ui32Axis]);
+}
+
+//*****************************************************************************
+//
+// Builds the settings feature report.
+//
+// \return Returns a pointer to the MOUSE_CONFIG_REPORT_SIZE byte report,
+// starting with its report ID.
+//
+//*****************************************************************************
+uint8_t *
+MouseConfigReportGet(void)
+{
+    g_pui8MouseConfigReport[0] = CUSTOMHID_REPORT_ID_MOUSE_CONFIG;
+    g_pui8MouseConfigReport[1] = MOUSE_CONFIG_REPORT_VERSION;
+    g_pui8MouseConfigReport[2] = g_pui16MouseSensitivity[0] & 0xFF;
+    g_pui8MouseConfigReport[3] = g_pui16MouseSensitivity[0] >> 8;
+    g_pui8MouseConfigReport[4] = g_pui16MouseSensitivity[1] & 0xFF;
+    g_pui8MouseConfigReport[5] = g_pui16MouseSensitivity[1] >> 8;
+    g_pui8MouseConfigReport[6] = g_ui32MouseCurve;
+
+    return(g_pui8MouseConfigReport);
+}
+
+//*****************************************************************************
+//
+// Applies a settings feature report written by the host.
+//
+// \param pui8Report is the report, starting with its report ID.
+// \param ui32Size is the length of the report in bytes.
+//
+// The settings are checked and staged, and go in use together at the start
+// of the next pipeline tick through MouseConfigUpdate(), so no report is
+// built from a mix of old and new settings.  This is called from the USB
+// interrupt.
+//
+// \return Returns false, changing nothing, if the report is short, of
+// another version or holds a value out of range.
+//
+//*****************************************************************************
+bool
+MouseConfigReportSet(const uint8_t *pui8Report, uint32_t ui32Size)
+{
+    uint32_t ui32X, ui32Y;
+
+    if((ui32Size < MOUSE_CONFIG_REPORT_SIZE) ||
+       (pui8Report[1] != MOUSE_CONFIG_REPORT_VERSION))
+    {
+        return(false);
+    }
+
+    ui32X = pui8Report[2] | (pui8Report[3] << 8);
+    ui32Y = pui8Report[4] | (pui8Report[5] << 8);
+    if((ui32X < MOUSE_SENSITIVITY_MIN) || (ui32X > MOUSE_SENSITIVITY_MAX) ||
+       (ui32Y < MOUSE_SENSITIVITY_MIN) || (ui32Y > MOUSE_SENSITIVITY_MAX) ||
+       (pui8Report[6] >= MOUSE_ACCEL_CURVES))
+    {
+        return(false);
+    }
+
+    g_pui16MouseConfigSensitivity[0] = ui32X;
+    g_pui16MouseConfigSensitivity[1] = ui32Y;
+    g_ui32MouseConfigCurve = pui8Report[6];
+    g_bMouseConfigPending = true;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Puts the settings staged by the feature report in use.  This is called by
+// SettingsUpdate() at the start of each pipeline tick, and costs nothing
+// unless the report has been written.  The settings are saved by
+// ConfigSave().
+//
+// \return None.
+//
+//*****************************************************************************
+void
+MouseConfigUpdate(void)
+{
+    bool bIntsOff;
+
+    if(!g_bMouseConfigPending)
+    {
+        return;
+    }
+
+    //
+    // Hold off the USB interrupt so that a report written meanwhile is not
+    // half taken and then dropped with the flag.
+    //
+    bIntsOff = HALIntDisable();
+    g_pui16MouseSensitivity[0] = g_pui16MouseConfigSensitivity[0];
+    g_pui16MouseSensitivity[1] = g_pui16MouseConfigSensitivity[1];
+    g_ui32MouseCurve = g_ui32MouseConfigCurve;
+    g_bMouseConfigPending = false;
+    HALIntRestore(bIntsOff);
+
+    ConfigChanged();
+}
@@ -0,0 +1,154 @@
+//*****************************************************************************
+//
+// mousemotion.h - Trackball velocity smoothing, acceleration and sensitivity
+//                 for the Mame control device.
+//
+//*****************************************************************************
+
+#ifndef __MOUSEMOTION_H__
+#define __MOUSEMOTION_H__
+
+//*****************************************************************************
+//
+// Set MOUSE_VELOCITY_ENABLE to 1 to have the QEI modules capture velocity
+// MOUSE_VELOCITY_HZ times a second.  Motion read from the encoders is then
+// released to the reports at the measured rate instead of in whatever whole
+// counts happened to land in each report interval, which takes out the
+// beat between the count rate and the report rate.
+//
+//*****************************************************************************
+#ifndef MOUSE_VELOCITY_ENABLE
+#define MOUSE_VELOCITY_ENABLE   0
+#endif
+
+#ifndef MOUSE_VELOCITY_HZ
+#define MOUSE_VELOCITY_HZ       8000
+#endif
+
+#if (MOUSE_VELOCITY_HZ < 1000) || (MOUSE_VELOCITY_HZ > 64000) ||              \
+    (MOUSE_VELOCITY_HZ % 1000)
+#error "MOUSE_VELOCITY_HZ must be a multiple of 1000 from 1000 to 64000"
+#endif
+
+//*****************************************************************************
+//
+// Velocity smoothing.  Each capture moves the smoothed velocity
+// 1/MOUSE_VELOCITY_WEIGHT of the way to the captured one.  The released
+// motion never lags the encoders by more than MOUSE_VELOCITY_LAG counts, and
+// everything left is released as soon as the ball stops or turns back.
+//
+//*****************************************************************************
+#ifndef MOUSE_VELOCITY_WEIGHT
+#define MOUSE_VELOCITY_WEIGHT   32
+#endif
+
+#ifndef MOUSE_VELOCITY_LAG
+#define MOUSE_VELOCITY_LAG      4
+#endif
+
+//*****************************************************************************
+//
+// Acceleration curves accepted by MouseAccelCurveSet().  Each is a table of
+// gains indexed by the speed of the ball in counts per millisecond.
+//
+// MOUSE_ACCEL_LINEAR passes motion through unchanged.
+//
+// MOUSE_ACCEL_MILD rises evenly to 1.5 times at MOUSE_ACCEL_STEPS - 1 counts
+// per millisecond and above.
+//
+// MOUSE_ACCEL_STRONG rises with the square of the speed to 2.5 times.
+//
+// MOUSE_ACCEL_PRECISE halves slow motion for fine aiming and is linear from
+// 8 counts per millisecond up.
+//
+//*****************************************************************************
+#define MOUSE_ACCEL_LINEAR      0
+#define MOUSE_ACCEL_MILD        1
+#define MOUSE_ACCEL_STRONG      2
+#define MOUSE_ACCEL_PRECISE     3
+#define MOUSE_ACCEL_CURVES      4
+
+#define MOUSE_ACCEL_STEPS       32
+
+//*****************************************************************************
+//
+// The curve in use at power up.
+//
+//*****************************************************************************
+#ifndef MOUSE_ACCEL_CURVE
+#define MOUSE_ACCEL_CURVE       MOUSE_ACCEL_LINEAR
+#endif
+
+#if MOUSE_ACCEL_CURVE >= MOUSE_ACCEL_CURVES
+#error "MOUSE_ACCEL_CURVE is not a valid curve"
+#endif
+
+//*****************************************************************************
+//
+// The sensitivity of each axis, as a multiplier in 8.8 fixed point so that
+// 256 is 1.0, used until one is saved through the settings feature report.
+// MouseSensitivitySet() accepts MOUSE_SENSITIVITY_MIN to
+// MOUSE_SENSITIVITY_MAX, 1/256 to 16 times.
+//
+//*****************************************************************************
+#ifndef MOUSE_SENSITIVITY
+#define MOUSE_SENSITIVITY       512
+#endif
+
+#ifndef MOUSE_SENSITIVITY_X
+#define MOUSE_SENSITIVITY_X     MOUSE_SENSITIVITY
+#endif
+
+#ifndef MOUSE_SENSITIVITY_Y
+#define MOUSE_SENSITIVITY_Y     MOUSE_SENSITIVITY
+#endif
+
+#define MOUSE_SENSITIVITY_MIN   1
+#define MOUSE_SENSITIVITY_MAX   4096
+
+#if (MOUSE_SENSITIVITY_X < MOUSE_SENSITIVITY_MIN) ||                          \
+    (MOUSE_SENSITIVITY_X > MOUSE_SENSITIVITY_MAX) ||                          \
+    (MOUSE_SENSITIVITY_Y < MOUSE_SENSITIVITY_MIN) ||                          \
+    (MOUSE_SENSITIVITY_Y > MOUSE_SENSITIVITY_MAX)
+#error "MOUSE_SENSITIVITY must be between 1 and 4096"
+#endif
+
+//*****************************************************************************
+//
+// The format version in byte 1 of the settings feature report.  The report
+// is:
+//
+//  byte 0      CUSTOMHID_REPORT_ID_MOUSE_CONFIG
+//  byte 1      MOUSE_CONFIG_REPORT_VERSION
+//  byte 2-3    X sensitivity, 16 bit little endian
+//  byte 4-5    Y sensitivity, 16 bit little endian
+//  byte 6      acceleration curve
+//
+// Writing the report with the same version applies the settings and saves
+// them.  A write with any value out of range changes nothing.
+//
+//*****************************************************************************
+#define MOUSE_CONFIG_REPORT_VERSION                                           \
+                                1
+#define MOUSE_CONFIG_REPORT_SIZE                                              \
+                                7
+
+//*****************************************************************************
+//
+// Prototypes for the trackball motion functions.
+//
+//*****************************************************************************
+extern void MouseMotionInit(void);
+extern void MouseMotionReset(void);
+extern void MouseVelocitySample(uint32_t ui32Axis, int32_t i32Counts);
+extern int32_t MouseMotionFilter(uint32_t ui32Axis, int32_t i32Counts,
+                                 uint32_t ui32Elapsed);
+extern bool MouseAccelCurveSet(uint32_t ui32Curve);
+extern uint32_t MouseAccelCurveGet(void);
+extern bool MouseSensitivitySet(uint32_t ui32Axis, uint32_t ui32Sensitivity);
+extern uint32_t MouseSensitivityGet(uint32_t ui32Axis);
+extern uint8_t *MouseConfigReportGet(void);
+extern bool MouseConfigReportSet(const uint8_t *pui8Report, uint32_t ui32Size);
+extern void MouseConfigUpdate(void);
+
+#endif // __MOUSEMOTION_H__
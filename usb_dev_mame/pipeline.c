@@ -0,0 +1,1056 @@
+//*****************************************************************************
+//
+// pipeline.c - Input sampling, debouncing and report scheduling for the Mame
+//              control device.
+//
+// Everything between the switch pins and the HID driver lives here: the
+// sample and debounce of the switches, the trackball counts, the packing of
+// reports and the pacing of reports against the SysTick.  The hardware is
+// only reached through hal.h, so the same source builds for the Launchpad
+// and, with host/hal_linux.c, as a host library.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usblib/device/usbdhidmamecfg.h"
+#include "hal.h"
+#include "debounce.h"
+#include "inputevent.h"
+#include "latency.h"
+#include "mousemotion.h"
+#include "softquad.h"
+#include "analog.h"
+#include "buttonmap.h"
+#include "config.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "settings.h"
+#include "cycleprofile.h"
+
+//*****************************************************************************
+//
+// The current minimum spacing between input reports in milliseconds.
+//
+//*****************************************************************************
+volatile uint32_t g_ui32ReportInterval = REPORT_INTERVAL_MS;
+
+//*****************************************************************************
+//
+// The inputs that use the eager debounce policy and their release hold-off.
+//
+//*****************************************************************************
+static uint32_t g_ui32EagerInputs;
+static uint32_t g_ui32EagerHoldOff;
+
+//*****************************************************************************
+//
+// The report bytes of each gamepad and the mouse buttons.  The _Debounced
+// arrays are the debounced inputs mapped by DebounceSwitches(), and the
+// others the state last queued for the host, so a report goes out when the
+// two differ.
+//
+//*****************************************************************************
+volatile signed char g_ui8Pad1[3];
+volatile signed char g_ui8Pad2[2];
+volatile signed char g_ui8Mouse[1];
+volatile signed char g_ui8Pad1_Debounced[3];
+volatile signed char g_ui8Pad2_Debounced[2];
+volatile signed char g_ui8Mouse_Debounced[1];
+
+//*****************************************************************************
+//
+// Trackball and spinner motion.  The encoder positions and the time at the
+// last reading and, for each axis, the scaled motion that no queued report
+// has carried yet.  Motion beyond the range of one report stays here for the
+// next, so no counts are lost however fast the ball spins.
+//
+//*****************************************************************************
+static uint32_t g_pui32QEILast[2];
+static uint32_t g_ui32QEITime;
+#if CUSTOMHID_SPINNER
+static uint32_t g_ui32SpinnerLast;
+#endif
+int32_t g_pi32MouseResidual[CUSTOMHID_MOUSE_AXES];
+
+//*****************************************************************************
+//
+// The most motion held back on each axis.  Only reached if the host stops
+// taking reports while the ball keeps turning.
+//
+//*****************************************************************************
+#define MOUSE_RESIDUAL_MAX      0x00FFFFFF
+
+#if CUSTOMHID_COMBINED_REPORT
+//*****************************************************************************
+//
+// The last combined report payload queued for the host.
+//
+//*****************************************************************************
+signed char g_pi8Combined[CUSTOMHID_COMBINED_SIZE];
+#endif
+
+#if CUSTOMHID_ANALOG_AXES
+//*****************************************************************************
+//
+// The last analog report payload queued for the host.
+//
+//*****************************************************************************
+signed char g_pi8Analog[CUSTOMHID_ANALOG_SIZE];
+#endif
+
+//*****************************************************************************
+//
+// Debounce state for the packed input word and the latest debounced word.
+//
+//*****************************************************************************
+tDebounceState g_sDebounce;
+volatile uint32_t g_ui32Debounced;
+
+#if INPUT_SAMPLE_HZ
+//*****************************************************************************
+//
+// Sampled capture.  The port levels and packed word of the last hardware
+// sample, the word handed to the debouncer, which only takes a level once it
+// has held for INPUT_SAMPLE_GLITCH_US, and when each input last changed.
+//
+//*****************************************************************************
+static uint8_t g_pui8SampleLevels[HAL_NUM_PORTS];
+static uint32_t g_ui32SampleLast;
+static uint32_t g_ui32SampleFiltered;
+static uint32_t g_pui32SampleChange[32];
+#endif
+
+//*****************************************************************************
+//
+// The most recent input event taken from the event ring, for inspection from
+// the debugger.
+//
+//*****************************************************************************
+tInputEvent g_sLastInputEvent;
+
+//*****************************************************************************
+//
+// Latency measurements in progress.  The time the oldest accepted change
+// that has not yet been reported was accepted, and the time and channel of a
+// report handed to an idle HID driver that the host has not yet
+// acknowledged.
+//
+//*****************************************************************************
+uint32_t g_ui32AcceptTime;
+bool g_bAcceptPending;
+volatile uint32_t g_ui32QueueTime;
+volatile uint32_t g_ui32AckChannel;
+volatile bool g_bAckPending;
+
+//*****************************************************************************
+//
+// The tick on which the last report was queued.
+//
+//*****************************************************************************
+static uint32_t g_ui32LastReport;
+
+//*****************************************************************************
+//
+// Reset the pipeline.  The HAL must already be initialized and this must run
+// before the first sample is taken.
+//
+//*****************************************************************************
+void
+PipelineInit(void)
+{
+    uint32_t ui32Idx;
+
+    InputEventInit(0);
+    LatencyReset();
+    ButtonMapInit();
+    g_bAcceptPending = false;
+    g_bAckPending = false;
+
+    DebounceInit(&g_sDebounce, 0);
+    DebounceEagerSet(DEBOUNCE_EAGER_INPUTS, DEBOUNCE_HOLDOFF);
+    g_ui32Debounced = 0;
+#if INPUT_SAMPLE_HZ
+    for(ui32Idx = 0; ui32Idx < HAL_NUM_PORTS; ui32Idx++)
+    {
+        g_pui8SampleLevels[ui32Idx] = 0xFF;
+    }
+    g_ui32SampleLast = 0;
+    g_ui32SampleFiltered = 0;
+    for(ui32Idx = 0; ui32Idx < 32; ui32Idx++)
+    {
+        g_pui32SampleChange[ui32Idx] = HALTimeGet() - INPUT_SAMPLE_GLITCH_US;
+    }
+#endif
+
+    MouseMotionInit();
+#if CUSTOMHID_SPINNER
+    SoftQuadInit();
+#endif
+#if CUSTOMHID_ANALOG_AXES
+    AnalogInit();
+    for(ui32Idx = 0; ui32Idx < CUSTOMHID_ANALOG_SIZE; ui32Idx++)
+    {
+        g_pi8Analog[ui32Idx] = 0;
+    }
+#endif
+
+    for(ui32Idx = 0; ui32Idx < 3; ui32Idx++)
+    {
+        g_ui8Pad1[ui32Idx] = 0x00;
+        g_ui8Pad1_Debounced[ui32Idx] = 0x00;
+    }
+    g_ui8Mouse[0] = 0x00;
+    g_ui8Mouse_Debounced[0] = 0x00;
+    for(ui32Idx = 0; ui32Idx < 2; ui32Idx++)
+    {
+        g_ui8Pad2[ui32Idx] = 0x00;
+        g_ui8Pad2_Debounced[ui32Idx] = 0x00;
+    }
+
+    //
+    // Every profile starts from the defaults set up above, and the saved
+    // settings then replace them.
+    //
+    ProfileInit();
+    SettingsInit();
+    ConfigInit();
+}
+
+//*****************************************************************************
+//
+// Called when the host configures the device so that the first change is
+// reported straight away.
+//
+//*****************************************************************************
+void
+PipelineConnect(uint32_t ui32Tick)
+{
+    uint32_t ui32Axis;
+
+    g_ui32LastReport = ui32Tick - g_ui32ReportInterval;
+
+    //
+    // Motion from before the host was listening is not sent.
+    //
+    g_pui32QEILast[HAL_QEI_X] = HALQEIPositionGet(HAL_QEI_X);
+    g_pui32QEILast[HAL_QEI_Y] = HALQEIPositionGet(HAL_QEI_Y);
+    g_ui32QEITime = HALTimeGet();
+#if CUSTOMHID_SPINNER
+    g_ui32SpinnerLast = SoftQuadPositionGet(SOFTQUAD_SPINNER);
+#endif
+    for(ui32Axis = 0; ui32Axis < CUSTOMHID_MOUSE_AXES; ui32Axis++)
+    {
+        g_pi32MouseResidual[ui32Axis] = 0;
+    }
+    MouseMotionReset();
+}
+
+//*****************************************************************************
+//
+// Queue a report for the host without waiting for it to be sent.  Returns
+// false if the driver could not take it, in which case the caller keeps the
+// change and offers it again on the next tick.
+//
+//*****************************************************************************
+bool SendHIDReport(char ReportNum, signed char ReportData[])
+{
+	uint32_t ui32Channel;
+	bool bIdle;
+
+	//
+	// In the composite build each report ID has an interface, and an IN
+	// endpoint, of its own.
+	//
+	ui32Channel = HALReportChannel(ReportNum);
+	bIdle = HALReportIdle(ui32Channel);
+
+	//
+	// A report that was refused, or queued but not started, is offered
+	// again on the next tick.  Offering it again replaces the queued copy
+	// rather than adding a second.
+	//
+	if(!HALReportSend(ui32Channel, ReportNum, ReportData))
+	{
+		return(false);
+	}
+
+	//
+	// The first report after an accepted change carries it to the driver.
+	// If the driver had nothing else to send, time this report to the host's
+	// acknowledgement as well.
+	//
+	if(g_bAcceptPending)
+	{
+		LatencyRecord(LATENCY_DEBOUNCE_TO_QUEUE,
+		              HALTimeGet() - g_ui32AcceptTime);
+		g_bAcceptPending = false;
+	}
+	if(bIdle && !g_bAckPending)
+	{
+		g_ui32QueueTime = HALTimeGet();
+		g_ui32AckChannel = ui32Channel;
+		g_bAckPending = true;
+	}
+
+	return(true);
+}
+
+//*****************************************************************************
+//
+// Pack the levels of the switch ports, indexed by HAL_PORT value, into one
+// input word through the switch pin map
+//
+//*****************************************************************************
+#define SWITCH_LEVEL(ui32Port)  pui8Levels[ui32Port]
+
+static uint32_t
+SwitchesPack(const uint8_t *pui8Levels)
+{
+	//
+	// The switches pull the pins low when closed, hence the inversion.
+	//
+	return(~PINMAP_INPUTS(SWITCH_LEVEL) & INPUT_SWITCHES);
+}
+
+//*****************************************************************************
+//
+// Sample every switch into one packed word.
+//
+//*****************************************************************************
+static uint32_t
+SwitchesScan(void)
+{
+	uint8_t pui8Levels[HAL_NUM_PORTS];
+
+	HALGPIOScan(pui8Levels);
+	return(SwitchesPack(pui8Levels));
+}
+
+//*****************************************************************************
+//
+// Run a sample through the debouncer and check the debounced inputs for the
+// profile hotkey.  Inputs set in ui32Closed are passed to the debouncer as
+// closed whatever their level.
+//
+//*****************************************************************************
+static void
+SwitchesStore(uint32_t ui32Sample, uint32_t ui32Closed)
+{
+	g_ui32Debounced = DebounceUpdate(&g_sDebounce, ui32Sample | ui32Closed);
+	InputEventSample(ui32Sample, g_ui32Debounced);
+	ProfileHotkey(g_ui32Debounced);
+}
+
+//*****************************************************************************
+//
+// Take a periodic sample of the switches
+//
+//*****************************************************************************
+void
+StoreSwitches(void)
+{
+	SwitchesStore(SwitchesScan(), 0);
+}
+
+//*****************************************************************************
+//
+// Take the sample of the switches made on the first edge after a quiet
+// period.  That edge is as likely to be a held leaf contact wiping open for
+// a few hundred microseconds as a release, and an integrating input accepts
+// a release on a single open sample.  So this sample can not complete a
+// release on its own: the sample is tried on a copy of the debouncer first,
+// and any input it would release is passed as closed, to be seen open again
+// by the next periodic sample.  An input that needs more open samples, such
+// as an eager one in its hold-off, still counts this one.
+//
+// \return Returns true if the sample changed the debounced inputs, so that
+// the caller can have the pipeline run at once rather than on the next tick.
+//
+//*****************************************************************************
+bool
+StoreSwitchesEdge(void)
+{
+	tDebounceState sTrial;
+	uint32_t ui32Sample, ui32Last;
+
+	ui32Sample = SwitchesScan();
+	ui32Last = g_ui32Debounced;
+	sTrial = g_sDebounce;
+	SwitchesStore(ui32Sample,
+	              ui32Last & ~DebounceUpdate(&sTrial, ui32Sample));
+
+	return(g_ui32Debounced != ui32Last);
+}
+
+#if INPUT_SAMPLE_HZ
+//*****************************************************************************
+//
+// Run the block of hardware samples taken since the last tick through the
+// glitch filter and then the debouncer.  Every sample is looked at, so the
+// edge times recorded for the latency figures are as fine as the sample
+// rate, but the debouncer still counts in ticks.
+//
+//*****************************************************************************
+void
+StoreSwitchSamples(void)
+{
+    const uint8_t *ppui8Samples[HAL_NUM_PORTS];
+    uint32_t ui32Count, ui32Slot, ui32Port, ui32Time, ui32Sample;
+    uint32_t ui32Bits, ui32Held;
+    uint8_t ui8Input;
+
+    //
+    // The last sample was taken just now and each one before it a sample
+    // time earlier.
+    //
+    ui32Time = HALTimeGet();
+    ui32Count = HALGPIOSamplesGet(ppui8Samples, &ui32Slot);
+    ui32Time -= ui32Count * HAL_SAMPLE_US;
+
+    for(; ui32Count; ui32Count--)
+    {
+        //
+        // Most samples match the one before, which is quicker to see from
+        // the port levels than from the packed word.
+        //
+        ui32Time += HAL_SAMPLE_US;
+        ui32Bits = 0;
+        for(ui32Port = 0; ui32Port < HAL_NUM_PORTS; ui32Port++)
+        {
+            ui32Bits |= g_pui8SampleLevels[ui32Port] ^
+                        ppui8Samples[ui32Port][ui32Slot];
+            g_pui8SampleLevels[ui32Port] = ppui8Samples[ui32Port][ui32Slot];
+        }
+        if(++ui32Slot == HAL_SAMPLE_SLOTS)
+        {
+            ui32Slot = 0;
+        }
+        if(!ui32Bits)
+        {
+            continue;
+        }
+
+        ui32Sample = SwitchesPack(g_pui8SampleLevels);
+        ui32Bits = ui32Sample ^ g_ui32SampleLast;
+        if(!ui32Bits)
+        {
+            continue;
+        }
+
+        //
+        // A level that held for the glitch time before this change is taken
+        // by the filter.  Anything shorter was noise.
+        //
+        ui32Held = 0;
+        for(ui8Input = 0; ui32Bits; ui8Input++, ui32Bits >>= 1)
+        {
+            if(ui32Bits & 1)
+            {
+                if((ui32Time - g_pui32SampleChange[ui8Input]) >=
+                   INPUT_SAMPLE_GLITCH_US)
+                {
+                    ui32Held |= (uint32_t)1 << ui8Input;
+                }
+                g_pui32SampleChange[ui8Input] = ui32Time;
+            }
+        }
+        g_ui32SampleFiltered = (g_ui32SampleFiltered & ~ui32Held) |
+                               (g_ui32SampleLast & ui32Held);
+        g_ui32SampleLast = ui32Sample;
+
+        //
+        // Note the time of the first sample at each new level.
+        //
+        InputEventSampleAt(ui32Sample, g_ui32Debounced, ui32Time);
+    }
+
+    //
+    // Levels still holding are taken as soon as they have held long enough.
+    //
+    ui32Bits = g_ui32SampleLast ^ g_ui32SampleFiltered;
+    for(ui8Input = 0; ui32Bits; ui8Input++, ui32Bits >>= 1)
+    {
+        if((ui32Bits & 1) &&
+           ((ui32Time + HAL_SAMPLE_US - g_pui32SampleChange[ui8Input]) >=
+            INPUT_SAMPLE_GLITCH_US))
+        {
+            g_ui32SampleFiltered ^= (uint32_t)1 << ui8Input;
+        }
+    }
+
+    g_ui32Debounced = DebounceUpdate(&g_sDebounce, g_ui32SampleFiltered);
+    InputEventSampleAt(g_ui32SampleFiltered, g_ui32Debounced, ui32Time);
+    ProfileHotkey(g_ui32Debounced);
+}
+#endif
+
+//*****************************************************************************
+//
+// Drain the input event ring into the latency histograms.  Called from the
+// main loop, which is the only consumer of the ring.
+//
+//*****************************************************************************
+void
+ServiceInputEvents(void)
+{
+	while(InputEventRead(&g_sLastInputEvent))
+	{
+		LatencyRecord(LATENCY_EDGE_TO_DEBOUNCE,
+		              g_sLastInputEvent.ui16Debounce);
+
+		//
+		// Time the next report from the oldest change it will carry.
+		//
+		if(!g_bAcceptPending)
+		{
+			g_ui32AcceptTime = g_sLastInputEvent.ui32Time +
+			                   g_sLastInputEvent.ui16Debounce;
+			g_bAcceptPending = true;
+		}
+	}
+}
+
+//*****************************************************************************
+//
+// Map the debounced input word onto the controls and unpack them into the
+// report byte groups
+//
+//*****************************************************************************
+void
+DebounceSwitches(void)
+{
+	uint32_t ui32State;
+
+	ui32State = ButtonMapApply(g_ui32Debounced);
+
+	g_ui8Pad1_Debounced[0] = ButtonMapHat(ui32State >> BUTTON_MAP_PAD1_DPAD_S);
+	g_ui8Pad1_Debounced[1] = (ui32State >> BUTTON_MAP_PAD1_BTN1_S) & 0xFF;
+	g_ui8Pad1_Debounced[2] = (ui32State >> (BUTTON_MAP_PAD1_BTN1_S + 8)) & 0x0F;
+	g_ui8Pad2_Debounced[0] = ButtonMapHat(ui32State >> BUTTON_MAP_PAD2_DPAD_S);
+	g_ui8Pad2_Debounced[1] = (ui32State >> BUTTON_MAP_PAD2_BTN1_S) & 0xFF;
+	g_ui8Mouse_Debounced[0] = (ui32State >> BUTTON_MAP_MOUSE_BTN_S) & 0x03;
+}
+
+//*****************************************************************************
+//
+// Add motion to what is still to be reported on an axis.
+//
+//*****************************************************************************
+static void
+MouseResidualAdd(uint32_t ui32Axis, int32_t i32Motion)
+{
+	int32_t i32Residual;
+
+	i32Residual = g_pi32MouseResidual[ui32Axis] + i32Motion;
+	if(i32Residual > MOUSE_RESIDUAL_MAX)
+	{
+		i32Residual = MOUSE_RESIDUAL_MAX;
+	}
+	else if(i32Residual < -MOUSE_RESIDUAL_MAX)
+	{
+		i32Residual = -MOUSE_RESIDUAL_MAX;
+	}
+	g_pi32MouseResidual[ui32Axis] = i32Residual;
+}
+
+//*****************************************************************************
+//
+// Add the encoder motion since the last reading, smoothed, accelerated and
+// scaled by the axis sensitivity, to the motion still to be reported.  The
+// spinner is passed through count for count.  The encoders count through 32
+// bits so the difference of two readings is right even across a wrap.
+//
+//*****************************************************************************
+void
+MouseAccumulate(void)
+{
+	uint32_t ui32Axis, ui32Position, ui32Time, ui32Elapsed;
+
+	ui32Time = HALTimeGet();
+	ui32Elapsed = ui32Time - g_ui32QEITime;
+	g_ui32QEITime = ui32Time;
+
+	for(ui32Axis = HAL_QEI_X; ui32Axis <= HAL_QEI_Y; ui32Axis++)
+	{
+		ui32Position = HALQEIPositionGet(ui32Axis);
+		MouseResidualAdd(ui32Axis,
+		                 MouseMotionFilter(ui32Axis,
+		                                   (int32_t)(ui32Position -
+		                                             g_pui32QEILast[ui32Axis]),
+		                                   ui32Elapsed));
+		g_pui32QEILast[ui32Axis] = ui32Position;
+	}
+
+#if CUSTOMHID_SPINNER
+	ui32Position = SoftQuadPositionGet(SOFTQUAD_SPINNER);
+	MouseResidualAdd(MOUSE_AXIS_SPINNER,
+	                 (int32_t)(ui32Position - g_ui32SpinnerLast));
+	g_ui32SpinnerLast = ui32Position;
+#endif
+}
+
+//*****************************************************************************
+//
+// Fill pi32Motion with as much of the motion still to be reported on each
+// axis as one report can carry.  Returns true if there is any.
+//
+//*****************************************************************************
+static bool
+MouseMotionGet(int32_t *pi32Motion)
+{
+	uint32_t ui32Axis;
+	bool bMoved = false;
+
+	for(ui32Axis = 0; ui32Axis < CUSTOMHID_MOUSE_AXES; ui32Axis++)
+	{
+		pi32Motion[ui32Axis] = g_pi32MouseResidual[ui32Axis];
+		if(pi32Motion[ui32Axis] > CUSTOMHID_MOUSE_MAX)
+		{
+			pi32Motion[ui32Axis] = CUSTOMHID_MOUSE_MAX;
+		}
+		else if(pi32Motion[ui32Axis] < -CUSTOMHID_MOUSE_MAX)
+		{
+			pi32Motion[ui32Axis] = -CUSTOMHID_MOUSE_MAX;
+		}
+		if(pi32Motion[ui32Axis])
+		{
+			bMoved = true;
+		}
+	}
+	return(bMoved);
+}
+
+//*****************************************************************************
+//
+// Take motion that a queued report carries off what is still to be reported.
+//
+//*****************************************************************************
+static void
+MouseMotionSent(const int32_t *pi32Motion)
+{
+	uint32_t ui32Axis;
+
+	for(ui32Axis = 0; ui32Axis < CUSTOMHID_MOUSE_AXES; ui32Axis++)
+	{
+		g_pi32MouseResidual[ui32Axis] -= pi32Motion[ui32Axis];
+	}
+}
+
+//*****************************************************************************
+//
+// Write the motion of each axis into a report, 8 or 16 bit little endian,
+// and return the byte after them.
+//
+//*****************************************************************************
+static signed char *
+MouseMotionPack(signed char *pi8Report, const int32_t *pi32Motion)
+{
+	uint32_t ui32Axis;
+
+	for(ui32Axis = 0; ui32Axis < CUSTOMHID_MOUSE_AXES; ui32Axis++)
+	{
+		*pi8Report++ = pi32Motion[ui32Axis];
+#if CUSTOMHID_MOUSE_16BIT
+		*pi8Report++ = pi32Motion[ui32Axis] >> 8;
+#endif
+	}
+	return(pi8Report);
+}
+
+#if CUSTOMHID_COMBINED_REPORT
+//*****************************************************************************
+//
+// Pack both players and the trackball into the combined report payload.  The
+// player one buttons and the player two plus trackball buttons are already
+// contiguous in the control word so each group moves with a single shift.
+// The trackball motion follows the first COMBINED_BUTTON_BYTES bytes.
+//
+//*****************************************************************************
+#define COMBINED_BUTTON_BYTES   4
+
+void
+PackCombinedReport(signed char *pi8Report, const int32_t *pi32Motion)
+{
+	uint32_t ui32State, ui32Buttons;
+
+	ui32State = ButtonMapApply(g_ui32Debounced);
+
+	pi8Report[0] = (ButtonMapHat(ui32State >> BUTTON_MAP_PAD1_DPAD_S) |
+	                (ButtonMapHat(ui32State >> BUTTON_MAP_PAD2_DPAD_S) << 4));
+
+	ui32Buttons = ((ui32State >> BUTTON_MAP_PAD1_BTN1_S) & 0x0FFF) |
+	              (((ui32State >> BUTTON_MAP_PAD2_BTN1_S) & 0x03FF) << 12);
+	pi8Report[1] = ui32Buttons;
+	pi8Report[2] = ui32Buttons >> 8;
+	pi8Report[3] = ui32Buttons >> 16;
+
+	MouseMotionPack(&pi8Report[COMBINED_BUTTON_BYTES], pi32Motion);
+}
+
+//*****************************************************************************
+//
+// Queue the combined report if anything has changed or the trackball has
+// moved.  Returns true if a report was queued.
+//
+//*****************************************************************************
+bool
+SendCombinedReport(void)
+{
+	signed char Combined[CUSTOMHID_COMBINED_SIZE];
+	bool Equals = true;
+	signed char i;
+	int32_t pi32Motion[CUSTOMHID_MOUSE_AXES];
+	bool bMoved;
+
+	bMoved = MouseMotionGet(pi32Motion);
+	PackCombinedReport(Combined, pi32Motion);
+
+	for (i=0; i<COMBINED_BUTTON_BYTES; i++)
+	{
+		if (g_pi8Combined[i] != Combined[i])
+		{
+			Equals = false;
+		}
+	}
+
+	//
+	// Motion is relative so any movement has to be sent even if it repeats
+	// the previous report.
+	//
+	if (Equals && !bMoved)
+	{
+		return(false);
+	}
+
+	//
+	// Queueing over a report that is still waiting would replace it and lose
+	// its motion, so wait for it to go out.
+	//
+	if (HALReportQueued(HALReportChannel(CUSTOMHID_REPORT_ID_COMBINED),
+	                    CUSTOMHID_REPORT_ID_COMBINED))
+	{
+		return(false);
+	}
+
+	if (!SendHIDReport(CUSTOMHID_REPORT_ID_COMBINED, Combined))
+	{
+		return(false);
+	}
+
+	for (i=0; i<CUSTOMHID_COMBINED_SIZE; i++)
+	{
+		g_pi8Combined[i] = Combined[i];
+	}
+	MouseMotionSent(pi32Motion);
+	return(true);
+}
+#endif
+
+#if CUSTOMHID_ANALOG_AXES
+//*****************************************************************************
+//
+// Queue the analog report if any axis has moved.  The values are absolute, so
+// a report still waiting in the queue can simply be replaced by a newer one.
+// Returns true if a report was queued.
+//
+//*****************************************************************************
+static bool
+SendAnalogReport(void)
+{
+	signed char Analog[CUSTOMHID_ANALOG_SIZE];
+	bool Equals = true;
+	signed char i;
+
+	AnalogUpdate();
+	AnalogReportPack(Analog);
+
+	for (i=0; i<CUSTOMHID_ANALOG_SIZE; i++)
+	{
+		if (g_pi8Analog[i] != Analog[i])
+		{
+			Equals = false;
+		}
+	}
+
+	if (Equals || !SendHIDReport(CUSTOMHID_REPORT_ID_ANALOG, Analog))
+	{
+		return(false);
+	}
+
+	for (i=0; i<CUSTOMHID_ANALOG_SIZE; i++)
+	{
+		g_pi8Analog[i] = Analog[i];
+	}
+	return(true);
+}
+#endif
+
+//*****************************************************************************
+//
+// Set the minimum spacing between input reports.  Shorter intervals cut the
+// latency of a change, longer ones reduce the load on the host.  Returns false
+// and leaves the interval unchanged if it is not 1, 2, 4 or 8 milliseconds.
+//
+//*****************************************************************************
+bool
+ReportIntervalSet(uint32_t ui32Interval)
+{
+    if((ui32Interval != 1) && (ui32Interval != 2) && (ui32Interval != 4) &&
+       (ui32Interval != 8))
+    {
+        return(false);
+    }
+
+    g_ui32ReportInterval = ui32Interval;
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Set which inputs use the eager debounce policy, and the hold-off of their
+// releases in samples.  All other inputs integrate.  Returns false and
+// changes nothing if the hold-off is not between 1 and DEBOUNCE_MAX_COUNT.
+//
+//*****************************************************************************
+bool
+DebounceEagerSet(uint32_t ui32Inputs, uint32_t ui32HoldOff)
+{
+    if((ui32HoldOff < 1) || (ui32HoldOff > DEBOUNCE_MAX_COUNT))
+    {
+        return(false);
+    }
+
+    ui32Inputs &= INPUT_ALL;
+    DebouncePolicySet(&g_sDebounce, INPUT_ALL & ~ui32Inputs,
+                      DEBOUNCE_INTEGRATE, 0);
+    DebouncePolicySet(&g_sDebounce, ui32Inputs, DEBOUNCE_EAGER, ui32HoldOff);
+    g_ui32EagerInputs = ui32Inputs;
+    g_ui32EagerHoldOff = ui32HoldOff;
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Return the inputs that use the eager debounce policy, and their hold-off
+// in pui32HoldOff.
+//
+//*****************************************************************************
+uint32_t
+DebounceEagerGet(uint32_t *pui32HoldOff)
+{
+    *pui32HoldOff = g_ui32EagerHoldOff;
+    return(g_ui32EagerInputs);
+}
+
+//*****************************************************************************
+//
+// Check buttons.  Returns true if any report was sent to the host.
+//
+//*****************************************************************************
+bool
+CustomHidChangeHandler(void)
+{
+#if !CUSTOMHID_COMBINED_REPORT
+	// Local arrays to pass to USB
+	//
+	signed char Pad1[3];
+	signed char Pad2[2];
+	signed char Mouse[CUSTOMHID_MOUSE_SIZE];
+	int32_t pi32Motion[CUSTOMHID_MOUSE_AXES];
+	bool bMoved;
+#endif
+	bool bSent = false;
+
+	//Get debounced switch states
+	//
+	DebounceSwitches();
+
+	// Get mouse position data
+	//
+	MouseAccumulate();
+
+#if CUSTOMHID_COMBINED_REPORT
+	//
+	// Everything goes out in one report so that a change on several devices
+	// at once reaches the host in a single frame.
+	//
+	bSent = SendCombinedReport();
+#else
+	bool Equals = true;
+	signed char i;
+	for (i=0; i<3; i++)		//Check for switch state change
+	{
+		if (g_ui8Pad1[i] != g_ui8Pad1_Debounced[i])
+		{
+			Equals = false;
+		}
+	}
+
+	if (!Equals)			//Send report if state has changed
+	{
+		Pad1[0] = g_ui8Pad1_Debounced[0];
+		Pad1[1] = g_ui8Pad1_Debounced[1];
+		Pad1[2] = g_ui8Pad1_Debounced[2];
+		if (SendHIDReport(1,Pad1))
+		{
+			g_ui8Pad1[0] = Pad1[0];		//Update old states once queued
+			g_ui8Pad1[1] = Pad1[1];
+			g_ui8Pad1[2] = Pad1[2];
+			bSent = true;
+		}
+	}
+
+	Equals = true;
+	for (i=0; i<2; i++)
+	{
+		if (g_ui8Pad2[i] != g_ui8Pad2_Debounced[i])
+		{
+			Equals = false;
+		}
+	}
+
+	if (!Equals)
+	{
+		Pad2[0] = g_ui8Pad2_Debounced[0];
+		Pad2[1] = g_ui8Pad2_Debounced[1];
+		if (SendHIDReport(2,Pad2))
+		{
+			g_ui8Pad2[0] = Pad2[0];
+			g_ui8Pad2[1] = Pad2[1];
+			bSent = true;
+		}
+	}
+
+	//
+	// Motion is relative so any movement has to be sent, but only once the
+	// last mouse report has left the queue.  Queueing over it would replace
+	// it and lose its motion.
+	//
+	bMoved = MouseMotionGet(pi32Motion);
+	if (((g_ui8Mouse[0] != g_ui8Mouse_Debounced[0]) || bMoved) &&
+	    !HALReportQueued(HALReportChannel(CUSTOMHID_REPORT_ID_MOUSE),
+	                     CUSTOMHID_REPORT_ID_MOUSE))
+	{
+		Mouse[0]=g_ui8Mouse_Debounced[0];
+		MouseMotionPack(&Mouse[1], pi32Motion);
+		if (SendHIDReport(CUSTOMHID_REPORT_ID_MOUSE,Mouse))
+		{
+			g_ui8Mouse[0] = Mouse[0];
+			MouseMotionSent(pi32Motion);
+			bSent = true;
+		}
+	}
+#endif
+
+#if CUSTOMHID_ANALOG_AXES
+	if (SendAnalogReport())
+	{
+		bSent = true;
+	}
+#endif
+
+	return(bSent);
+}
+
+//*****************************************************************************
+//
+// Returns true if the mapped switch state differs from the last one queued,
+// so a report still has to carry the change.
+//
+//*****************************************************************************
+static bool
+SwitchReportPending(void)
+{
+#if CUSTOMHID_COMBINED_REPORT
+	signed char Combined[CUSTOMHID_COMBINED_SIZE];
+	int32_t pi32Motion[CUSTOMHID_MOUSE_AXES] = {0};
+	signed char i;
+
+	PackCombinedReport(Combined, pi32Motion);
+	for (i=0; i<COMBINED_BUTTON_BYTES; i++)
+	{
+		if (g_pi8Combined[i] != Combined[i])
+		{
+			return(true);
+		}
+	}
+	return(false);
+#else
+	return((g_ui8Pad1[0] != g_ui8Pad1_Debounced[0]) ||
+	       (g_ui8Pad1[1] != g_ui8Pad1_Debounced[1]) ||
+	       (g_ui8Pad1[2] != g_ui8Pad1_Debounced[2]) ||
+	       (g_ui8Pad2[0] != g_ui8Pad2_Debounced[0]) ||
+	       (g_ui8Pad2[1] != g_ui8Pad2_Debounced[1]) ||
+	       (g_ui8Mouse[0] != g_ui8Mouse_Debounced[0]));
+#endif
+}
+
+//*****************************************************************************
+//
+// Run the pipeline for one SysTick.  Puts in any settings the host has
+// committed, drains the input events and, once the report interval has
+// passed since the last report, checks the inputs and queues whatever has
+// changed.  Returns true if any report was queued.
+//
+//*****************************************************************************
+bool
+PipelineTick(uint32_t ui32Tick)
+{
+	bool bSent;
+
+	//
+	// Settings the host has committed go in before anything for this tick
+	// is reported.
+	//
+	SettingsUpdate();
+	ServiceInputEvents();
+
+	if((ui32Tick - g_ui32LastReport) < g_ui32ReportInterval)
+	{
+		return(false);
+	}
+
+	//Check inputs and act accordingly
+	{
+		CYCLE_PROFILE_BEGIN(ui32ProfileStart);
+		bSent = CustomHidChangeHandler();
+		CYCLE_PROFILE_END(CYCLE_PROFILE_CHANGE, ui32ProfileStart);
+	}
+
+	//
+	// A change that left the mapped controls as they were, such as an input
+	// mapped to nothing or opposite directions cancelling on the hat, is
+	// never carried by a report.  Stop timing it so that the next unrelated
+	// report is not charged for the wait.
+	//
+	if(g_bAcceptPending && !SwitchReportPending())
+	{
+		g_bAcceptPending = false;
+	}
+
+	if(!bSent)
+	{
+		return(false);
+	}
+
+	g_ui32LastReport = ui32Tick;
+	return(true);
+}
+
+//*****************************************************************************
+//
+// Called when the host acknowledges a report on a channel.  Finishes timing
+// a report that was queued while that channel was idle, since this must be
+// the acknowledgement for it.
+//
+//*****************************************************************************
+void
+PipelineReportAcked(uint32_t ui32Channel)
+{
+	if(g_bAckPending && (g_ui32AckChannel == ui32Channel))
+	{
+		LatencyRecord(LATENCY_QUEUE_TO_ACK, HALTimeGet() - g_ui32QueueTime);
+		g_bAckPending = false;
+	}
+}
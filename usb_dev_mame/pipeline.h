@@ -0,0 +1,166 @@
+//*****************************************************************************
+//
+// pipeline.h - Input sampling, debouncing and report scheduling for the Mame
+//              control device.
+//
+//*****************************************************************************
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+//*****************************************************************************
+//
+// The default minimum spacing between input reports in SysTicks.  Inputs are
+// checked on every tick and a change is sent as soon as this much time has
+// passed since the previous report.  ReportIntervalSet() accepts 1, 2, 4 or 8.
+//
+//*****************************************************************************
+#define REPORT_INTERVAL_MS      1
+
+//*****************************************************************************
+//
+// Position of each input group in the packed input word.  Bits are set for
+// closed switches.
+//
+//*****************************************************************************
+#define INPUT_PAD1_DPAD_S       0
+#define INPUT_PAD1_BTN1_S       4
+#define INPUT_PAD1_BTN9_S       12
+#define INPUT_PAD2_DPAD_S       16
+#define INPUT_PAD2_BTN1_S       20
+#define INPUT_MOUSE_BTN_S       28
+#define INPUT_ALL               0x3FFFFFFF
+
+//*****************************************************************************
+//
+// The switch pin map.  Each row wires a run of pins on one port to a run of
+// bits in the packed input word, the lowest pin to the lowest bit:
+//
+//  GROUP(arg, port, first pin, pin count, first input bit)
+//
+// The pins of each port, the initialization in PortFunctionInit() and the
+// packing in the pipeline are all generated from this table, so rewiring a
+// cabinet only means editing it.  arg is passed through to GROUP unchanged.
+//
+//*****************************************************************************
+#define PINMAP_SWITCH_GROUPS(GROUP, arg)                                      \
+    GROUP(arg, HAL_PORTD, 0, 4, INPUT_PAD1_DPAD_S)      /* PD0-3 */           \
+    GROUP(arg, HAL_PORTA, 0, 8, INPUT_PAD1_BTN1_S)      /* PA0-7 */           \
+    GROUP(arg, HAL_PORTC, 0, 4, INPUT_PAD1_BTN9_S)      /* PC0-3 */           \
+    GROUP(arg, HAL_PORTE, 2, 4, INPUT_PAD2_DPAD_S)      /* PE2-5 */           \
+    GROUP(arg, HAL_PORTB, 0, 8, INPUT_PAD2_BTN1_S)      /* PB0-7 */           \
+    GROUP(arg, HAL_PORTE, 0, 2, INPUT_MOUSE_BTN_S)      /* PE0-1 */
+
+//*****************************************************************************
+//
+// Helpers that expand the pin map.  PINMAP_PINS(port) is the switch pins of
+// a port.  PINMAP_INPUTS(LEVEL) packs the pins for which LEVEL(port) is set
+// into input bits, which is the packing of the switches when LEVEL reads the
+// ports.  Both are constant expressions when LEVEL is.
+//
+//*****************************************************************************
+#define PINMAP_GROUP_PINS(ui32Port, ui32GroupPort, ui32First, ui32Count,      \
+                          ui32Bit)                                            \
+    | (((ui32GroupPort) == (ui32Port)) ?                                      \
+       (((1 << (ui32Count)) - 1) << (ui32First)) : 0)
+
+#define PINMAP_GROUP_INPUTS(LEVEL, ui32Port, ui32First, ui32Count, ui32Bit)   \
+    | ((((uint32_t)LEVEL(ui32Port) >> (ui32First)) &                          \
+        ((1 << (ui32Count)) - 1)) << (ui32Bit))
+
+#define PINMAP_PINS(ui32Port)                                                 \
+    (0 PINMAP_SWITCH_GROUPS(PINMAP_GROUP_PINS, ui32Port))
+
+#define PINMAP_INPUTS(LEVEL)                                                  \
+    (0 PINMAP_SWITCH_GROUPS(PINMAP_GROUP_INPUTS, LEVEL))
+
+//*****************************************************************************
+//
+// The switch inputs on each port.  Player two's joystick pins that carry
+// analog inputs are left out.
+//
+//*****************************************************************************
+#define PORTA_INPUT_PINS        PINMAP_PINS(HAL_PORTA)
+#define PORTB_INPUT_PINS        PINMAP_PINS(HAL_PORTB)
+#define PORTC_INPUT_PINS        PINMAP_PINS(HAL_PORTC)
+#define PORTD_INPUT_PINS        PINMAP_PINS(HAL_PORTD)
+#define PORTE_INPUT_PINS        (PINMAP_PINS(HAL_PORTE) & ~ANALOG_PORTE_PINS)
+
+//*****************************************************************************
+//
+// The bits of the packed input word that are read from switches.  The bits
+// of the analog pins read as always open.
+//
+//*****************************************************************************
+#define PINMAP_ANALOG_LEVEL(ui32Port)                                         \
+    (((ui32Port) == HAL_PORTE) ? ANALOG_PORTE_PINS : 0)
+
+#define INPUT_SWITCHES          (INPUT_ALL &                                  \
+                                 ~PINMAP_INPUTS(PINMAP_ANALOG_LEVEL))
+
+//*****************************************************************************
+//
+// The relative axes of the mouse and combined reports.  The spinner follows
+// the trackball axes when CUSTOMHID_SPINNER is set.
+//
+//*****************************************************************************
+#define MOUSE_AXIS_X            HAL_QEI_X
+#define MOUSE_AXIS_Y            HAL_QEI_Y
+#define MOUSE_AXIS_SPINNER      2
+
+//*****************************************************************************
+//
+// Inputs, as bits of the packed input word, that start with the eager
+// debounce policy.  All other inputs integrate.  DebounceEagerSet() can
+// change this at runtime.
+//
+//*****************************************************************************
+#ifndef DEBOUNCE_EAGER_INPUTS
+#define DEBOUNCE_EAGER_INPUTS   0
+#endif
+
+//*****************************************************************************
+//
+// In sampled capture a switch only takes a new level once the hardware
+// samples have seen it hold for INPUT_SAMPLE_GLITCH_US, so spikes shorter
+// than this never reach the debouncer however they fall against the tick.
+//
+//*****************************************************************************
+#ifndef INPUT_SAMPLE_GLITCH_US
+#define INPUT_SAMPLE_GLITCH_US  100
+#endif
+
+#if INPUT_SAMPLE_GLITCH_US > 1000
+#error "INPUT_SAMPLE_GLITCH_US must be at most 1000"
+#endif
+
+//*****************************************************************************
+//
+// Pipeline state shared with the interrupt handlers and the main loop.
+//
+//*****************************************************************************
+extern volatile uint32_t g_ui32ReportInterval;
+extern tDebounceState g_sDebounce;
+extern volatile uint32_t g_ui32Debounced;
+extern int32_t g_pi32MouseResidual[CUSTOMHID_MOUSE_AXES];
+
+//*****************************************************************************
+//
+// Prototypes for the pipeline functions.
+//
+//*****************************************************************************
+extern void PipelineInit(void);
+extern void PipelineConnect(uint32_t ui32Tick);
+extern bool PipelineTick(uint32_t ui32Tick);
+extern void PipelineReportAcked(uint32_t ui32Channel);
+extern void StoreSwitches(void);
+extern bool StoreSwitchesEdge(void);
+extern void StoreSwitchSamples(void);
+extern void DebounceSwitches(void);
+extern void MouseAccumulate(void);
+extern bool ReportIntervalSet(uint32_t ui32Interval);
+extern bool DebounceEagerSet(uint32_t ui32Inputs, uint32_t ui32HoldOff);
+extern uint32_t DebounceEagerGet(uint32_t *pui32HoldOff);
+extern bool CustomHidChangeHandler(void);
+
+#endif // __PIPELINE_H__
@@ -0,0 +1,436 @@
+//*****************************************************************************
+//
+// profile.c - Per game settings profiles for the Mame control device.
+//
+// A profile holds the settings that differ from game to game, the debounce
+// policy, the report interval, the trackball sensitivities and curve and the
+// button map.  All PROFILE_COUNT profiles are kept in RAM, each with its own
+// button map tables already built, so changing profile costs a handful of
+// stores and never a table rebuild.  The profile is changed by a hotkey chord
+// on the switches or by the profile select feature report, and the choice is
+// saved in the configuration store with the profiles themselves.
+//
+// Settings changed while a profile is in use, for example through the
+// trackball settings report, belong to that profile and are kept when
+// another is selected.
+//
+// A profile is replaced in two steps.  ProfilePrepare() checks the new
+// settings and builds their button map tables in the spare slot, which takes
+// a while but touches nothing in use.  ProfileCommit() then swaps the slots
+// and the settings, which is quick enough to do with interrupts held off.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usblib/device/usbdhidmamecfg.h"
+#include "hal.h"
+#include "debounce.h"
+#include "mousemotion.h"
+#include "buttonmap.h"
+#include "pipeline.h"
+#include "config.h"
+#include "profile.h"
+
+#if PROFILE_REPORT_SIZE != (CUSTOMHID_PROFILE_SELECT_SIZE + 1)
+#error "PROFILE_REPORT_SIZE does not match CUSTOMHID_PROFILE_SELECT_SIZE"
+#endif
+
+#if BUTTON_MAP_INPUTS > PROFILE_BUTTON_MAP_SIZE
+#error "PROFILE_BUTTON_MAP_SIZE is too small for the button map"
+#endif
+
+//*****************************************************************************
+//
+// The profiles, the button map slot of each and the spare slot, the one in
+// use, the one chosen by the hotkey or the profile select report and waiting
+// for ProfileSelectUpdate(), or PROFILE_COUNT for none, the inputs seen by
+// the last hotkey check and the profile select report.
+//
+//*****************************************************************************
+static tProfile g_psProfiles[PROFILE_COUNT];
+static uint8_t g_pui8ProfileSlot[PROFILE_COUNT];
+static uint32_t g_ui32ProfileSpare;
+static volatile uint32_t g_ui32ProfileActive;
+static volatile uint32_t g_ui32ProfileSelected;
+static uint32_t g_ui32ProfileInputs;
+static uint8_t g_pui8ProfileReport[PROFILE_REPORT_SIZE];
+
+//*****************************************************************************
+//
+// The profile prepared by ProfilePrepare(), or PROFILE_COUNT if there is
+// none, and its settings.
+//
+//*****************************************************************************
+static uint32_t g_ui32ProfilePrepared;
+static tProfile g_sProfilePrepared;
+
+//*****************************************************************************
+//
+// Copies the settings in use into a profile, all but the button map.
+//
+//*****************************************************************************
+static void
+ProfileCapture(tProfile *psProfile)
+{
+    uint32_t ui32HoldOff;
+
+    psProfile->ui32EagerInputs = DebounceEagerGet(&ui32HoldOff);
+    psProfile->ui8HoldOff = ui32HoldOff;
+    psProfile->ui8ReportInterval = g_ui32ReportInterval;
+    psProfile->ui8AccelCurve = MouseAccelCurveGet();
+    psProfile->pui16Sensitivity[0] = MouseSensitivityGet(0);
+    psProfile->pui16Sensitivity[1] = MouseSensitivityGet(1);
+}
+
+//*****************************************************************************
+//
+// Puts a profile in use.  Its settings were checked by ProfilePrepare() so
+// none of the setters can refuse them.
+//
+//*****************************************************************************
+static void
+ProfileApply(uint32_t ui32Profile)
+{
+    const tProfile *psProfile;
+
+    psProfile = &g_psProfiles[ui32Profile];
+    DebounceEagerSet(psProfile->ui32EagerInputs, psProfile->ui8HoldOff);
+    ReportIntervalSet(psProfile->ui8ReportInterval);
+    MouseAccelCurveSet(psProfile->ui8AccelCurve);
+    MouseSensitivitySet(0, psProfile->pui16Sensitivity[0]);
+    MouseSensitivitySet(1, psProfile->pui16Sensitivity[1]);
+    ButtonMapSelect(g_pui8ProfileSlot[ui32Profile]);
+}
+
+//*****************************************************************************
+//
+// Sets every profile to the settings in use and selects profile 0.  The
+// other modules must already have set up their defaults, and the button map
+// its default map in every slot.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+ProfileInit(void)
+{
+    uint32_t ui32Profile, ui32Input;
+
+    for(ui32Profile = 0; ui32Profile < PROFILE_COUNT; ui32Profile++)
+    {
+        ProfileCapture(&g_psProfiles[ui32Profile]);
+        g_psProfiles[ui32Profile].ui8Reserved = 0;
+        for(ui32Input = 0; ui32Input < PROFILE_BUTTON_MAP_SIZE; ui32Input++)
+        {
+            g_psProfiles[ui32Profile].pui8ButtonMap[ui32Input] =
+                (ui32Input < BUTTON_MAP_INPUTS) ? ui32Input : BUTTON_MAP_NONE;
+        }
+        g_pui8ProfileSlot[ui32Profile] = ui32Profile;
+    }
+
+    g_ui32ProfileSpare = PROFILE_COUNT;
+    g_ui32ProfilePrepared = PROFILE_COUNT;
+    g_ui32ProfileActive = 0;
+    g_ui32ProfileSelected = PROFILE_COUNT;
+    g_ui32ProfileInputs = 0;
+    ButtonMapSelect(g_pui8ProfileSlot[0]);
+}
+
+//*****************************************************************************
+//
+// Checks the settings of a profile.
+//
+// \param psProfile holds the settings.
+//
+// \return Returns true if every setting is in range.
+//
+//*****************************************************************************
+bool
+ProfileValid(const tProfile *psProfile)
+{
+    return((psProfile->ui8HoldOff >= 1) &&
+           (psProfile->ui8HoldOff <= DEBOUNCE_MAX_COUNT) &&
+           ((psProfile->ui8ReportInterval == 1) ||
+            (psProfile->ui8ReportInterval == 2) ||
+            (psProfile->ui8ReportInterval == 4) ||
+            (psProfile->ui8ReportInterval == 8)) &&
+           (psProfile->ui8AccelCurve < MOUSE_ACCEL_CURVES) &&
+           (psProfile->pui16Sensitivity[0] >= MOUSE_SENSITIVITY_MIN) &&
+           (psProfile->pui16Sensitivity[0] <= MOUSE_SENSITIVITY_MAX) &&
+           (psProfile->pui16Sensitivity[1] >= MOUSE_SENSITIVITY_MIN) &&
+           (psProfile->pui16Sensitivity[1] <= MOUSE_SENSITIVITY_MAX) &&
+           ButtonMapValid(psProfile->pui8ButtonMap));
+}
+
+//*****************************************************************************
+//
+// Gets new settings for a profile ready for ProfileCommit().
+//
+// \param ui32Profile is the profile, below PROFILE_COUNT.
+// \param psProfile holds the new settings.
+//
+// The button map tables are built in the spare slot, which takes a few
+// thousand cycles, so this is called from the main loop.  Nothing in use
+// changes.  A profile prepared earlier and not yet committed is dropped.
+//
+// \return Returns false, preparing nothing, if any setting is out of range.
+//
+//*****************************************************************************
+bool
+ProfilePrepare(uint32_t ui32Profile, const tProfile *psProfile)
+{
+    uint32_t ui32Input;
+
+    g_ui32ProfilePrepared = PROFILE_COUNT;
+    if((ui32Profile >= PROFILE_COUNT) || !ProfileValid(psProfile))
+    {
+        return(false);
+    }
+
+    g_sProfilePrepared = *psProfile;
+    g_sProfilePrepared.ui32EagerInputs &= INPUT_ALL;
+    g_sProfilePrepared.ui8Reserved = 0;
+    for(ui32Input = BUTTON_MAP_INPUTS; ui32Input < PROFILE_BUTTON_MAP_SIZE;
+        ui32Input++)
+    {
+        g_sProfilePrepared.pui8ButtonMap[ui32Input] = BUTTON_MAP_NONE;
+    }
+    ButtonMapSet(g_ui32ProfileSpare, g_sProfilePrepared.pui8ButtonMap);
+    g_ui32ProfilePrepared = ui32Profile;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Puts the settings from ProfilePrepare() in place.  The prepared button map
+// slot takes the place of the old one, which becomes the spare, so this
+// takes the same short time whatever the settings.  If the profile is in use
+// its new settings are put in use at once.
+//
+// This must not be interrupted by sampling or the USB interrupt, so it is
+// called with interrupts held off or before they are enabled.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+ProfileCommit(void)
+{
+    uint32_t ui32Profile, ui32Slot;
+
+    ui32Profile = g_ui32ProfilePrepared;
+    if(ui32Profile >= PROFILE_COUNT)
+    {
+        return;
+    }
+    g_ui32ProfilePrepared = PROFILE_COUNT;
+
+    ui32Slot = g_pui8ProfileSlot[ui32Profile];
+    g_pui8ProfileSlot[ui32Profile] = g_ui32ProfileSpare;
+    g_ui32ProfileSpare = ui32Slot;
+    g_psProfiles[ui32Profile] = g_sProfilePrepared;
+
+    if(ui32Profile == g_ui32ProfileActive)
+    {
+        ProfileApply(ui32Profile);
+    }
+}
+
+//*****************************************************************************
+//
+// Replaces the settings of a profile at once, for loading the saved profiles
+// at boot.
+//
+// \param ui32Profile is the profile, below PROFILE_COUNT.
+// \param psProfile holds the new settings.
+//
+// \return Returns false, changing nothing, if any setting is out of range.
+//
+//*****************************************************************************
+bool
+ProfileSet(uint32_t ui32Profile, const tProfile *psProfile)
+{
+    if(!ProfilePrepare(ui32Profile, psProfile))
+    {
+        return(false);
+    }
+
+    ProfileCommit();
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Copies the settings of a profile into psProfile.  For the profile in use
+// these are the settings in use.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+ProfileGet(uint32_t ui32Profile, tProfile *psProfile)
+{
+    *psProfile = g_psProfiles[ui32Profile];
+    if(ui32Profile == g_ui32ProfileActive)
+    {
+        ProfileCapture(psProfile);
+    }
+}
+
+//*****************************************************************************
+//
+// Changes to another profile.  The settings in use are kept in the profile
+// being left, and the change is saved by ConfigSave() once the settings have
+// been left alone for CONFIG_SAVE_DELAY_MS, so switching mid-game neither
+// waits on nor wears the EEPROM.
+//
+// \param ui32Profile is the profile, below PROFILE_COUNT.
+//
+// This takes the same few microseconds whatever the profiles hold.  It must
+// be called before interrupts are enabled, or with them held off, so that it
+// never lands part way through a debounce update.  At runtime it is only
+// called through ProfileSelectUpdate(), so it never lands part way through
+// a report either.
+//
+// \return Returns false if there is no such profile.
+//
+//*****************************************************************************
+bool
+ProfileSelect(uint32_t ui32Profile)
+{
+    if(ui32Profile >= PROFILE_COUNT)
+    {
+        return(false);
+    }
+
+    if(ui32Profile != g_ui32ProfileActive)
+    {
+        ProfileCapture(&g_psProfiles[g_ui32ProfileActive]);
+        g_ui32ProfileActive = ui32Profile;
+        ConfigChanged();
+    }
+    ProfileApply(ui32Profile);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns the profile in use.
+//
+//*****************************************************************************
+uint32_t
+ProfileActiveGet(void)
+{
+    return(g_ui32ProfileActive);
+}
+
+//*****************************************************************************
+//
+// Changes to the profile chosen by the hotkey or the profile select report.
+// This is called by SettingsUpdate() at the start of each pipeline tick, and
+// costs nothing unless a profile has been chosen.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+ProfileSelectUpdate(void)
+{
+    bool bIntsOff;
+
+    if(g_ui32ProfileSelected >= PROFILE_COUNT)
+    {
+        return;
+    }
+
+    bIntsOff = HALIntDisable();
+    ProfileSelect(g_ui32ProfileSelected);
+    g_ui32ProfileSelected = PROFILE_COUNT;
+    HALIntRestore(bIntsOff);
+}
+
+//*****************************************************************************
+//
+// Checks the debounced inputs for the hotkey chord.  This is called with
+// every debounced sample, before the button map, so the chord follows the
+// wiring whatever the profile maps it to.  The profile chosen goes in use at
+// the start of the next pipeline tick.
+//
+// \param ui32Inputs is the packed debounced input word.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+ProfileHotkey(uint32_t ui32Inputs)
+{
+    uint32_t ui32Pressed, ui32Profile;
+
+    ui32Pressed = ui32Inputs & ~g_ui32ProfileInputs;
+    g_ui32ProfileInputs = ui32Inputs;
+    if(!ui32Pressed || !PROFILE_HOTKEY_INPUTS ||
+       ((ui32Inputs & PROFILE_HOTKEY_INPUTS) != PROFILE_HOTKEY_INPUTS))
+    {
+        return;
+    }
+
+    ui32Pressed >>= PROFILE_HOTKEY_SELECT_S;
+    for(ui32Profile = 0; ui32Profile < PROFILE_COUNT; ui32Profile++)
+    {
+        if(ui32Pressed & (1 << ui32Profile))
+        {
+            g_ui32ProfileSelected = ui32Profile;
+            return;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Builds the profile select feature report.
+//
+// \return Returns a pointer to the PROFILE_REPORT_SIZE byte report, starting
+// with its report ID.
+//
+//*****************************************************************************
+uint8_t *
+ProfileReportGet(void)
+{
+    g_pui8ProfileReport[0] = CUSTOMHID_REPORT_ID_PROFILE_SELECT;
+    g_pui8ProfileReport[1] = g_ui32ProfileActive;
+    g_pui8ProfileReport[2] = PROFILE_COUNT;
+
+    return(g_pui8ProfileReport);
+}
+
+//*****************************************************************************
+//
+// Applies a profile select feature report written by the host.
+//
+// \param pui8Report is the report, starting with its report ID.
+// \param ui32Size is the length of the report in bytes.
+//
+// This is called from the USB interrupt.  The profile goes in use at the
+// start of the next pipeline tick, through ProfileSelectUpdate(), so no
+// report is built from a mix of two profiles.
+//
+// \return Returns false, changing nothing, if the report is short or names
+// no profile.
+//
+//*****************************************************************************
+bool
+ProfileReportSet(const uint8_t *pui8Report, uint32_t ui32Size)
+{
+    if((ui32Size < PROFILE_REPORT_SIZE) ||
+       (pui8Report[1] >= PROFILE_COUNT))
+    {
+        return(false);
+    }
+
+    g_ui32ProfileSelected = pui8Report[1];
+    return(true);
+}
@@ -0,0 +1,89 @@
+//*****************************************************************************
+//
+// profile.h - Per game settings profiles for the Mame control device.
+//
+//*****************************************************************************
+
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+//*****************************************************************************
+//
+// The number of profiles.  Each has its own button map tables, and one more
+// set is kept spare for building a new map in.
+//
+//*****************************************************************************
+#define PROFILE_COUNT           (BUTTON_MAP_SLOTS - 1)
+
+//*****************************************************************************
+//
+// The hotkey chord.  While every input in PROFILE_HOTKEY_INPUTS is held, a
+// press of player one button N selects profile N - 1.  The default chord is
+// player one buttons 11 and 12.  The presses are still reported to the host.
+//
+//*****************************************************************************
+#ifndef PROFILE_HOTKEY_INPUTS
+#define PROFILE_HOTKEY_INPUTS   0x0000C000
+#endif
+
+#define PROFILE_HOTKEY_SELECT_S 4
+
+#if PROFILE_HOTKEY_INPUTS & (((1 << PROFILE_COUNT) - 1) <<                   \
+                             PROFILE_HOTKEY_SELECT_S)
+#error "PROFILE_HOTKEY_INPUTS can not include the profile select buttons"
+#endif
+
+//*****************************************************************************
+//
+// The settings of a profile, as saved in the configuration store.  The button
+// map has room for 32 inputs, of which BUTTON_MAP_INPUTS are used and the
+// rest are BUTTON_MAP_NONE.
+//
+//*****************************************************************************
+#define PROFILE_BUTTON_MAP_SIZE 32
+
+typedef struct
+{
+    uint32_t ui32EagerInputs;
+    uint8_t ui8HoldOff;
+    uint8_t ui8ReportInterval;
+    uint8_t ui8AccelCurve;
+    uint8_t ui8Reserved;
+    uint16_t pui16Sensitivity[2];
+    uint8_t pui8ButtonMap[PROFILE_BUTTON_MAP_SIZE];
+}
+tProfile;
+
+//*****************************************************************************
+//
+// The profile select feature report is:
+//
+//  byte 0      CUSTOMHID_REPORT_ID_PROFILE_SELECT
+//  byte 1      the profile in use
+//  byte 2      PROFILE_COUNT
+//
+// Writing it with a profile below PROFILE_COUNT in byte 1 selects that
+// profile.  Byte 2 is ignored.
+//
+//*****************************************************************************
+#define PROFILE_REPORT_SIZE     3
+
+//*****************************************************************************
+//
+// Prototypes for the profile functions.
+//
+//*****************************************************************************
+extern void ProfileInit(void);
+extern bool ProfileValid(const tProfile *psProfile);
+extern bool ProfilePrepare(uint32_t ui32Profile, const tProfile *psProfile);
+extern void ProfileCommit(void);
+extern bool ProfileSet(uint32_t ui32Profile, const tProfile *psProfile);
+extern void ProfileGet(uint32_t ui32Profile, tProfile *psProfile);
+extern bool ProfileSelect(uint32_t ui32Profile);
+extern uint32_t ProfileActiveGet(void);
+extern void ProfileSelectUpdate(void);
+extern void ProfileHotkey(uint32_t ui32Inputs);
+extern uint8_t *ProfileReportGet(void);
+extern bool ProfileReportSet(const uint8_t *pui8Report, uint32_t ui32Size);
+
+#endif // __PROFILE_H__
@@ -0,0 +1,423 @@
+//*****************************************************************************
+//
+// settings.c - Live configuration through a vendor feature report for the
+//              Mame control device.
+//
+// The host reads and writes the settings profiles and the analog calibration
+// through the settings feature report.  Settings written are not used
+// straight away.  They are checked and staged in shadow copies from the USB
+// interrupt, and a commit puts everything staged in use at once.  The commit
+// is carried out by SettingsUpdate() at the start of a pipeline tick: the
+// slow part, building the button map tables, goes to the spare slot with
+// interrupts enabled, and then the slots and settings are swapped with
+// interrupts held off for a few microseconds.  Sampling never waits on a
+// table build and no report is built from a mix of old and new settings.
+// The profile select and trackball settings reports, and the profile hotkey,
+// are staged by their own modules and go in use at the same point.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usblib/device/usbdhidmamecfg.h"
+#include "hal.h"
+#include "analog.h"
+#include "mousemotion.h"
+#include "buttonmap.h"
+#include "profile.h"
+#include "config.h"
+#include "settings.h"
+
+#if SETTINGS_REPORT_SIZE != (CUSTOMHID_SETTINGS_SIZE + 1)
+#error "SETTINGS_REPORT_SIZE does not match CUSTOMHID_SETTINGS_SIZE"
+#endif
+
+//*****************************************************************************
+//
+// The size of the profile and analog calibration payloads.
+//
+//*****************************************************************************
+#define SETTINGS_PROFILE_SIZE   (12 + PROFILE_BUTTON_MAP_SIZE)
+#define SETTINGS_ANALOG_SIZE    8
+
+//*****************************************************************************
+//
+// The last command and its result, and the reply.
+//
+//*****************************************************************************
+static uint8_t g_ui8SettingsCommand;
+static uint8_t g_ui8SettingsResult;
+static uint8_t g_pui8SettingsReport[SETTINGS_REPORT_SIZE];
+
+//*****************************************************************************
+//
+// The staged settings: the profile, or PROFILE_COUNT for none, and the
+// analog axes with a bit set in g_ui32SettingsAnalog.  While a commit is
+// pending the shadow copies belong to SettingsUpdate() and are not written.
+//
+//*****************************************************************************
+static uint32_t g_ui32SettingsProfile;
+static tProfile g_sSettingsProfile;
+static uint32_t g_ui32SettingsAnalog;
+#if CUSTOMHID_ANALOG_AXES
+static tAnalogCalibration g_psSettingsAnalog[CUSTOMHID_ANALOG_AXES];
+#endif
+static volatile bool g_bSettingsCommit;
+static uint32_t g_ui32SettingsCommits;
+
+//*****************************************************************************
+//
+// Reads and writes 16 and 32 bit little endian values in a report.
+//
+//*****************************************************************************
+static uint32_t
+SettingsRead16(const uint8_t *pui8Data)
+{
+    return(pui8Data[0] | (pui8Data[1] << 8));
+}
+
+static uint32_t
+SettingsRead32(const uint8_t *pui8Data)
+{
+    return(SettingsRead16(pui8Data) | (SettingsRead16(pui8Data + 2) << 16));
+}
+
+static void
+SettingsWrite16(uint8_t *pui8Data, uint32_t ui32Value)
+{
+    pui8Data[0] = ui32Value & 0xFF;
+    pui8Data[1] = (ui32Value >> 8) & 0xFF;
+}
+
+static void
+SettingsWrite32(uint8_t *pui8Data, uint32_t ui32Value)
+{
+    SettingsWrite16(pui8Data, ui32Value & 0xFFFF);
+    SettingsWrite16(pui8Data + 2, ui32Value >> 16);
+}
+
+//*****************************************************************************
+//
+// Packs a profile into a payload and unpacks it again.
+//
+//*****************************************************************************
+static void
+SettingsProfilePack(uint8_t *pui8Data, const tProfile *psProfile)
+{
+    uint32_t ui32Idx;
+
+    SettingsWrite32(pui8Data, psProfile->ui32EagerInputs);
+    pui8Data[4] = psProfile->ui8HoldOff;
+    pui8Data[5] = psProfile->ui8ReportInterval;
+    pui8Data[6] = psProfile->ui8AccelCurve;
+    pui8Data[7] = 0;
+    SettingsWrite16(pui8Data + 8, psProfile->pui16Sensitivity[0]);
+    SettingsWrite16(pui8Data + 10, psProfile->pui16Sensitivity[1]);
+    for(ui32Idx = 0; ui32Idx < PROFILE_BUTTON_MAP_SIZE; ui32Idx++)
+    {
+        pui8Data[12 + ui32Idx] = psProfile->pui8ButtonMap[ui32Idx];
+    }
+}
+
+static void
+SettingsProfileUnpack(tProfile *psProfile, const uint8_t *pui8Data)
+{
+    uint32_t ui32Idx;
+
+    psProfile->ui32EagerInputs = SettingsRead32(pui8Data);
+    psProfile->ui8HoldOff = pui8Data[4];
+    psProfile->ui8ReportInterval = pui8Data[5];
+    psProfile->ui8AccelCurve = pui8Data[6];
+    psProfile->ui8Reserved = 0;
+    psProfile->pui16Sensitivity[0] = SettingsRead16(pui8Data + 8);
+    psProfile->pui16Sensitivity[1] = SettingsRead16(pui8Data + 10);
+    for(ui32Idx = 0; ui32Idx < PROFILE_BUTTON_MAP_SIZE; ui32Idx++)
+    {
+        psProfile->pui8ButtonMap[ui32Idx] = pui8Data[12 + ui32Idx];
+    }
+}
+
+//*****************************************************************************
+//
+// Runs one command, filling in the reply.  Returns the result.
+//
+//*****************************************************************************
+static uint32_t
+SettingsCommand(uint32_t ui32Command, uint32_t ui32Index,
+                const uint8_t *pui8Data, uint32_t ui32Size)
+{
+    tProfile sProfile;
+#if CUSTOMHID_ANALOG_AXES
+    tAnalogCalibration sCal;
+#endif
+
+    switch(ui32Command)
+    {
+        case SETTINGS_CMD_STATUS:
+        {
+            return(SETTINGS_RESULT_OK);
+        }
+
+        case SETTINGS_CMD_READ_PROFILE:
+        {
+            if(ui32Index >= PROFILE_COUNT)
+            {
+                return(SETTINGS_RESULT_BAD_VALUE);
+            }
+            ProfileGet(ui32Index, &sProfile);
+            SettingsProfilePack(g_pui8SettingsReport + 4, &sProfile);
+            return(SETTINGS_RESULT_OK);
+        }
+
+        case SETTINGS_CMD_STAGE_PROFILE:
+        {
+            if(g_bSettingsCommit)
+            {
+                return(SETTINGS_RESULT_BUSY);
+            }
+            if(ui32Size < SETTINGS_PROFILE_SIZE)
+            {
+                return(SETTINGS_RESULT_BAD_VALUE);
+            }
+            SettingsProfileUnpack(&sProfile, pui8Data);
+            if((ui32Index >= PROFILE_COUNT) || !ProfileValid(&sProfile))
+            {
+                return(SETTINGS_RESULT_BAD_VALUE);
+            }
+            g_sSettingsProfile = sProfile;
+            g_ui32SettingsProfile = ui32Index;
+            return(SETTINGS_RESULT_OK);
+        }
+
+#if CUSTOMHID_ANALOG_AXES
+        case SETTINGS_CMD_READ_ANALOG:
+        {
+            if(ui32Index >= CUSTOMHID_ANALOG_AXES)
+            {
+                return(SETTINGS_RESULT_BAD_VALUE);
+            }
+            AnalogCalibrationGet(ui32Index, &sCal);
+            SettingsWrite16(g_pui8SettingsReport + 4, sCal.ui16Min);
+            SettingsWrite16(g_pui8SettingsReport + 6, sCal.ui16Center);
+            SettingsWrite16(g_pui8SettingsReport + 8, sCal.ui16Max);
+            SettingsWrite16(g_pui8SettingsReport + 10, sCal.ui16Deadzone);
+            return(SETTINGS_RESULT_OK);
+        }
+
+        case SETTINGS_CMD_STAGE_ANALOG:
+        {
+            if(g_bSettingsCommit)
+            {
+                return(SETTINGS_RESULT_BUSY);
+            }
+            if(ui32Size < SETTINGS_ANALOG_SIZE)
+            {
+                return(SETTINGS_RESULT_BAD_VALUE);
+            }
+            sCal.ui16Min = SettingsRead16(pui8Data);
+            sCal.ui16Center = SettingsRead16(pui8Data + 2);
+            sCal.ui16Max = SettingsRead16(pui8Data + 4);
+            sCal.ui16Deadzone = SettingsRead16(pui8Data + 6);
+            if((ui32Index >= CUSTOMHID_ANALOG_AXES) ||
+               !AnalogCalibrationValid(&sCal))
+            {
+                return(SETTINGS_RESULT_BAD_VALUE);
+            }
+            g_psSettingsAnalog[ui32Index] = sCal;
+            g_ui32SettingsAnalog |= 1 << ui32Index;
+            return(SETTINGS_RESULT_OK);
+        }
+#else
+        case SETTINGS_CMD_READ_ANALOG:
+        case SETTINGS_CMD_STAGE_ANALOG:
+        {
+            return(SETTINGS_RESULT_BAD_VALUE);
+        }
+#endif
+
+        case SETTINGS_CMD_COMMIT:
+        {
+            if(g_bSettingsCommit)
+            {
+                return(SETTINGS_RESULT_BUSY);
+            }
+            g_bSettingsCommit = true;
+            return(SETTINGS_RESULT_OK);
+        }
+
+        case SETTINGS_CMD_DISCARD:
+        {
+            if(g_bSettingsCommit)
+            {
+                return(SETTINGS_RESULT_BUSY);
+            }
+            g_ui32SettingsProfile = PROFILE_COUNT;
+            g_ui32SettingsAnalog = 0;
+            return(SETTINGS_RESULT_OK);
+        }
+
+        default:
+        {
+            return(SETTINGS_RESULT_BAD_COMMAND);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Drops anything staged.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+SettingsInit(void)
+{
+    g_ui8SettingsCommand = SETTINGS_CMD_STATUS;
+    g_ui8SettingsResult = SETTINGS_RESULT_OK;
+    g_ui32SettingsProfile = PROFILE_COUNT;
+    g_ui32SettingsAnalog = 0;
+    g_bSettingsCommit = false;
+    g_ui32SettingsCommits = 0;
+}
+
+//*****************************************************************************
+//
+// Puts staged settings in use: a profile chosen by the hotkey or the profile
+// select report, trackball settings from their report, and then a commit
+// asked for by the host.  This is called from the main loop at the start of
+// each pipeline tick, before the tick's reports are built, and costs nothing
+// unless something is staged.  The settings are saved by ConfigSave().
+//
+// \return None.
+//
+//*****************************************************************************
+void
+SettingsUpdate(void)
+{
+    bool bIntsOff;
+#if CUSTOMHID_ANALOG_AXES
+    uint32_t ui32Axis;
+#endif
+
+    ProfileSelectUpdate();
+    MouseConfigUpdate();
+
+    if(!g_bSettingsCommit)
+    {
+        return;
+    }
+
+    //
+    // The staged profile was checked when it arrived, so this only fails if
+    // there is none.
+    //
+    if(g_ui32SettingsProfile < PROFILE_COUNT)
+    {
+        ProfilePrepare(g_ui32SettingsProfile, &g_sSettingsProfile);
+    }
+
+    bIntsOff = HALIntDisable();
+    ProfileCommit();
+#if CUSTOMHID_ANALOG_AXES
+    for(ui32Axis = 0; ui32Axis < CUSTOMHID_ANALOG_AXES; ui32Axis++)
+    {
+        if(g_ui32SettingsAnalog & (1 << ui32Axis))
+        {
+            AnalogCalibrationSet(ui32Axis, &g_psSettingsAnalog[ui32Axis]);
+        }
+    }
+#endif
+    HALIntRestore(bIntsOff);
+
+    if((g_ui32SettingsProfile < PROFILE_COUNT) || g_ui32SettingsAnalog)
+    {
+        ConfigChanged();
+    }
+    g_ui32SettingsProfile = PROFILE_COUNT;
+    g_ui32SettingsAnalog = 0;
+    g_ui32SettingsCommits++;
+
+    //
+    // Clearing the flag last hands the shadow copies back to the USB
+    // interrupt.
+    //
+    g_bSettingsCommit = false;
+}
+
+//*****************************************************************************
+//
+// Builds the reply to the last command.  The status is filled in as it is
+// now, so the host can read the report again to see a commit finish.
+//
+// \return Returns a pointer to the SETTINGS_REPORT_SIZE byte report,
+// starting with its report ID.
+//
+//*****************************************************************************
+uint8_t *
+SettingsReportGet(void)
+{
+    g_pui8SettingsReport[0] = CUSTOMHID_REPORT_ID_SETTINGS;
+    g_pui8SettingsReport[1] = g_ui8SettingsCommand;
+    g_pui8SettingsReport[3] = g_ui8SettingsResult;
+
+    if((g_ui8SettingsCommand == SETTINGS_CMD_COMMIT) &&
+       (g_ui8SettingsResult == SETTINGS_RESULT_OK) && g_bSettingsCommit)
+    {
+        g_pui8SettingsReport[3] = SETTINGS_RESULT_PENDING;
+    }
+
+    if(((g_ui8SettingsCommand != SETTINGS_CMD_READ_PROFILE) &&
+        (g_ui8SettingsCommand != SETTINGS_CMD_READ_ANALOG)) ||
+       (g_ui8SettingsResult != SETTINGS_RESULT_OK))
+    {
+        g_pui8SettingsReport[4] = ProfileActiveGet();
+        g_pui8SettingsReport[5] = PROFILE_COUNT;
+        g_pui8SettingsReport[6] = CUSTOMHID_ANALOG_AXES;
+        g_pui8SettingsReport[7] = ((g_ui32SettingsProfile < PROFILE_COUNT) ?
+                                   g_ui32SettingsProfile : 0xFF);
+        g_pui8SettingsReport[8] = g_ui32SettingsAnalog;
+        SettingsWrite32(g_pui8SettingsReport + 9, g_ui32SettingsCommits);
+    }
+
+    return(g_pui8SettingsReport);
+}
+
+//*****************************************************************************
+//
+// Runs a command from a settings feature report written by the host.
+//
+// \param pui8Report is the report, starting with its report ID.
+// \param ui32Size is the length of the report in bytes.
+//
+// This is called from the USB interrupt.  Reads are answered straight away
+// and staged settings are checked as they arrive.  The result is in the
+// reply.
+//
+// \return Returns true if the command succeeded.
+//
+//*****************************************************************************
+bool
+SettingsReportSet(const uint8_t *pui8Report, uint32_t ui32Size)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 4; ui32Idx < SETTINGS_REPORT_SIZE; ui32Idx++)
+    {
+        g_pui8SettingsReport[ui32Idx] = 0;
+    }
+
+    if(ui32Size < 4)
+    {
+        g_ui8SettingsCommand = SETTINGS_CMD_STATUS;
+        g_ui8SettingsResult = SETTINGS_RESULT_BAD_COMMAND;
+        return(false);
+    }
+
+    g_ui8SettingsCommand = pui8Report[1];
+    g_pui8SettingsReport[2] = pui8Report[2];
+    g_ui8SettingsResult = SettingsCommand(pui8Report[1], pui8Report[2],
+                                          pui8Report + 4, ui32Size - 4);
+
+    return(g_ui8SettingsResult == SETTINGS_RESULT_OK);
+}
@@ -0,0 +1,83 @@
+//*****************************************************************************
+//
+// settings.h - Live configuration through a vendor feature report for the
+//              Mame control device.
+//
+//*****************************************************************************
+
+#ifndef __SETTINGS_H__
+#define __SETTINGS_H__
+
+//*****************************************************************************
+//
+// The settings feature report carries one command written by the host and
+// its reply read back by the host:
+//
+//  byte 0      CUSTOMHID_REPORT_ID_SETTINGS
+//  byte 1      command, one of SETTINGS_CMD_*
+//  byte 2      the profile or analog axis the command is for
+//  byte 3      in a reply, the result, one of SETTINGS_RESULT_*
+//  byte 4-63   payload
+//
+// A profile payload is 44 bytes:
+//
+//  byte 0-3    eager debounce inputs, 32 bit little endian
+//  byte 4      eager release hold-off in samples
+//  byte 5      report interval in milliseconds
+//  byte 6      trackball acceleration curve
+//  byte 7      reserved, 0
+//  byte 8-9    X sensitivity, 16 bit little endian
+//  byte 10-11  Y sensitivity, 16 bit little endian
+//  byte 12-43  button map, the control of each input or 0xFF
+//
+// An analog calibration payload is the minimum, center, maximum and dead
+// zone, each 16 bit little endian.
+//
+// The reply to every command but the reads is the status:
+//
+//  byte 4      the profile in use
+//  byte 5      the number of profiles
+//  byte 6      the number of analog axes
+//  byte 7      the profile staged, or 0xFF
+//  byte 8      a bit for each analog axis staged
+//  byte 9-12   the number of commits, 32 bit little endian
+//
+// New settings are staged, each checked as it arrives, and then committed
+// together.  The commit is carried out between two SysTicks, so every report
+// is built wholly from the old settings or wholly from the new.  Only one
+// profile can be staged at a time; staging another replaces it.
+//
+//*****************************************************************************
+#define SETTINGS_CMD_STATUS     0x00
+#define SETTINGS_CMD_READ_PROFILE                                             \
+                                0x01
+#define SETTINGS_CMD_STAGE_PROFILE                                            \
+                                0x02
+#define SETTINGS_CMD_READ_ANALOG                                              \
+                                0x03
+#define SETTINGS_CMD_STAGE_ANALOG                                             \
+                                0x04
+#define SETTINGS_CMD_COMMIT     0x05
+#define SETTINGS_CMD_DISCARD    0x06
+
+#define SETTINGS_RESULT_OK      0x00
+#define SETTINGS_RESULT_PENDING 0x01
+#define SETTINGS_RESULT_BAD_COMMAND                                           \
+                                0x02
+#define SETTINGS_RESULT_BAD_VALUE                                             \
+                                0x03
+#define SETTINGS_RESULT_BUSY    0x04
+
+#define SETTINGS_REPORT_SIZE    64
+
+//*****************************************************************************
+//
+// Prototypes for the live configuration functions.
+//
+//*****************************************************************************
+extern void SettingsInit(void);
+extern void SettingsUpdate(void);
+extern uint8_t *SettingsReportGet(void);
+extern bool SettingsReportSet(const uint8_t *pui8Report, uint32_t ui32Size);
+
+#endif // __SETTINGS_H__
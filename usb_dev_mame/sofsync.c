@@ -0,0 +1,260 @@
+//*****************************************************************************
+//
+// sofsync.c - Locks the input sampling tick to the USB start of frame.
+//
+// Left to itself SysTick runs from the crystal and slides slowly against the
+// host's 1 ms frame clock, so the age of a report when it is collected drifts
+// anywhere between 0 and 1 ms.  The USB library calls its tick handlers from
+// the start of frame interrupt, every fifth frame, which gives a regular
+// look at where SOF falls within the SysTick period.  Any error against the
+// wanted lead is taken out by stretching or shrinking a single SysTick
+// period, so the sample and report are always made just before the frame in
+// which the host will collect them.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_types.h"
+#include "inc/hw_nvic.h"
+#include "usblib/usblib.h"
+#include "usblib/usblibpriv.h"
+#include "sofsync.h"
+
+//*****************************************************************************
+//
+// The SysTick period in clocks, which must be one USB frame, and the number
+// of clocks in a microsecond.
+//
+//*****************************************************************************
+static uint32_t g_ui32SOFPeriod;
+static uint32_t g_ui32SOFClocksPerUs;
+
+//*****************************************************************************
+//
+// The wanted time from the SysTick wrap to SOF, and the dead band, in clocks.
+//
+//*****************************************************************************
+static volatile uint32_t g_ui32SOFLead;
+static uint32_t g_ui32SOFDeadband;
+
+//*****************************************************************************
+//
+// The reload value the running SysTick period started from and the one that
+// has been written for the next period.
+//
+//*****************************************************************************
+static volatile uint32_t g_ui32SOFRunLoad;
+static volatile uint32_t g_ui32SOFNextLoad;
+
+//*****************************************************************************
+//
+// The correction, in clocks, to apply to the next SysTick period.  Written
+// from the start of frame handler and consumed by SOFSyncTick().
+//
+//*****************************************************************************
+static volatile int32_t g_i32SOFAdjust;
+
+//*****************************************************************************
+//
+// The last measured time from the SysTick wrap to SOF, in clocks, and whether
+// it was inside the dead band.
+//
+//*****************************************************************************
+static volatile uint32_t g_ui32SOFPhase;
+static volatile bool g_bSOFLocked;
+static volatile bool g_bSOFEnabled;
+
+//*****************************************************************************
+//
+// Called by the USB library from the start of frame interrupt.  Measures
+// where this SOF fell in the SysTick period and works out the correction.
+//
+//*****************************************************************************
+static void
+SOFSyncTickHandler(void *pvInstance, uint32_t ui32TicksmS)
+{
+    uint32_t ui32Current, ui32Elapsed;
+    int32_t i32Error;
+
+    if(!g_bSOFEnabled)
+    {
+        return;
+    }
+
+    //
+    // If SysTick has wrapped but its handler has not yet run then the count
+    // already belongs to the period that was set up for next.
+    //
+    ui32Current = HWREG(NVIC_ST_CURRENT);
+    if(HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_PEND_SYST)
+    {
+        ui32Elapsed = g_ui32SOFNextLoad - ui32Current;
+    }
+    else
+    {
+        ui32Elapsed = g_ui32SOFRunLoad - ui32Current;
+    }
+    g_ui32SOFPhase = ui32Elapsed;
+
+    //
+    // A positive error means the tick came too early, so the next period is
+    // stretched.  Fold the error into half a frame either way.
+    //
+    i32Error = (int32_t)ui32Elapsed - (int32_t)g_ui32SOFLead;
+    if(i32Error > (int32_t)(g_ui32SOFPeriod / 2))
+    {
+        i32Error -= (int32_t)g_ui32SOFPeriod;
+    }
+    else if(i32Error < -(int32_t)(g_ui32SOFPeriod / 2))
+    {
+        i32Error += (int32_t)g_ui32SOFPeriod;
+    }
+
+    if((i32Error > (int32_t)g_ui32SOFDeadband) ||
+       (i32Error < -(int32_t)g_ui32SOFDeadband))
+    {
+        g_i32SOFAdjust = i32Error;
+        g_bSOFLocked = false;
+    }
+    else
+    {
+        g_bSOFLocked = true;
+    }
+}
+
+//*****************************************************************************
+//
+// Prepares start of frame synchronization.
+//
+// \param ui32Period is the SysTick period in clocks.  This must be one USB
+// frame, so SysTick has to be running at 1 kHz.
+//
+// The USB device stack must already have been initialized since that resets
+// the library's list of tick handlers.  Synchronization starts disabled.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+SOFSyncInit(uint32_t ui32Period)
+{
+    g_bSOFEnabled = false;
+    g_bSOFLocked = false;
+    g_ui32SOFPeriod = ui32Period;
+    g_ui32SOFClocksPerUs = ui32Period / 1000;
+    g_ui32SOFDeadband = SOF_SYNC_DEADBAND_US * g_ui32SOFClocksPerUs;
+    g_ui32SOFRunLoad = ui32Period - 1;
+    g_ui32SOFNextLoad = ui32Period - 1;
+    g_i32SOFAdjust = 0;
+    g_ui32SOFPhase = 0;
+    SOFSyncLeadSet(SOF_SYNC_LEAD_US);
+
+    InternalUSBRegisterTickHandler(SOFSyncTickHandler, 0);
+}
+
+//*****************************************************************************
+//
+// Turns start of frame synchronization on or off.  When it is turned off
+// SysTick goes back to free running at its nominal period.
+//
+//*****************************************************************************
+void
+SOFSyncEnable(bool bEnable)
+{
+    g_i32SOFAdjust = 0;
+    g_bSOFLocked = false;
+    g_bSOFEnabled = bEnable;
+}
+
+//*****************************************************************************
+//
+// Returns true if start of frame synchronization is turned on.
+//
+//*****************************************************************************
+bool
+SOFSyncEnabled(void)
+{
+    return(g_bSOFEnabled);
+}
+
+//*****************************************************************************
+//
+// Sets how many microseconds before SOF the sampling tick should fall.  The
+// lead is limited to half a frame.
+//
+//*****************************************************************************
+void
+SOFSyncLeadSet(uint32_t ui32LeadUs)
+{
+    if(ui32LeadUs > 500)
+    {
+        ui32LeadUs = 500;
+    }
+    g_ui32SOFLead = ui32LeadUs * g_ui32SOFClocksPerUs;
+}
+
+//*****************************************************************************
+//
+// Applies any pending phase correction.  This must be called from the
+// SysTick interrupt handler on every tick.
+//
+// The period that is now running was loaded when SysTick wrapped, so a new
+// reload value only takes effect from the following period and has to be put
+// back one tick after that.
+//
+//*****************************************************************************
+void
+SOFSyncTick(void)
+{
+    uint32_t ui32Load;
+
+    //
+    // SysTick runs before the USB stack is up, so there is nothing to do
+    // until SOFSyncInit() has been called.
+    //
+    if(!g_ui32SOFPeriod)
+    {
+        return;
+    }
+
+    g_ui32SOFRunLoad = g_ui32SOFNextLoad;
+
+    ui32Load = g_ui32SOFPeriod - 1;
+    if(g_bSOFEnabled && g_i32SOFAdjust)
+    {
+        ui32Load += g_i32SOFAdjust;
+        g_i32SOFAdjust = 0;
+    }
+
+    if(ui32Load != g_ui32SOFNextLoad)
+    {
+        HWREG(NVIC_ST_RELOAD) = ui32Load;
+        g_ui32SOFNextLoad = ui32Load;
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the last measured time, in microseconds, from the sampling tick to
+// the start of the frame.  While locked this is the lead plus the USB
+// interrupt latency, and it bounds how old the inputs in a report are when
+// the frame begins.
+//
+//*****************************************************************************
+uint32_t
+SOFSyncPhaseGet(void)
+{
+    return(g_ui32SOFPhase / g_ui32SOFClocksPerUs);
+}
+
+//*****************************************************************************
+//
+// Returns true if the last measured phase was within the dead band.
+//
+//*****************************************************************************
+bool
+SOFSyncLocked(void)
+{
+    return(g_bSOFLocked);
+}
@@ -0,0 +1,46 @@
+//*****************************************************************************
+//
+// sofsync.h - Locks the input sampling tick to the USB start of frame.
+//
+//*****************************************************************************
+
+#ifndef __SOFSYNC_H__
+#define __SOFSYNC_H__
+
+//*****************************************************************************
+//
+// How far ahead of the start of frame, in microseconds, the sampling tick is
+// placed.  This has to cover the sample, the report packing and the queueing
+// of the report so that it is ready before the host sends its IN token.  The
+// measured phase also includes the USB interrupt latency, which adds a few
+// microseconds of margin on top of this.
+//
+//*****************************************************************************
+#ifndef SOF_SYNC_LEAD_US
+#define SOF_SYNC_LEAD_US        100
+#endif
+
+//*****************************************************************************
+//
+// Phase errors up to this many microseconds are left alone so that interrupt
+// jitter does not keep nudging the tick.
+//
+//*****************************************************************************
+#ifndef SOF_SYNC_DEADBAND_US
+#define SOF_SYNC_DEADBAND_US    4
+#endif
+
+//*****************************************************************************
+//
+// Prototypes for the start of frame synchronization functions.
+//
+//*****************************************************************************
+extern void SOFSyncInit(uint32_t ui32Period);
+extern void SOFSyncEnable(bool bEnable);
+extern bool SOFSyncEnabled(void);
+extern void SOFSyncLeadSet(uint32_t ui32LeadUs);
+extern void SOFSyncTick(void);
+extern uint32_t SOFSyncPhaseGet(void);
+extern bool SOFSyncLocked(void);
+
+#endif // __SOFSYNC_H__
@@ -0,0 +1,175 @@
+//*****************************************************************************
+//
+// softquad.c - Software quadrature decoding for the Mame control device.
+//
+// The HAL calls SoftQuadUpdate() with the levels of a port whenever one of
+// the encoder pins on it changes.  Each encoder keeps its last A/B state and
+// a 16 entry table, indexed by the last and the new state, gives the step.
+// This costs a handful of instructions per edge, so the decoder keeps up with
+// a fast spinner with plenty of margin.  When the interrupt is late enough
+// for both pins to have changed, one state was missed.  The encoder must
+// then have moved two steps, and the direction it was last turning is the
+// best guess for which way.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hal.h"
+#include "softquad.h"
+
+//*****************************************************************************
+//
+// The pins of each encoder.  The spinner is on PC4 and PC7, the only port C
+// pins left free by the switches, the trackball and JTAG.
+//
+//*****************************************************************************
+const tSoftQuadPins g_psSoftQuadPins[SOFTQUAD_CHANNELS] =
+{
+    { HAL_PORTC, 0x10, 0x80 }
+};
+
+//*****************************************************************************
+//
+// The step for each pair of last and new states, indexed by
+// (last << 2) | new where a state has A in bit 0 and B in bit 1.  Turning
+// forward the states run 0, 1, 3, 2.  SOFTQUAD_SKIP marks a pair where both
+// pins changed.
+//
+//*****************************************************************************
+#define SOFTQUAD_SKIP           2
+
+static const int8_t g_pi8SoftQuadSteps[16] =
+{
+     0,  1, -1,  SOFTQUAD_SKIP,
+    -1,  0,  SOFTQUAD_SKIP,  1,
+     1,  SOFTQUAD_SKIP,  0, -1,
+     SOFTQUAD_SKIP, -1,  1,  0
+};
+
+//*****************************************************************************
+//
+// The state of one encoder.  ui32Position counts through 32 bits like the
+// QEI position, so the difference of two readings is the motion between
+// them.
+//
+//*****************************************************************************
+typedef struct
+{
+    volatile uint32_t ui32Position;
+    volatile uint32_t ui32Errors;
+    uint8_t ui8State;
+    int8_t i8Direction;
+}
+tSoftQuadState;
+
+static tSoftQuadState g_psSoftQuad[SOFTQUAD_CHANNELS];
+
+//*****************************************************************************
+//
+// Returns the A/B state of an encoder from the levels of its port.
+//
+//*****************************************************************************
+static uint8_t
+SoftQuadState(const tSoftQuadPins *psPins, uint8_t ui8Levels)
+{
+    return(((ui8Levels & psPins->ui8PinA) ? 1 : 0) |
+           ((ui8Levels & psPins->ui8PinB) ? 2 : 0));
+}
+
+//*****************************************************************************
+//
+// Resets every encoder to position 0 at the state its pins are in now.  The
+// HAL must already be initialized.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+SoftQuadInit(void)
+{
+    const tSoftQuadPins *psPins;
+    uint32_t ui32Channel;
+
+    for(ui32Channel = 0; ui32Channel < SOFTQUAD_CHANNELS; ui32Channel++)
+    {
+        psPins = &g_psSoftQuadPins[ui32Channel];
+        g_psSoftQuad[ui32Channel].ui32Position = 0;
+        g_psSoftQuad[ui32Channel].ui32Errors = 0;
+        g_psSoftQuad[ui32Channel].i8Direction = 1;
+        g_psSoftQuad[ui32Channel].ui8State =
+            SoftQuadState(psPins, HALGPIORead(psPins->ui8Port,
+                                              psPins->ui8PinA |
+                                              psPins->ui8PinB));
+    }
+}
+
+//*****************************************************************************
+//
+// Steps every encoder on a port to the state its pins are now in.
+//
+// \param ui32Port is the port, as a HAL_PORT value.
+// \param ui8Levels is the level of every pin of the port.
+//
+// This is called from the pin change interrupt of the port, and must see
+// every edge of the encoder pins for the count to stay exact.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+SoftQuadUpdate(uint32_t ui32Port, uint8_t ui8Levels)
+{
+    tSoftQuadState *psState;
+    uint32_t ui32Channel;
+    uint8_t ui8State;
+    int32_t i32Step;
+
+    for(ui32Channel = 0; ui32Channel < SOFTQUAD_CHANNELS; ui32Channel++)
+    {
+        if(g_psSoftQuadPins[ui32Channel].ui8Port != ui32Port)
+        {
+            continue;
+        }
+
+        psState = &g_psSoftQuad[ui32Channel];
+        ui8State = SoftQuadState(&g_psSoftQuadPins[ui32Channel], ui8Levels);
+        i32Step = g_pi8SoftQuadSteps[(psState->ui8State << 2) | ui8State];
+        psState->ui8State = ui8State;
+
+        if(i32Step == SOFTQUAD_SKIP)
+        {
+            i32Step = 2 * psState->i8Direction;
+            psState->ui32Errors++;
+        }
+        else if(i32Step)
+        {
+            psState->i8Direction = i32Step;
+        }
+
+        psState->ui32Position += i32Step;
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the free running count of an encoder.
+//
+//*****************************************************************************
+uint32_t
+SoftQuadPositionGet(uint32_t ui32Channel)
+{
+    return(g_psSoftQuad[ui32Channel].ui32Position);
+}
+
+//*****************************************************************************
+//
+// Returns the number of times both pins of an encoder were seen to change at
+// once, so that a state was missed and the step had to be guessed.
+//
+//*****************************************************************************
+uint32_t
+SoftQuadErrorsGet(uint32_t ui32Channel)
+{
+    return(g_psSoftQuad[ui32Channel].ui32Errors);
+}
@@ -0,0 +1,47 @@
+//*****************************************************************************
+//
+// softquad.h - Software quadrature decoding for the Mame control device.
+//
+//*****************************************************************************
+
+#ifndef __SOFTQUAD_H__
+#define __SOFTQUAD_H__
+
+//*****************************************************************************
+//
+// The software decoded encoders.  The two QEI modules are taken by the
+// trackball, so further encoders are decoded from pin change interrupts.
+// SOFTQUAD_SPINNER is reported as the spinner axis when the device is built
+// with CUSTOMHID_SPINNER.
+//
+//*****************************************************************************
+#define SOFTQUAD_SPINNER        0
+#define SOFTQUAD_CHANNELS       1
+
+//*****************************************************************************
+//
+// The A and B pins of each encoder, as a HAL_PORT value and pin masks for
+// that port.  Both pins of an encoder must be on the same port.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t ui8Port;
+    uint8_t ui8PinA;
+    uint8_t ui8PinB;
+}
+tSoftQuadPins;
+
+extern const tSoftQuadPins g_psSoftQuadPins[SOFTQUAD_CHANNELS];
+
+//*****************************************************************************
+//
+// Prototypes for the software quadrature functions.
+//
+//*****************************************************************************
+extern void SoftQuadInit(void);
+extern void SoftQuadUpdate(uint32_t ui32Port, uint8_t ui8Levels);
+extern uint32_t SoftQuadPositionGet(uint32_t ui32Channel);
+extern uint32_t SoftQuadErrorsGet(uint32_t ui32Channel);
+
+#endif // __SOFTQUAD_H__
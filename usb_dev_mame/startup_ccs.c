@@ -23,8 +23,12 @@
 //*****************************************************************************
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "inc/hw_nvic.h"
 #include "inc/hw_types.h"
+#include "usblib/device/usbdhidmamecfg.h"
+#include "cycleprofile.h"
+#include "mousemotion.h"
 
 //*****************************************************************************
 //
@@ -57,9 +61,63 @@ extern uint32_t __STACK_TOP;
 //
 //*****************************************************************************
 extern void SysTickIntHandler(void);
+extern void GPIOInputIntHandler(void);
 extern void UARTStdioIntHandler(void);
 extern void USB0DeviceIntHandler(void);
 
+//*****************************************************************************
+//
+// When profiling, the USB interrupt goes through a wrapper that times it.
+//
+//*****************************************************************************
+#if CYCLE_PROFILE_ENABLE
+extern void USB0ProfileIntHandler(void);
+#define USB0_INT_HANDLER        USB0ProfileIntHandler
+#else
+#define USB0_INT_HANDLER        USB0DeviceIntHandler
+#endif
+
+//*****************************************************************************
+//
+// In velocity mode the QEI modules interrupt at the end of every velocity
+// capture period.
+//
+//*****************************************************************************
+#if MOUSE_VELOCITY_ENABLE
+extern void QEI0IntHandler(void);
+extern void QEI1IntHandler(void);
+#define QEI0_INT_HANDLER        QEI0IntHandler
+#define QEI1_INT_HANDLER        QEI1IntHandler
+#else
+#define QEI0_INT_HANDLER        IntDefaultHandler
+#define QEI1_INT_HANDLER        IntDefaultHandler
+#endif
+
+//*****************************************************************************
+//
+// With a spinner fitted port C interrupts go to the HAL, which decodes the
+// spinner pins before handing any switch edges on.
+//
+//*****************************************************************************
+#if CUSTOMHID_SPINNER
+extern void HALGPIOCIntHandler(void);
+#define GPIOC_INT_HANDLER       HALGPIOCIntHandler
+#else
+#define GPIOC_INT_HANDLER       GPIOInputIntHandler
+#endif
+
+//*****************************************************************************
+//
+// With analog inputs ADC0 interrupts each time uDMA has filled a block.
+//
+//*****************************************************************************
+#if CUSTOMHID_ANALOG_AXES
+extern void ADC0SS0IntHandler(void);
+#define ADC0SS0_INT_HANDLER     ADC0SS0IntHandler
+#else
+#define ADC0SS0_INT_HANDLER     IntDefaultHandler
+#endif
+
 //*****************************************************************************
 //
 // The vector table.  Note that the proper constructs must be placed on this to
@@ -87,11 +145,11 @@ void (* const g_pfnVectors[])(void) =
     0,                                      // Reserved
     IntDefaultHandler,                      // The PendSV handler
     SysTickIntHandler,                      // The SysTick handler
-    IntDefaultHandler,                      // GPIO Port A
-    IntDefaultHandler,                      // GPIO Port B
-    IntDefaultHandler,                      // GPIO Port C
-    IntDefaultHandler,                      // GPIO Port D
-    IntDefaultHandler,                      // GPIO Port E
+    GPIOInputIntHandler,                    // GPIO Port A
+    GPIOInputIntHandler,                    // GPIO Port B
+    GPIOC_INT_HANDLER,                      // GPIO Port C
+    GPIOInputIntHandler,                    // GPIO Port D
+    GPIOInputIntHandler,                    // GPIO Port E
     UARTStdioIntHandler,                    // UART0 Rx and Tx
     IntDefaultHandler,                      // UART1 Rx and Tx
     IntDefaultHandler,                      // SSI0 Rx and Tx
@@ -100,8 +158,8 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // PWM Generator 0
     IntDefaultHandler,                      // PWM Generator 1
     IntDefaultHandler,                      // PWM Generator 2
-    IntDefaultHandler,                      // Quadrature Encoder 0
-    IntDefaultHandler,                      // ADC Sequence 0
+    QEI0_INT_HANDLER,                       // Quadrature Encoder 0
+    ADC0SS0_INT_HANDLER,                    // ADC Sequence 0
     IntDefaultHandler,                      // ADC Sequence 1
     IntDefaultHandler,                      // ADC Sequence 2
     IntDefaultHandler,                      // ADC Sequence 3
@@ -125,13 +183,13 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // Timer 3 subtimer A
     IntDefaultHandler,                      // Timer 3 subtimer B
     IntDefaultHandler,                      // I2C1 Master and Slave
-    IntDefaultHandler,                      // Quadrature Encoder 1
+    QEI1_INT_HANDLER,                       // Quadrature Encoder 1
     IntDefaultHandler,                      // CAN0
     IntDefaultHandler,                      // CAN1
     IntDefaultHandler,                      // CAN2
     0,                                      // Reserved
     IntDefaultHandler,                      // Hibernate
-    USB0DeviceIntHandler,                   // USB0
+    USB0_INT_HANDLER,                       // USB0
     IntDefaultHandler,                      // PWM Generator 3
     IntDefaultHandler,                      // uDMA Software Transfer
     IntDefaultHandler,                      // uDMA Error
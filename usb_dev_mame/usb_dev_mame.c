@@ -27,6 +27,8 @@
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
 #include "inc/hw_gpio.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_nvic.h"
 #include "inc/hw_sysctl.h"
 #include "driverlib/debug.h"
 #include "driverlib/fpu.h"
@@ -35,15 +37,28 @@
 #include "driverlib/rom.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/systick.h"
-#include "driverlib/qei.h"
 #include "driverlib/interrupt.h"
 #include "usblib/usblib.h"
 #include "usblib/usbhid.h"
 #include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdcomp.h"
 #include "usblib/device/usbdhid.h"
 #include "usblib/device/usbdhidmame.h"
 #include "usb_mame_structs.h"
 #include "Mame_pins.h"
+#include "debounce.h"
+#include "sofsync.h"
+#include "inputevent.h"
+#include "latency.h"
+#include "hal.h"
+#include "mousemotion.h"
+#include "analog.h"
+#include "pipeline.h"
+#include "buttonmap.h"
+#include "profile.h"
+#include "settings.h"
+#include "config.h"
+#include "cycleprofile.h"
 
 //*****************************************************************************
 //
@@ -72,17 +87,39 @@
 
 //*****************************************************************************
 //
-// The number of checks for switch debouncing.
+// Input capture modes.  In polled mode every input is sampled on each SysTick.
+// In edge mode the GPIO port interrupts take the first sample the moment a
+// pin changes, which can accept a press, and have the pipeline run at once,
+// but leaves completing a release to the next tick.  SysTick only keeps
+// sampling until the debounce window has settled, after which the processor
+// is left to sleep between interrupts.
+// In sampled mode, built with INPUT_SAMPLE_HZ, the hardware samples every
+// input many times a tick and SysTick works through the block of samples.
 //
 //*****************************************************************************
-#define MAX_CHECKS 5
+#define CAPTURE_POLLED          0
+#define CAPTURE_EDGE            1
+#define CAPTURE_SAMPLED         2
+
+#ifndef INPUT_CAPTURE_MODE
+#define INPUT_CAPTURE_MODE      CAPTURE_EDGE
+#endif
+
+#if (INPUT_CAPTURE_MODE == CAPTURE_SAMPLED) && !INPUT_SAMPLE_HZ
+#error "CAPTURE_SAMPLED needs INPUT_SAMPLE_HZ"
+#endif
 
 //*****************************************************************************
 //
-// Pre-scalar for mouse input.
+// Set SOF_SYNC_ENABLE to 1 to start with the SysTick phase locked to the USB
+// start of frame, so that the last sample and report of each frame are made
+// SOF_SYNC_LEAD_US before the host comes to collect them.  SOFSyncEnable()
+// can change this at runtime.
 //
 //*****************************************************************************
-#define MOUSE_SCALAR 2
+#ifndef SOF_SYNC_ENABLE
+#define SOF_SYNC_ENABLE         0
+#endif
 
 //*****************************************************************************
 //
@@ -102,29 +139,17 @@ volatile bool g_bSuspended = false;
 //*****************************************************************************
 //
 // Global system tick counter holds elapsed time since the application started
-// expressed in 100ths of a second.
+// expressed in milliseconds.
 //
 //*****************************************************************************
 volatile uint32_t g_ui32SysTickCount;
 
 //*****************************************************************************
 //
-// Global button arrays and ticks hold button data from each loop for debouncing
+// The buffer that Set_Report data for a feature report is received into.
 //
 //*****************************************************************************
-volatile signed char g_ui8Pad1[3];
-volatile signed char g_ui8Pad2[2];
-volatile signed char g_ui8Mouse[3];
-volatile signed char g_ui8Pad1_1State[MAX_CHECKS];
-volatile signed char g_ui8Pad1_2State[MAX_CHECKS];
-volatile signed char g_ui8Pad1_3State[MAX_CHECKS];
-volatile signed char g_ui8Pad2_1State[MAX_CHECKS];
-volatile signed char g_ui8Pad2_2State[MAX_CHECKS];
-volatile signed char g_ui8Mouse_State[MAX_CHECKS];
-volatile signed char g_ui8IndexDebounce;
-volatile signed char g_ui8Pad1_Debounced[3];
-volatile signed char g_ui8Pad2_Debounced[2];
-volatile signed char g_ui8Mouse_Debounced[3];
+uint8_t g_pui8FeatureReport[CUSTOMHID_LATENCY_SIZE + 1];
 
 //*****************************************************************************
 //
@@ -133,6 +158,25 @@ volatile signed char g_ui8Mouse_Debounced[3];
 //*****************************************************************************
 volatile bool g_bProgramMode;
 
+//*****************************************************************************
+//
+// The active input capture mode, CAPTURE_POLLED, CAPTURE_EDGE or
+// CAPTURE_SAMPLED, and the number of SysTick samples still required before
+// the inputs are considered settled in edge mode.
+//
+//*****************************************************************************
+volatile uint32_t g_ui32CaptureMode;
+volatile uint32_t g_ui32SettleTicks;
+
+//*****************************************************************************
+//
+// Set by the switch interrupt when its sample changes the debounced inputs,
+// so that the main loop runs the pipeline at once instead of waiting for the
+// next tick.
+//
+//*****************************************************************************
+volatile bool g_bPipelinePending;
+
 //*****************************************************************************
 //
 // This enumeration holds the various states that the device can be in during
@@ -147,14 +191,9 @@ volatile enum
     STATE_UNCONFIGURED,
 
     //
-    // No keys to send and not waiting on data.
+    // Connected and ready to queue reports.
     //
-    STATE_IDLE,
-
-    //
-    // Waiting on data to be sent out.
-    //
-    STATE_SENDING
+    STATE_IDLE
 }
 g_eCustomHidState = STATE_UNCONFIGURED;
 
@@ -215,15 +254,103 @@ CustomHidHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
 
         //
         // We receive this event every time the host acknowledges transmission
-        // of a report. It is used here purely as a way of determining whether
-        // the host is still talking to us or not.
+        // of a report.  The driver moves on to the next queued report by
+        // itself so there is nothing to do here.
         //
         case USB_EVENT_TX_COMPLETE:
         {
-            //
-            // Enter the idle state since we finished sending something.
-            //
-            g_eCustomHidState = STATE_IDLE;
+            PipelineReportAcked(
+                ((tUSBDHIDCustomHidDevice *)pvCBData)->ui32Interface);
+            break;
+        }
+
+        //
+        // The host is reading a feature report.  Set the report pointer in
+        // *pvMsgData and return the length, or 0 for an unknown report.
+        //
+        case USBD_HID_EVENT_GET_REPORT:
+        {
+            if((ui32MsgData & 0xFF) == CUSTOMHID_REPORT_ID_LATENCY)
+            {
+                *(uint8_t **)pvMsgData = LatencyReportGet();
+                return(LATENCY_REPORT_SIZE);
+            }
+#if CYCLE_PROFILE_ENABLE
+            if((ui32MsgData & 0xFF) == CUSTOMHID_REPORT_ID_CYCLES)
+            {
+                *(uint8_t **)pvMsgData = CycleProfileReportGet();
+                return(CYCLE_PROFILE_REPORT_SIZE);
+            }
+#endif
+            if((ui32MsgData & 0xFF) == CUSTOMHID_REPORT_ID_MOUSE_CONFIG)
+            {
+                *(uint8_t **)pvMsgData = MouseConfigReportGet();
+                return(MOUSE_CONFIG_REPORT_SIZE);
+            }
+            if((ui32MsgData & 0xFF) == CUSTOMHID_REPORT_ID_PROFILE_SELECT)
+            {
+                *(uint8_t **)pvMsgData = ProfileReportGet();
+                return(PROFILE_REPORT_SIZE);
+            }
+            if((ui32MsgData & 0xFF) == CUSTOMHID_REPORT_ID_SETTINGS)
+            {
+                *(uint8_t **)pvMsgData = SettingsReportGet();
+                return(SETTINGS_REPORT_SIZE);
+            }
+            return(0);
+        }
+
+        //
+        // The host is about to write a feature report of the length given in
+        // pvMsgData.  Return the buffer to receive it, or 0 to stall.
+        //
+        case USBD_HID_EVENT_GET_REPORT_BUFFER:
+        {
+            if((((ui32MsgData & 0xFF) == CUSTOMHID_REPORT_ID_LATENCY) ||
+                (CYCLE_PROFILE_ENABLE &&
+                 ((ui32MsgData & 0xFF) == CUSTOMHID_REPORT_ID_CYCLES)) ||
+                ((ui32MsgData & 0xFF) == CUSTOMHID_REPORT_ID_MOUSE_CONFIG) ||
+                ((ui32MsgData & 0xFF) == CUSTOMHID_REPORT_ID_PROFILE_SELECT) ||
+                ((ui32MsgData & 0xFF) == CUSTOMHID_REPORT_ID_SETTINGS)) &&
+               ((uint32_t)pvMsgData <= sizeof(g_pui8FeatureReport)))
+            {
+                return((uint32_t)g_pui8FeatureReport);
+            }
+            return(0);
+        }
+
+        //
+        // A feature report has been written.  Writing the latency report
+        // clears the histograms, writing the cycle count report clears the
+        // cycle counts, writing the trackball settings or the profile select
+        // report stages the change for the next tick and writing the settings
+        // report runs a settings command.  The settings are saved from the
+        // main loop.
+        //
+        case USBD_HID_EVENT_SET_REPORT:
+        {
+            if(((uint8_t *)pvMsgData)[0] == CUSTOMHID_REPORT_ID_LATENCY)
+            {
+                LatencyReset();
+            }
+#if CYCLE_PROFILE_ENABLE
+            if(((uint8_t *)pvMsgData)[0] == CUSTOMHID_REPORT_ID_CYCLES)
+            {
+                CycleProfileReset();
+            }
+#endif
+            if(((uint8_t *)pvMsgData)[0] == CUSTOMHID_REPORT_ID_MOUSE_CONFIG)
+            {
+                MouseConfigReportSet((uint8_t *)pvMsgData, ui32MsgData);
+            }
+            if(((uint8_t *)pvMsgData)[0] == CUSTOMHID_REPORT_ID_PROFILE_SELECT)
+            {
+                ProfileReportSet((uint8_t *)pvMsgData, ui32MsgData);
+            }
+            if(((uint8_t *)pvMsgData)[0] == CUSTOMHID_REPORT_ID_SETTINGS)
+            {
+                SettingsReportSet((uint8_t *)pvMsgData, ui32MsgData);
+            }
             break;
         }
 
@@ -260,234 +387,205 @@ CustomHidHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
 
 //*****************************************************************************
 //
-// Send Data if necessary
-//
-//*****************************************************************************
-void SendHIDReport(char ReportNum, signed char ReportData[])
-{
-	g_eCustomHidState = STATE_SENDING;
-	USBDHIDCustomHidStateChange((void *)&g_sCustomHidDevice,ReportNum,ReportData);
-	while(g_eCustomHidState != STATE_IDLE)
-	{
-	}
-}
-
-//*****************************************************************************
-//
-// Store switch states in buffers
+// Select polled, edge triggered or sampled input capture.  Edge mode arms
+// both-edge interrupts on every switch input so that sampling starts as soon
+// as a pin changes.  Polled and sampled mode mask them again and take the
+// switches on every SysTick.  The port interrupts themselves are left enabled
+// since the spinner pins share them.
 //
 //*****************************************************************************
 void
-StoreSwitches(void)
+InputCaptureModeSet(uint32_t ui32Mode)
 {
-	g_ui8Pad1_1State[g_ui8IndexDebounce] =~GPIOPinRead(GPIO_PORTD_BASE, GPIO_PIN_0|GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3);
-	g_ui8Pad1_2State[g_ui8IndexDebounce] =~GPIOPinRead(GPIO_PORTA_BASE, GPIO_PIN_0|GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3|
-			GPIO_PIN_4|GPIO_PIN_5|GPIO_PIN_6|GPIO_PIN_7);
-	g_ui8Pad1_3State[g_ui8IndexDebounce] =~GPIOPinRead(GPIO_PORTC_BASE, GPIO_PIN_0|GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3);
-	g_ui8Pad2_1State[g_ui8IndexDebounce] =~GPIOPinRead(GPIO_PORTE_BASE, GPIO_PIN_2|GPIO_PIN_3|GPIO_PIN_4|GPIO_PIN_5)>>2;
-	g_ui8Pad2_2State[g_ui8IndexDebounce] =~GPIOPinRead(GPIO_PORTB_BASE, GPIO_PIN_0|GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3|
-			GPIO_PIN_4|GPIO_PIN_5|GPIO_PIN_6|GPIO_PIN_7);
-	g_ui8Mouse_State[g_ui8IndexDebounce] =~GPIOPinRead(GPIO_PORTE_BASE, GPIO_PIN_0|GPIO_PIN_1);
-	++g_ui8IndexDebounce;
-	if(g_ui8IndexDebounce >= MAX_CHECKS)
-	{
-		g_ui8IndexDebounce = 0;
-	}
+    static const uint32_t pui32Ports[5] =
+    {
+        GPIO_PORTA_AHB_BASE, GPIO_PORTB_AHB_BASE, GPIO_PORTC_AHB_BASE,
+        GPIO_PORTD_AHB_BASE, GPIO_PORTE_AHB_BASE
+    };
+    static const uint32_t pui32Ints[5] =
+    {
+        INT_GPIOA, INT_GPIOB, INT_GPIOC, INT_GPIOD, INT_GPIOE
+    };
+    static const uint8_t pui8Pins[5] =
+    {
+        PORTA_INPUT_PINS, PORTB_INPUT_PINS, PORTC_INPUT_PINS,
+        PORTD_INPUT_PINS, PORTE_INPUT_PINS
+    };
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < 5; ui32Idx++)
+    {
+        if(ui32Mode == CAPTURE_EDGE)
+        {
+            GPIOIntTypeSet(pui32Ports[ui32Idx], pui8Pins[ui32Idx],
+                           GPIO_BOTH_EDGES);
+            GPIOIntClear(pui32Ports[ui32Idx], pui8Pins[ui32Idx]);
+            GPIOIntEnable(pui32Ports[ui32Idx], pui8Pins[ui32Idx]);
+            IntEnable(pui32Ints[ui32Idx]);
+        }
+        else
+        {
+            GPIOIntDisable(pui32Ports[ui32Idx], pui8Pins[ui32Idx]);
+        }
+    }
+
+    //
+    // Start from a full debounce window so that whatever is on the pins now
+    // is captured before the sampler is allowed to idle.
+    //
+    g_ui32SettleTicks = DEBOUNCE_MAX_COUNT;
+    g_ui32CaptureMode = ui32Mode;
 }
 
 //*****************************************************************************
 //
-// Debounce switches
+// This is the shared interrupt handler for the switch inputs on ports A to E.
+// The first edge after a quiet period is sampled immediately and the SysTick
+// phase restarted so the rest of the debounce window follows at the normal
+// sample spacing.  A change that sample accepts is handed to the main loop
+// straight away.  Further edges while the window is open just extend it.
 //
 //*****************************************************************************
 void
-DebounceSwitches(void)
+GPIOInputIntHandler(void)
 {
-	unsigned char i,j;
-	j=0xff;
-	for (i=0; i<MAX_CHECKS; i++)
-	{
-		j=j & g_ui8Pad1_1State[i];
-	}
-	g_ui8Pad1_Debounced[0]=j;
-
-	j=0xff;
-	for (i=0; i<MAX_CHECKS; i++)
-	{
-		j=j & g_ui8Pad1_2State[i];
-	}
-	g_ui8Pad1_Debounced[1]=j;
-
-	j=0xff;
-	for (i=0; i<MAX_CHECKS; i++)
-	{
-		j=j & g_ui8Pad1_3State[i];
-	}
-	g_ui8Pad1_Debounced[2]=j;
-
-	j=0xff;
-	for (i=0; i<MAX_CHECKS; i++)
-	{
-		j=j & g_ui8Pad2_1State[i];
-	}
-	g_ui8Pad2_Debounced[0]=j;
-
-	j=0xff;
-	for (i=0; i<MAX_CHECKS; i++)
-	{
-		j=j & g_ui8Pad2_2State[i];
-	}
-	g_ui8Pad2_Debounced[1]=j;
-
-	j=0xff;
-	for (i=0; i<MAX_CHECKS; i++)
-	{
-		j=j & g_ui8Mouse_State[i];
-	}
-	g_ui8Mouse_Debounced[0]=j;
+    GPIOIntClear(GPIO_PORTA_AHB_BASE,
+                 GPIOIntStatus(GPIO_PORTA_AHB_BASE, true) &
+                 PORTA_INPUT_PINS);
+    GPIOIntClear(GPIO_PORTB_AHB_BASE,
+                 GPIOIntStatus(GPIO_PORTB_AHB_BASE, true) &
+                 PORTB_INPUT_PINS);
+    GPIOIntClear(GPIO_PORTC_AHB_BASE,
+                 GPIOIntStatus(GPIO_PORTC_AHB_BASE, true) &
+                 PORTC_INPUT_PINS);
+    GPIOIntClear(GPIO_PORTD_AHB_BASE,
+                 GPIOIntStatus(GPIO_PORTD_AHB_BASE, true) &
+                 PORTD_INPUT_PINS);
+    GPIOIntClear(GPIO_PORTE_AHB_BASE,
+                 GPIOIntStatus(GPIO_PORTE_AHB_BASE, true) &
+                 PORTE_INPUT_PINS);
+
+    if(!g_ui32SettleTicks)
+    {
+        //
+        // Writing any value to the current register reloads SysTick, so the
+        // next periodic sample lands one full tick after this one.  When the
+        // tick is locked to the start of frame its phase is left alone.
+        //
+        if(!SOFSyncEnabled())
+        {
+            HWREG(NVIC_ST_CURRENT) = 0;
+        }
+        if(StoreSwitchesEdge())
+        {
+            g_bPipelinePending = true;
+        }
+    }
+    g_ui32SettleTicks = DEBOUNCE_MAX_COUNT;
 }
 
 //*****************************************************************************
 //
-// Check buttons
+// This is the interrupt handler for the SysTick interrupt.  It is used to
+// update our local tick count and place the board in programming mode when appropriate
 //
 //*****************************************************************************
 void
-CustomHidChangeHandler(void)
+SysTickIntHandler(void)
 {
-	// Local arrays to pass to USB
-	//
-	signed char Pad1[3];
-	signed char Pad2[2];
-	signed char Mouse[3];
+	CYCLE_PROFILE_BEGIN(ui32ProfileStart);
 
-	// If the bus is suspended then resume it.
-	//
-	if(g_bSuspended)
-	{
-		USBDHIDCustomHidRemoteWakeupRequest((void *)&g_sCustomHidDevice);
-	}
+	g_ui32SysTickCount++;
+	SOFSyncTick();
 
-	//Get debounced switch states
 	//
-	DebounceSwitches();
-
-	// Get mouse position data
+	// In edge mode only sample while a change is still settling.  Once the
+	// whole debounce window holds the same state there is nothing to scan,
+	// unless the tick is locked to the start of frame, in which case a last
+	// sample is taken just before the host collects the report.
 	//
-	g_ui8Mouse_Debounced[1] = QEIPositionGet(QEI0_BASE)-127 * MOUSE_SCALAR;
-	QEIPositionSet(QEI0_BASE, 127);
-	g_ui8Mouse_Debounced[2] = QEIPositionGet(QEI1_BASE)-127 * MOUSE_SCALAR;
-	QEIPositionSet(QEI1_BASE, 127);
-
-	bool Equals = true;
-	signed char i;
-	for (i=0; i<3; i++)		//Check for switch state change
-	{
-		if (g_ui8Pad1[i] != g_ui8Pad1_Debounced[i])
-		{
-			Equals = false;
-		}
-	}
-
-	if (!Equals)			//Send report if state has changed
-	{
-		Pad1[0] = g_ui8Pad1_Debounced[0];
-		Pad1[1] = g_ui8Pad1_Debounced[1];
-		Pad1[2] = g_ui8Pad1_Debounced[2];
-		SendHIDReport(1,Pad1);
-	}
-	g_ui8Pad1[0] = g_ui8Pad1_Debounced[0];		//Update old states
-	g_ui8Pad1[1] = g_ui8Pad1_Debounced[1];
-	g_ui8Pad1[2] = g_ui8Pad1_Debounced[2];
-
-	Equals = true;
-	for (i=0; i<2; i++)
+	if(g_ui32CaptureMode == CAPTURE_POLLED)
 	{
-		if (g_ui8Pad2[i] != g_ui8Pad2_Debounced[i])
-		{
-			Equals = false;
-		}
+		StoreSwitches();
 	}
-
-	if (!Equals)
+#if INPUT_SAMPLE_HZ
+	else if(g_ui32CaptureMode == CAPTURE_SAMPLED)
 	{
-		Pad2[0] = g_ui8Pad2_Debounced[0];
-		Pad2[1] = g_ui8Pad2_Debounced[1];
-		SendHIDReport(2,Pad2);
+		StoreSwitchSamples();
 	}
-	g_ui8Pad2[0] = g_ui8Pad2_Debounced[0];
-	g_ui8Pad2[1] = g_ui8Pad2_Debounced[1];
-
-	Equals = true;
-	for (i=0; i<3; i++)
+#endif
+	else if(g_ui32SettleTicks)
 	{
-		if (g_ui8Mouse[i] != g_ui8Mouse_Debounced[i])
-		{
-			Equals = false;
-		}
+		StoreSwitches();
+		g_ui32SettleTicks--;
 	}
-
-	if (!Equals)
+	else if(SOFSyncEnabled())
 	{
-		Mouse[0]=g_ui8Mouse_Debounced[0];
-		Mouse[1]=g_ui8Mouse_Debounced[1];
-		Mouse[2]=g_ui8Mouse_Debounced[2];
-		SendHIDReport(3,Mouse);
+		StoreSwitches();
 	}
-	g_ui8Mouse[0] = g_ui8Mouse_Debounced[0];
-	g_ui8Mouse[1] = g_ui8Mouse_Debounced[1];
-	g_ui8Mouse[2] = g_ui8Mouse_Debounced[2];
-}
-
-//*****************************************************************************
-//
-// This is the interrupt handler for the SysTick interrupt.  It is used to
-// update our local tick count and place the board in programming mode when appropriate
-//
-//*****************************************************************************
-void
-SysTickIntHandler(void)
-{
-	g_ui32SysTickCount++;
-	StoreSwitches();
 
     //
     // If the left button has been pressed, and was previously not pressed,
     // start the process of changing the behavior of the JTAG pins.
     //
-    if(!ROM_GPIOPinRead(GPIO_PORTF_BASE,GPIO_PIN_4))
+    if(!ROM_GPIOPinRead(GPIO_PORTF_AHB_BASE,GPIO_PIN_4))
     {
             //
             // Change PC0-3 into hardware (i.e. JTAG) pins.
             //
-            HWREG(GPIO_PORTC_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_CR) = 0x01;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_AFSEL) |= 0x01;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_CR) = 0x02;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_AFSEL) |= 0x02;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_CR) = 0x04;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_AFSEL) |= 0x04;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_CR) = 0x08;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_AFSEL) |= 0x08;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_CR) = 0x00;
-            HWREG(GPIO_PORTC_BASE + GPIO_O_LOCK) = 0;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_CR) = 0x01;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_AFSEL) |= 0x01;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_CR) = 0x02;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_AFSEL) |= 0x02;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_CR) = 0x04;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_AFSEL) |= 0x04;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_CR) = 0x08;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_AFSEL) |= 0x08;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_CR) = 0x00;
+            HWREG(GPIO_PORTC_AHB_BASE + GPIO_O_LOCK) = 0;
+
+            //
+            // JTAG traffic on PC0-3 must not keep waking the edge sampler.
+            //
+            GPIOIntDisable(GPIO_PORTC_AHB_BASE, PORTC_INPUT_PINS);
 
             //
             // Change the LED to BLUE to indicate that the pins are in JTAG mode.
             //
-            ROM_GPIOPinWrite(GPIO_PORTF_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 4);
+            ROM_GPIOPinWrite(GPIO_PORTF_AHB_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 4);
 
             //
             // Mark device in programming mode
             //
             g_bProgramMode = true;
     }
+
+	CYCLE_PROFILE_END(CYCLE_PROFILE_SYSTICK, ui32ProfileStart);
 }
 
+#if CYCLE_PROFILE_ENABLE
+//*****************************************************************************
+//
+// The USB interrupt handler used when profiling.  It times the USB library's
+// handler, along with the driver and application callbacks made from it.
+//
+//*****************************************************************************
+void
+USB0ProfileIntHandler(void)
+{
+	CYCLE_PROFILE_BEGIN(ui32ProfileStart);
+
+	USB0DeviceIntHandler();
+
+	CYCLE_PROFILE_END(CYCLE_PROFILE_USB_INT, ui32ProfileStart);
+}
+#endif
+
 //*****************************************************************************
 //
 // This is the main loop that runs the application.
@@ -497,6 +595,7 @@ int
 main(void)
 {
     bool bLastSuspend;
+    uint32_t ui32LastTick;
 
     //
     // Enable lazy stacking for interrupt handlers.  This allows floating-point
@@ -514,13 +613,20 @@ main(void)
 	// Initialize the inputs
     PortFunctionInit();
 
+    // Start the microsecond clock and the trackball encoders, then reset the
+    // input pipeline.  Sampling starts with the first SysTick so this has to
+    // come first.
+    HALInit(ROM_SysCtlClockGet());
+    PipelineInit();
+    CYCLE_PROFILE_INIT();
+
     // Set the system tick to control how often the buttons are polled.
 	ROM_SysTickEnable();
 	ROM_SysTickIntEnable();
 	ROM_SysTickPeriodSet(ROM_SysCtlClockGet() / SYSTICKS_PER_SECOND);
 
 	// Set initial LED Status to RED to indicate not connected
-	ROM_GPIOPinWrite(GPIO_PORTF_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 2);
+	ROM_GPIOPinWrite(GPIO_PORTF_AHB_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 2);
 
     //
     // Not configured initially.
@@ -529,52 +635,44 @@ main(void)
     g_bSuspended = false;
     bLastSuspend = false;
     g_bProgramMode = false;
-    g_ui8Pad1_Debounced[0] = 0x00;
-    g_ui8Pad1_Debounced[1] = 0x00;
-    g_ui8Pad1_Debounced[2] = 0x00;
-    g_ui8Pad2_Debounced[0] = 0x00;
-    g_ui8Pad2_Debounced[1] = 0x00;
-    g_ui8Mouse_Debounced[0] = 0x00;
-    g_ui8Mouse_Debounced[1] = 0x00;
-    g_ui8Mouse_Debounced[2] = 0x00;
-    g_ui8Pad1[0] = 0x00;
-    g_ui8Pad1[1] = 0x00;
-    g_ui8Pad1[2] = 0x00;
-    g_ui8Pad2[0] = 0x00;
-    g_ui8Pad2[1] = 0x00;
-    g_ui8Mouse[0] = 0x00;
-    g_ui8Mouse[1] = 0x00;
-    g_ui8Mouse[2] = 0x00;
 
     //
     // Initialize the USB stack for device mode. (must use force on the Tiva launchpad since it doesn't have detection pins connected)
     //
     USBStackModeSet(0, eUSBModeForceDevice, 0);
 
+#if CUSTOMHID_COMPOSITE
+    //
+    // Set up each HID interface as an entry of the composite device, then
+    // initialize the USB controller and connect the composite device to the
+    // bus.
+    //
+    USBDHIDCustomHidCompositeInit(0, &g_sGamepad1Device,
+                                  &g_psCompDevices[CUSTOMHID_IFACE_PAD1]);
+    USBDHIDCustomHidCompositeInit(0, &g_sGamepad2Device,
+                                  &g_psCompDevices[CUSTOMHID_IFACE_PAD2]);
+    USBDHIDCustomHidCompositeInit(0, &g_sMouseDevice,
+                                  &g_psCompDevices[CUSTOMHID_IFACE_MOUSE]);
+    USBDCompositeInit(0, &g_sCompDevice, DESCRIPTOR_DATA_SIZE,
+                      g_pui8DescriptorData);
+#else
     //
     // Pass our device information to the USB HID device class driver,
     // initialize the USB
     // controller and connect the device to the bus.
     //
     USBDHIDCustomHidInit(0, &g_sCustomHidDevice);
+#endif
 
-    //DISable peripheral and int before configuration
-   	QEIDisable(QEI0_BASE);
-   	QEIDisable(QEI1_BASE);
-   	QEIIntDisable(QEI0_BASE,QEI_INTERROR | QEI_INTDIR | QEI_INTTIMER | QEI_INTINDEX);
-   	QEIIntDisable(QEI1_BASE,QEI_INTERROR | QEI_INTDIR | QEI_INTTIMER | QEI_INTINDEX);
-
-   	// Configure quadrature encoder, use a top limit of 256
-   	QEIConfigure(QEI0_BASE, (QEI_CONFIG_CAPTURE_A_B  | QEI_CONFIG_NO_RESET 	| QEI_CONFIG_QUADRATURE | QEI_CONFIG_NO_SWAP), 255);
-   	QEIConfigure(QEI1_BASE, (QEI_CONFIG_CAPTURE_A_B  | QEI_CONFIG_NO_RESET 	| QEI_CONFIG_QUADRATURE | QEI_CONFIG_NO_SWAP), 255);
-
-   	// Enable the quadrature encoder.
-   	QEIEnable(QEI0_BASE);
-   	QEIEnable(QEI1_BASE);
+    //
+    // Measure the start of frame against SysTick.  This has to follow the USB
+    // initialization, which resets the library's tick handlers.
+    //
+    SOFSyncInit(ROM_SysCtlClockGet() / SYSTICKS_PER_SECOND);
+    SOFSyncEnable(SOF_SYNC_ENABLE);
 
-   	//Set position to a middle value so we can see if things are working
-   	QEIPositionSet(QEI0_BASE, 127);
-   	QEIPositionSet(QEI1_BASE, 127);
+   	// Arm the switch inputs for the configured capture mode
+   	InputCaptureModeSet(INPUT_CAPTURE_MODE);
 
     IntMasterEnable();
 
@@ -591,12 +689,12 @@ main(void)
         while(!g_bConnected)
         {
         	//Set the onboard LED to red when not connected
-        	ROM_GPIOPinWrite(GPIO_PORTF_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 2);
+        	ROM_GPIOPinWrite(GPIO_PORTF_AHB_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 2);
         }
 
         //
         // Update the status to green when connected.
-        ROM_GPIOPinWrite(GPIO_PORTF_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 8);
+        ROM_GPIOPinWrite(GPIO_PORTF_AHB_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 8);
         //
         // Enter the idle state.
         //
@@ -608,6 +706,12 @@ main(void)
         //
         bLastSuspend = false;
 
+        //
+        // Allow the first change to be reported straight away.
+        //
+        ui32LastTick = g_ui32SysTickCount;
+        PipelineConnect(ui32LastTick);
+
         //
         // Keep checking the volume buttons for as
         // long as we are connected to the host. This is a simple example
@@ -626,24 +730,57 @@ main(void)
 				if(bLastSuspend)
 				{
 					//Set the onboard LED to red when not connected
-					ROM_GPIOPinWrite(GPIO_PORTF_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 2);
+					ROM_GPIOPinWrite(GPIO_PORTF_AHB_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 2);
 				}
 				else
 				{
 				    // Update the status to green when connected.
-					ROM_GPIOPinWrite(GPIO_PORTF_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 8);
+					ROM_GPIOPinWrite(GPIO_PORTF_AHB_BASE,GPIO_PIN_1|GPIO_PIN_2|GPIO_PIN_3, 8);
 				}
 			}
 
-		    if(g_ui32SysTickCount>=8  && !g_bProgramMode)
+		    //
+		    // Write the next word of any settings the host has changed.
+		    //
+		    ConfigSave();
+
+		    //
+		    // Check the inputs once per tick, or at once when the switch
+		    // interrupt has accepted a change, so that a change goes out in
+		    // the next USB frame, as long as the report interval has elapsed.
+		    //
+		    if(((g_ui32SysTickCount != ui32LastTick) || g_bPipelinePending) &&
+		       !g_bProgramMode)
 		    {
-		    	//Reset systick counter
-		    	g_ui32SysTickCount = 0;
-
-				//Check inputs and act accordingly
-		    	CustomHidChangeHandler();
+		    	g_bPipelinePending = false;
+		    	ui32LastTick = g_ui32SysTickCount;
+
+		    	//
+		    	// If the bus is suspended then resume it.
+		    	//
+		    	if(g_bSuspended)
+		    	{
+		    		HALRemoteWakeup();
+		    	}
+
+		    	PipelineTick(ui32LastTick);
+		    }
+		    else if(g_ui32CaptureMode == CAPTURE_EDGE && !g_ui32SettleTicks)
+		    {
+		    	//
+		    	// Nothing is settling so sleep until the next interrupt.  The
+		    	// checks are made again with interrupts masked, so one landing
+		    	// after them still wakes the processor, which takes it once
+		    	// they are unmasked.
+		    	//
+		    	ROM_IntMasterDisable();
+		    	if(!g_ui32SettleTicks && !g_bPipelinePending &&
+		    	   (g_ui32SysTickCount == ui32LastTick))
+		    	{
+		    		ROM_SysCtlSleep();
+		    	}
+		    	ROM_IntMasterEnable();
 		    }
-
 
         }
     }
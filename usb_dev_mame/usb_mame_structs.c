@@ -30,6 +30,7 @@
 #include "usblib/usbhid.h"
 #include "usblib/usb-ids.h"
 #include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdcomp.h"
 #include "usblib/device/usbdhid.h"
 #include "usblib/device/usbdhidmame.h"
 #include "usb_mame_structs.h"
@@ -129,6 +130,89 @@ const uint8_t * const g_ppui8StringDescriptors[] =
 #define NUM_STRING_DESCRIPTORS (sizeof(g_ppui8StringDescriptors) /            \
                                 sizeof(uint8_t *))
 
+#if CUSTOMHID_COMPOSITE
+//*****************************************************************************
+//
+// The HID device initialization and customization structures for the
+// composite build, one for each interface.  The composite device below
+// presents its own VID, PID and power settings to the host.
+//
+//*****************************************************************************
+tUSBDHIDCustomHidDevice g_sGamepad1Device =
+{
+    USB_VID_TI_1CBE,
+    0x0010,
+    500,
+    USB_CONF_ATTR_SELF_PWR | USB_CONF_ATTR_RWAKE,
+    CustomHidHandler,
+    (void *)&g_sGamepad1Device,
+    g_ppui8StringDescriptors,
+    NUM_STRING_DESCRIPTORS,
+    CUSTOMHID_IFACE_PAD1
+};
+
+tUSBDHIDCustomHidDevice g_sGamepad2Device =
+{
+    USB_VID_TI_1CBE,
+    0x0010,
+    500,
+    USB_CONF_ATTR_SELF_PWR | USB_CONF_ATTR_RWAKE,
+    CustomHidHandler,
+    (void *)&g_sGamepad2Device,
+    g_ppui8StringDescriptors,
+    NUM_STRING_DESCRIPTORS,
+    CUSTOMHID_IFACE_PAD2
+};
+
+tUSBDHIDCustomHidDevice g_sMouseDevice =
+{
+    USB_VID_TI_1CBE,
+    0x0010,
+    500,
+    USB_CONF_ATTR_SELF_PWR | USB_CONF_ATTR_RWAKE,
+    CustomHidHandler,
+    (void *)&g_sMouseDevice,
+    g_ppui8StringDescriptors,
+    NUM_STRING_DESCRIPTORS,
+    CUSTOMHID_IFACE_MOUSE
+};
+
+//*****************************************************************************
+//
+// The array of devices supported by this composite device.  The entries are
+// filled in by USBDHIDCustomHidCompositeInit().
+//
+//*****************************************************************************
+tCompositeEntry g_psCompDevices[CUSTOMHID_NUM_IFACES];
+
+//*****************************************************************************
+//
+// The memory allocated to hold the composite descriptor that is created by
+// the call to USBDCompositeInit().
+//
+//*****************************************************************************
+uint8_t g_pui8DescriptorData[DESCRIPTOR_DATA_SIZE];
+
+//*****************************************************************************
+//
+// The composite device initialization and customization structure.  The
+// composite driver assigns each HID interface its own interface number and
+// interrupt IN endpoint.
+//
+//*****************************************************************************
+tUSBDCompositeDevice g_sCompDevice =
+{
+    USB_VID_TI_1CBE,
+    0x0010,
+    500,
+    USB_CONF_ATTR_SELF_PWR | USB_CONF_ATTR_RWAKE,
+    0,
+    g_ppui8StringDescriptors,
+    NUM_STRING_DESCRIPTORS,
+    CUSTOMHID_NUM_IFACES,
+    g_psCompDevices
+};
+#else
 //*****************************************************************************
 //
 // The HID keyboard device initialization and customization structures.
@@ -143,5 +227,7 @@ tUSBDHIDCustomHidDevice g_sCustomHidDevice =
     CustomHidHandler,
     (void *)&g_sCustomHidDevice,
     g_ppui8StringDescriptors,
-    NUM_STRING_DESCRIPTORS
+    NUM_STRING_DESCRIPTORS,
+    CUSTOMHID_IFACE_ALL
 };
+#endif
@@ -29,6 +29,17 @@ extern uint32_t CustomHidHandler(void *pvCBData,
                                      uint32_t ui32Event,
                                      uint32_t ui32MsgData,
                                      void *pvMsgData);
+#if CUSTOMHID_COMPOSITE
+#define DESCRIPTOR_DATA_SIZE    (COMPOSITE_DHID_SIZE * CUSTOMHID_NUM_IFACES)
+
+extern tUSBDHIDCustomHidDevice g_sGamepad1Device;
+extern tUSBDHIDCustomHidDevice g_sGamepad2Device;
+extern tUSBDHIDCustomHidDevice g_sMouseDevice;
+extern tCompositeEntry g_psCompDevices[];
+extern uint8_t g_pui8DescriptorData[];
+extern tUSBDCompositeDevice g_sCompDevice;
+#else
 extern tUSBDHIDCustomHidDevice g_sCustomHidDevice;
+#endif
 
 #endif
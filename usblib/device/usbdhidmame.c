@@ -27,6 +27,7 @@
 #include <stdint.h>
 #include "inc/hw_types.h"
 #include "driverlib/debug.h"
+#include "driverlib/interrupt.h"
 #include "driverlib/usb.h"
 #include "usblib/usblib.h"
 #include "usblib/usblibpriv.h"
@@ -111,6 +112,271 @@ const uint8_t g_pui8HIDInEndpoint[HIDINENDPOINT_SIZE] =
     1,                         // The polling interval for this endpoint.
 };
 
+//*****************************************************************************
+//
+// The report descriptor items for gamepad one, report ID 1.  The report is a
+// 2 bit X and Y hat, 4 bits of padding, 12 buttons and 4 more bits of
+// padding.
+//
+//*****************************************************************************
+#define CUSTOMHID_PAD1_ITEMS                                                  \
+		UsagePage(USB_HID_GENERIC_DESKTOP),                                   \
+		    Usage(USB_HID_GAMEPAD),                                           \
+		    Collection(USB_HID_APPLICATION),                                  \
+		        Collection(USB_HID_PHYSICAL),                                 \
+		    	ReportID(1),                                                  \
+				UsagePage(USB_HID_GENERIC_DESKTOP),                           \
+				Usage(USB_HID_X),                                             \
+				Usage(USB_HID_Y),                                             \
+				LogicalMinimum(-1),                                           \
+				LogicalMaximum(1),                                            \
+				ReportSize(2),                                                \
+				ReportCount(2),                                               \
+				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |           \
+				      USB_HID_INPUT_ABS | USB_HID_INPUT_NONULL),              \
+				ReportCount(4),                                               \
+				ReportSize(1),                                                \
+				Input(USB_HID_INPUT_CONSTANT | USB_HID_INPUT_ARRAY |          \
+				      USB_HID_INPUT_ABS),                                     \
+				UsagePage(USB_HID_BUTTONS),                                   \
+				UsageMinimum(1),                                              \
+				UsageMaximum(12),                                             \
+				LogicalMinimum(0),                                            \
+				LogicalMaximum(1),                                            \
+				ReportSize(1),                                                \
+				ReportCount(12),                                              \
+				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |           \
+				      USB_HID_INPUT_ABS),                                     \
+				ReportSize(4),                                                \
+				ReportCount(1),                                               \
+				Input(USB_HID_INPUT_CONSTANT | USB_HID_INPUT_ARRAY |          \
+				      USB_HID_INPUT_ABS),                                     \
+		        EndCollection,                                                \
+		    EndCollection
+
+//*****************************************************************************
+//
+// The report descriptor items for gamepad two, report ID 2.  The report is a
+// 2 bit X and Y hat, 4 bits of padding and 8 buttons.
+//
+//*****************************************************************************
+#define CUSTOMHID_PAD2_ITEMS                                                  \
+		UsagePage(USB_HID_GENERIC_DESKTOP),                                   \
+		    Usage(USB_HID_GAMEPAD),                                           \
+		    Collection(USB_HID_APPLICATION),                                  \
+		        Collection(USB_HID_PHYSICAL),                                 \
+		    	ReportID(2),                                                  \
+				UsagePage(USB_HID_GENERIC_DESKTOP),                           \
+				Usage(USB_HID_X),                                             \
+				Usage(USB_HID_Y),                                             \
+				LogicalMinimum(-1),                                           \
+				LogicalMaximum(1),                                            \
+				ReportSize(2),                                                \
+				ReportCount(2),                                               \
+				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |           \
+				      USB_HID_INPUT_ABS | USB_HID_INPUT_NONULL),              \
+				ReportCount(4),                                               \
+				ReportSize(1),                                                \
+				Input(USB_HID_INPUT_CONSTANT | USB_HID_INPUT_ARRAY |          \
+				      USB_HID_INPUT_ABS),                                     \
+				UsagePage(USB_HID_BUTTONS),                                   \
+				UsageMinimum(1),                                              \
+				UsageMaximum(8),                                              \
+				LogicalMinimum(0),                                            \
+				LogicalMaximum(1),                                            \
+				ReportSize(1),                                                \
+				ReportCount(8),                                               \
+				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |           \
+				      USB_HID_INPUT_ABS),                                     \
+		        EndCollection,                                                \
+		    EndCollection
+
+//*****************************************************************************
+//
+// The report descriptor items for the mouse, report ID 3.  The report is 2
+// buttons, 6 bits of padding and relative X and Y, then the wheel when built
+// with CUSTOMHID_SPINNER.
+//
+//*****************************************************************************
+#define CUSTOMHID_MOUSE_ITEMS                                                 \
+		UsagePage(USB_HID_GENERIC_DESKTOP),                                   \
+		    Usage(USB_HID_MOUSE),                                             \
+		    Collection(USB_HID_APPLICATION),                                  \
+		        Usage(USB_HID_POINTER),                                       \
+		        Collection(USB_HID_PHYSICAL),                                 \
+		    	ReportID(CUSTOMHID_REPORT_ID_MOUSE),                          \
+				UsagePage(USB_HID_BUTTONS),                                   \
+				UsageMinimum(1),                                              \
+				UsageMaximum(2),                                              \
+				LogicalMinimum(0),                                            \
+				LogicalMaximum(1),                                            \
+				ReportSize(1),                                                \
+				ReportCount(2),                                               \
+				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |           \
+				      USB_HID_INPUT_ABS),                                     \
+				ReportSize(6),                                                \
+				ReportCount(1),                                               \
+				Input(USB_HID_INPUT_CONSTANT | USB_HID_INPUT_ARRAY |          \
+				      USB_HID_INPUT_ABS),                                     \
+				UsagePage(USB_HID_GENERIC_DESKTOP),                           \
+				Usage(USB_HID_X),                                             \
+				Usage(USB_HID_Y),                                             \
+				CUSTOMHID_SPINNER_USAGE(USB_HID_WHEEL)                        \
+				CUSTOMHID_MOUSE_AXIS_ITEMS,                                   \
+				ReportCount(CUSTOMHID_MOUSE_AXES),                            \
+				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |           \
+				      USB_HID_INPUT_RELATIVE),                                \
+		        EndCollection,                                                \
+		    EndCollection
+
+//*****************************************************************************
+//
+// Items that the descriptor macros in usbdhid.h can not express: the first
+// vendor defined usage page and two byte logical limits.
+//
+//*****************************************************************************
+#define CUSTOMHID_USAGE_PAGE_VENDOR                                           \
+                                0x06, 0x00, 0xFF
+#define CUSTOMHID_LOGICAL_MAX_255                                             \
+                                0x26, 0xFF, 0x00
+#define CUSTOMHID_LOGICAL_MIN_N32767                                          \
+                                0x16, 0x01, 0x80
+#define CUSTOMHID_LOGICAL_MAX_32767                                           \
+                                0x26, 0xFF, 0x7F
+#define CUSTOMHID_LOGICAL_MAX_ANALOG                                          \
+                                0x26, (CUSTOMHID_ANALOG_MAX & 0xFF),          \
+                                (CUSTOMHID_ANALOG_MAX >> 8)
+
+//*****************************************************************************
+//
+// The logical range and size of each trackball axis, 8 bit or, with
+// CUSTOMHID_MOUSE_16BIT, 16 bit.
+//
+//*****************************************************************************
+#if CUSTOMHID_MOUSE_16BIT
+#define CUSTOMHID_MOUSE_AXIS_ITEMS                                            \
+				CUSTOMHID_LOGICAL_MIN_N32767,                                 \
+				CUSTOMHID_LOGICAL_MAX_32767,                                  \
+				ReportSize(16)
+#else
+#define CUSTOMHID_MOUSE_AXIS_ITEMS                                            \
+				LogicalMinimum(-127),                                         \
+				LogicalMaximum(127),                                          \
+				ReportSize(8)
+#endif
+
+//*****************************************************************************
+//
+// The usage of the spinner axis, with its trailing comma, or nothing when
+// there is no spinner.
+//
+//*****************************************************************************
+#if CUSTOMHID_SPINNER
+#define CUSTOMHID_SPINNER_USAGE(usage)                                        \
+				Usage(usage),
+#else
+#define CUSTOMHID_SPINNER_USAGE(usage)
+#endif
+
+//*****************************************************************************
+//
+// The report descriptor items for the analog inputs, report ID 8.  The report
+// is CUSTOMHID_ANALOG_AXES 16 bit absolute axes, taken from X, Y, Z and Rz in
+// turn.
+//
+//*****************************************************************************
+#define CUSTOMHID_ANALOG_ITEMS                                                \
+		UsagePage(USB_HID_GENERIC_DESKTOP),                                   \
+		    Usage(USB_HID_JOYSTICK),                                          \
+		    Collection(USB_HID_APPLICATION),                                  \
+		        Collection(USB_HID_PHYSICAL),                                 \
+		    	ReportID(CUSTOMHID_REPORT_ID_ANALOG),                         \
+				UsagePage(USB_HID_GENERIC_DESKTOP),                           \
+				Usage(USB_HID_X),                                             \
+				Usage(USB_HID_Y),                                             \
+				Usage(USB_HID_Z),                                             \
+				Usage(USB_HID_RZ),                                            \
+				LogicalMinimum(0),                                            \
+				CUSTOMHID_LOGICAL_MAX_ANALOG,                                 \
+				ReportSize(16),                                               \
+				ReportCount(CUSTOMHID_ANALOG_AXES),                           \
+				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |           \
+				      USB_HID_INPUT_ABS),                                     \
+		        EndCollection,                                                \
+		    EndCollection
+
+//*****************************************************************************
+//
+// The report descriptor items for the diagnostics and settings, the latency
+// statistics in feature report CUSTOMHID_REPORT_ID_LATENCY, the cycle counts
+// in feature report CUSTOMHID_REPORT_ID_CYCLES, the trackball settings in
+// feature report CUSTOMHID_REPORT_ID_MOUSE_CONFIG, the settings profile in
+// use in feature report CUSTOMHID_REPORT_ID_PROFILE_SELECT and the settings
+// commands in feature report CUSTOMHID_REPORT_ID_SETTINGS.  The contents are
+// opaque bytes laid out by the application.
+//
+//*****************************************************************************
+#define CUSTOMHID_DIAG_ITEMS                                                  \
+		CUSTOMHID_USAGE_PAGE_VENDOR,                                          \
+		    Usage(1),                                                         \
+		    Collection(USB_HID_APPLICATION),                                  \
+		    	ReportID(CUSTOMHID_REPORT_ID_LATENCY),                        \
+				Usage(1),                                                     \
+				LogicalMinimum(0),                                            \
+				CUSTOMHID_LOGICAL_MAX_255,                                    \
+				ReportSize(8),                                                \
+				ReportCount(CUSTOMHID_LATENCY_SIZE),                          \
+				Feature(USB_HID_FEATURE_DATA | USB_HID_FEATURE_VARIABLE |     \
+				        USB_HID_FEATURE_ABS),                                 \
+		    	ReportID(CUSTOMHID_REPORT_ID_CYCLES),                         \
+				Usage(2),                                                     \
+				ReportCount(CUSTOMHID_CYCLES_SIZE),                           \
+				Feature(USB_HID_FEATURE_DATA | USB_HID_FEATURE_VARIABLE |     \
+				        USB_HID_FEATURE_ABS),                                 \
+		    	ReportID(CUSTOMHID_REPORT_ID_MOUSE_CONFIG),                   \
+				Usage(3),                                                     \
+				ReportCount(CUSTOMHID_MOUSE_CONFIG_SIZE),                     \
+				Feature(USB_HID_FEATURE_DATA | USB_HID_FEATURE_VARIABLE |     \
+				        USB_HID_FEATURE_ABS),                                 \
+		    	ReportID(CUSTOMHID_REPORT_ID_PROFILE_SELECT),                 \
+				Usage(4),                                                     \
+				ReportCount(CUSTOMHID_PROFILE_SELECT_SIZE),                   \
+				Feature(USB_HID_FEATURE_DATA | USB_HID_FEATURE_VARIABLE |     \
+				        USB_HID_FEATURE_ABS),                                 \
+		    	ReportID(CUSTOMHID_REPORT_ID_SETTINGS),                       \
+				Usage(5),                                                     \
+				ReportCount(CUSTOMHID_SETTINGS_SIZE),                         \
+				Feature(USB_HID_FEATURE_DATA | USB_HID_FEATURE_VARIABLE |     \
+				        USB_HID_FEATURE_ABS),                                 \
+		    EndCollection
+
+#if CUSTOMHID_COMPOSITE
+//*****************************************************************************
+//
+// The report descriptors for the composite build, one per interface.  The
+// diagnostics reports are on the first interface and the analog inputs, which
+// take the place of the player two joystick, on the second.
+//
+//*****************************************************************************
+static const uint8_t g_pui8Pad1ReportDescriptor[] =
+{
+    CUSTOMHID_PAD1_ITEMS,
+    CUSTOMHID_DIAG_ITEMS
+};
+
+static const uint8_t g_pui8Pad2ReportDescriptor[] =
+{
+    CUSTOMHID_PAD2_ITEMS,
+#if CUSTOMHID_ANALOG_AXES
+    CUSTOMHID_ANALOG_ITEMS
+#endif
+};
+
+static const uint8_t g_pui8MouseReportDescriptor[] =
+{
+    CUSTOMHID_MOUSE_ITEMS
+};
+#else
 //*****************************************************************************
 //
 // The report descriptor for the Mame class device. (Built off CustomHid example)
@@ -118,158 +384,143 @@ const uint8_t g_pui8HIDInEndpoint[HIDINENDPOINT_SIZE] =
 //*****************************************************************************
 static const uint8_t g_pui8CustomHidReportDescriptor[] =
 {
+#if CUSTOMHID_COMBINED_REPORT
+		//
+		// Both players and the trackball in a single report.  Windows ties each
+		// report ID to one top level collection, so this is one gamepad with
+		// player two on the Rx/Ry hat and buttons 13-20, the trackball buttons
+		// as buttons 21-22 and the trackball motion on relative Z/Rz axes,
+		// followed by the spinner on a relative dial.
+		//
 		UsagePage(USB_HID_GENERIC_DESKTOP),
 		    Usage(USB_HID_GAMEPAD),
 		    Collection(USB_HID_APPLICATION),
 		        Collection(USB_HID_PHYSICAL),
 
-		    	ReportID(1),
+		    	ReportID(CUSTOMHID_REPORT_ID_COMBINED),
 				//
-				// The X and Y (Will appear as two thumb controls).
+				// Player one X/Y and player two Rx/Ry.
 				//
 				UsagePage(USB_HID_GENERIC_DESKTOP),
 				Usage(USB_HID_X),
 				Usage(USB_HID_Y),
+				Usage(USB_HID_RX),
+				Usage(USB_HID_RY),
 				LogicalMinimum(-1),
 				LogicalMaximum(1),
 				ReportSize(2),
-				ReportCount(2),
-				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS | USB_HID_INPUT_NONULL),
-
 				ReportCount(4),
-				ReportSize(1),
-				Input(USB_HID_INPUT_CONSTANT | USB_HID_INPUT_ARRAY | USB_HID_INPUT_ABS),
+				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS | USB_HID_INPUT_NONULL),
 
 				//
-				// 12 - 1 bit values for the first set of buttons.
+				// 22 - 1 bit values for player one, player two and the
+				// trackball buttons.
 				//
 				UsagePage(USB_HID_BUTTONS),
 				UsageMinimum(1),
-				UsageMaximum(12),
+				UsageMaximum(22),
 				LogicalMinimum(0),
 				LogicalMaximum(1),
 				ReportSize(1),
-				ReportCount(12),
+				ReportCount(22),
 				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS),
 
 				//
-				// 1 - 4 bit unused constant value to fill the second 8 bits.
+				// 1 - 2 bit unused constant value to fill the 24 bits.
 				//
-				ReportSize(4),
+				ReportSize(2),
 				ReportCount(1),
 				Input(USB_HID_INPUT_CONSTANT | USB_HID_INPUT_ARRAY | USB_HID_INPUT_ABS),
 
-		        EndCollection,
-		    EndCollection,
+				//
+				// 2 - 8 or 16 bit relative values for the trackball, and a
+				// third for the spinner when there is one.
+				//
+				UsagePage(USB_HID_GENERIC_DESKTOP),
+				Usage(USB_HID_Z),
+				Usage(USB_HID_RZ),
+				CUSTOMHID_SPINNER_USAGE(USB_HID_DIAL)
+				CUSTOMHID_MOUSE_AXIS_ITEMS,
+				ReportCount(CUSTOMHID_MOUSE_AXES),
+				Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_RELATIVE),
 
-		    UsagePage(USB_HID_GENERIC_DESKTOP),
-		        Usage(USB_HID_GAMEPAD),
-		        Collection(USB_HID_APPLICATION),
-		            Collection(USB_HID_PHYSICAL),
-
-		        	ReportID(2),
-		    		//
-		    		// The X, Y Z and Rx (Will appear as two thumb controls.
-		    		//
-		    		UsagePage(USB_HID_GENERIC_DESKTOP),
-		    		Usage(USB_HID_X),
-		    		Usage(USB_HID_Y),
-		    		LogicalMinimum(-1),
-		    		LogicalMaximum(1),
-		    		ReportSize(2),
-		    		ReportCount(2),
-		    		Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS | USB_HID_INPUT_NONULL),
-
-		    		ReportCount(4),
-		    		ReportSize(1),
-		    		Input(USB_HID_INPUT_CONSTANT | USB_HID_INPUT_ARRAY | USB_HID_INPUT_ABS),
-
-		    		//
-		    		// 8 - 1 bit values for the first set of buttons.
-		    		//
-		    		UsagePage(USB_HID_BUTTONS),
-		    		UsageMinimum(1),
-		    		UsageMaximum(8),
-		    		LogicalMinimum(0),
-		    		LogicalMaximum(1),
-		    		ReportSize(1),
-		    		ReportCount(8),
-		    		Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS),
-
-		            EndCollection,
 		        EndCollection,
-
-		        UsagePage(USB_HID_GENERIC_DESKTOP),
-					Usage(USB_HID_MOUSE),
-					Collection(USB_HID_APPLICATION),
-						Usage(USB_HID_POINTER),
-						Collection(USB_HID_PHYSICAL),
-
-							ReportID(3),
-							//
-							// The buttons.
-							//
-							UsagePage(USB_HID_BUTTONS),
-							UsageMinimum(1),
-							UsageMaximum(2),
-							LogicalMinimum(0),
-							LogicalMaximum(1),
-
-							//
-							// 2 - 1 bit values for the buttons.
-							//
-							ReportSize(1),
-							ReportCount(2),
-							Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS),
-
-							//
-							// 1 - 6 bit unused constant value to fill the 8 bits.
-							//
-							ReportSize(6),
-							ReportCount(1),
-							Input(USB_HID_INPUT_CONSTANT | USB_HID_INPUT_ARRAY | USB_HID_INPUT_ABS),
-
-							//
-							// The X and Y axis.
-							//
-							UsagePage(USB_HID_GENERIC_DESKTOP),
-							Usage(USB_HID_X),
-							Usage(USB_HID_Y),
-							LogicalMinimum(-127),
-							LogicalMaximum(127),
-
-							//
-							// 2 - 8 bit Values for x and y.
-							//
-							ReportSize(8),
-							ReportCount(2),
-							Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_RELATIVE),
-
-
-						EndCollection,
-					EndCollection,
-
+		    EndCollection,
+#else
+    CUSTOMHID_PAD1_ITEMS,
+    CUSTOMHID_PAD2_ITEMS,
+    CUSTOMHID_MOUSE_ITEMS,
+#endif
+#if CUSTOMHID_ANALOG_AXES
+    CUSTOMHID_ANALOG_ITEMS,
+#endif
+    CUSTOMHID_DIAG_ITEMS
 };
+#endif
 
 //*****************************************************************************
 //
-// The HID descriptor for the customhid device.
+// Returns the length, including the report ID, of an input report.
 //
 //*****************************************************************************
-static const tHIDDescriptor g_sCustomHidHIDDescriptor =
+static uint8_t
+HIDCustomHidReportSize(uint8_t ReportID)
 {
-    9,                              // bLength
-    USB_HID_DTYPE_HID,              // bDescriptorType
-    0x111,                          // bcdHID (version 1.11 compliant)
-    0,                              // bCountryCode (not localized)
-    1,                              // bNumDescriptors
+#if CUSTOMHID_COMBINED_REPORT
+    if(ReportID == CUSTOMHID_REPORT_ID_COMBINED)
     {
-        {
-            USB_HID_DTYPE_REPORT,   // Report descriptor
-            sizeof(g_pui8CustomHidReportDescriptor)
-                                    // Size of report descriptor
-        }
+        return(CUSTOMHID_COMBINED_SIZE + 1);
+    }
+#endif
+    if(ReportID == CUSTOMHID_REPORT_ID_MOUSE)
+    {
+        return(CUSTOMHID_MOUSE_SIZE + 1);
+    }
+    if(ReportID == CUSTOMHID_REPORT_ID_ANALOG)
+    {
+        return(CUSTOMHID_ANALOG_SIZE + 1);
     }
+
+    //
+    // Gamepad two carries the hat and 8 buttons in two bytes after the ID,
+    // and gamepad one the hat and 12 buttons in three.
+    //
+    if(ReportID == 2)
+    {
+        return(3);
+    }
+    return(4);
+}
+
+//*****************************************************************************
+//
+// The HID descriptor for each interface.
+//
+//*****************************************************************************
+#define CUSTOMHID_HID_DESCRIPTOR(pui8Report)                                  \
+{                                                                             \
+    9,                              /* bLength */                             \
+    USB_HID_DTYPE_HID,              /* bDescriptorType */                     \
+    0x111,                          /* bcdHID (version 1.11 compliant) */     \
+    0,                              /* bCountryCode (not localized) */        \
+    1,                              /* bNumDescriptors */                     \
+    {                                                                         \
+        {                                                                     \
+            USB_HID_DTYPE_REPORT,   /* Report descriptor */                   \
+            sizeof(pui8Report)      /* Size of report descriptor */           \
+        }                                                                     \
+    }                                                                         \
+}
+
+static const tHIDDescriptor g_psCustomHidHIDDescriptors[CUSTOMHID_NUM_IFACES] =
+{
+#if CUSTOMHID_COMPOSITE
+    CUSTOMHID_HID_DESCRIPTOR(g_pui8Pad1ReportDescriptor),
+    CUSTOMHID_HID_DESCRIPTOR(g_pui8Pad2ReportDescriptor),
+    CUSTOMHID_HID_DESCRIPTOR(g_pui8MouseReportDescriptor)
+#else
+    CUSTOMHID_HID_DESCRIPTOR(g_pui8CustomHidReportDescriptor)
+#endif
 };
 
 //*****************************************************************************
@@ -284,6 +535,10 @@ static const tHIDDescriptor g_sCustomHidHIDDescriptor =
 // 4.  The mandatory interrupt IN endpoint descriptor (FLASH).
 // 5.  The optional interrupt OUT endpoint descriptor (FLASH).
 //
+// In the composite build every interface uses the same interface and endpoint
+// templates.  The composite driver renumbers the interfaces and endpoints as
+// it builds the full configuration descriptor.
+//
 //*****************************************************************************
 const tConfigSection g_sHIDConfigSection =
 {
@@ -305,32 +560,59 @@ const tConfigSection g_sHIDInEndpointSection =
 
 //*****************************************************************************
 //
-// Place holder for the user's HID descriptor block.
+// Place holders for the HID descriptor block of each interface.
 //
 //*****************************************************************************
-tConfigSection g_sHIDDescriptorSection =
+tConfigSection g_psHIDDescriptorSections[CUSTOMHID_NUM_IFACES] =
 {
-   sizeof(g_sCustomHidHIDDescriptor),
-   (const uint8_t *)&g_sCustomHidHIDDescriptor
+   {
+       sizeof(tHIDDescriptor),
+       (const uint8_t *)&g_psCustomHidHIDDescriptors[0]
+   },
+#if CUSTOMHID_COMPOSITE
+   {
+       sizeof(tHIDDescriptor),
+       (const uint8_t *)&g_psCustomHidHIDDescriptors[1]
+   },
+   {
+       sizeof(tHIDDescriptor),
+       (const uint8_t *)&g_psCustomHidHIDDescriptors[2]
+   }
+#endif
 };
 
 //*****************************************************************************
 //
-// This array lists all the sections that must be concatenated to make a
-// single, complete HID configuration descriptor.
+// These arrays list all the sections that must be concatenated to make a
+// single, complete HID configuration descriptor for each interface.
 //
 //*****************************************************************************
-const tConfigSection *g_psHIDSections[] =
+#define NUM_HID_SECTIONS        4
+
+const tConfigSection *g_ppsHIDSections[CUSTOMHID_NUM_IFACES][NUM_HID_SECTIONS] =
 {
-    &g_sHIDConfigSection,
-    &g_sHIDInterfaceSection,
-    &g_sHIDDescriptorSection,
-    &g_sHIDInEndpointSection,
+    {
+        &g_sHIDConfigSection,
+        &g_sHIDInterfaceSection,
+        &g_psHIDDescriptorSections[0],
+        &g_sHIDInEndpointSection,
+    },
+#if CUSTOMHID_COMPOSITE
+    {
+        &g_sHIDConfigSection,
+        &g_sHIDInterfaceSection,
+        &g_psHIDDescriptorSections[1],
+        &g_sHIDInEndpointSection,
+    },
+    {
+        &g_sHIDConfigSection,
+        &g_sHIDInterfaceSection,
+        &g_psHIDDescriptorSections[2],
+        &g_sHIDInEndpointSection,
+    }
+#endif
 };
 
-#define NUM_HID_SECTIONS        (sizeof(g_psHIDSections) /                    \
-                                 sizeof(g_psHIDSections[0]))
-
 //*****************************************************************************
 //
 // The header for the single configuration we support.  This is the root of
@@ -340,10 +622,13 @@ const tConfigSection *g_psHIDSections[] =
 // client supplied initialization parameters.
 //
 //*****************************************************************************
-tConfigHeader g_sHIDConfigHeader =
+tConfigHeader g_psHIDConfigHeaders[CUSTOMHID_NUM_IFACES] =
 {
-    NUM_HID_SECTIONS,
-    g_psHIDSections
+    { NUM_HID_SECTIONS, g_ppsHIDSections[0] },
+#if CUSTOMHID_COMPOSITE
+    { NUM_HID_SECTIONS, g_ppsHIDSections[1] },
+    { NUM_HID_SECTIONS, g_ppsHIDSections[2] }
+#endif
 };
 
 //*****************************************************************************
@@ -351,20 +636,30 @@ tConfigHeader g_sHIDConfigHeader =
 // Configuration Descriptor.
 //
 //*****************************************************************************
-const tConfigHeader * const g_ppsHIDConfigDescriptors[] =
+const tConfigHeader * const g_pppsHIDConfigDescriptors[CUSTOMHID_NUM_IFACES][1] =
 {
-    &g_sHIDConfigHeader
+    { &g_psHIDConfigHeaders[0] },
+#if CUSTOMHID_COMPOSITE
+    { &g_psHIDConfigHeaders[1] },
+    { &g_psHIDConfigHeaders[2] }
+#endif
 };
 
 //*****************************************************************************
 //
-// The HID class descriptor table.  For the customhid class, we have only a single
-// report descriptor.
+// The HID class descriptor table.  Each interface has only a single report
+// descriptor.
 //
 //*****************************************************************************
-static const uint8_t * const g_pui8CustomHidClassDescriptors[] =
+static const uint8_t * const g_pppui8CustomHidClassDescriptors[CUSTOMHID_NUM_IFACES][1] =
 {
-    g_pui8CustomHidReportDescriptor
+#if CUSTOMHID_COMPOSITE
+    { g_pui8Pad1ReportDescriptor },
+    { g_pui8Pad2ReportDescriptor },
+    { g_pui8MouseReportDescriptor }
+#else
+    { g_pui8CustomHidReportDescriptor }
+#endif
 };
 
 //*****************************************************************************
@@ -377,6 +672,71 @@ static uint32_t HIDCustomHidRxHandler(void *pvCustomHidDevice, uint32_t ui32Even
 static uint32_t HIDCustomHidTxHandler(void *pvCustomHidDevice, uint32_t ui32Event,
                                   uint32_t ui32MsgData, void *pvMsgData);
 
+//*****************************************************************************
+//
+// Starts transmission of the oldest queued report if the interrupt IN
+// endpoint is free.
+//
+// \param psCustomHidDevice is the customhid device instance.
+//
+// This function must be called either from the USB interrupt or with
+// interrupts disabled since it updates the transmit queue.  A report that
+// could not be handed to the lower layer stays queued and is retried on the
+// next call.
+//
+// \return Returns \b CUSTOMHID_SUCCESS if a report was scheduled or nothing
+// was waiting, or \b CUSTOMHID_ERR_TX_ERROR if the lower layer refused it.
+//
+//*****************************************************************************
+static uint32_t
+HIDCustomHidTxNext(tUSBDHIDCustomHidDevice *psCustomHidDevice)
+{
+    tHIDCustomHidInstance *psInst;
+    tUSBDHIDDevice *psHIDDevice;
+    uint8_t *pui8Slot;
+    uint8_t i;
+
+    psInst = &psCustomHidDevice->sPrivateData;
+    psHIDDevice = &psInst->sHIDDevice;
+
+    //
+    // Nothing to do if the queue is empty or a report is still in flight.
+    //
+    if(!psInst->ui8TxCount ||
+       (psInst->iCustomHidState == eHIDCustomHidStateSend) ||
+       !USBDHIDTxPacketAvailable((void *)psHIDDevice))
+    {
+        return(CUSTOMHID_SUCCESS);
+    }
+
+    //
+    // Keep a copy of the report being sent so that it can be returned for a
+    // Get_Report request.
+    //
+    pui8Slot = psInst->ppui8TxQueue[psInst->ui8TxRead];
+    psInst->ui8ReportSize = psInst->pui8TxSize[psInst->ui8TxRead];
+    for(i = 0; i < psInst->ui8ReportSize; i++)
+    {
+        psInst->pui8Report[i] = pui8Slot[i];
+    }
+
+    psInst->iCustomHidState = eHIDCustomHidStateSend;
+    if(!USBDHIDReportWrite((void *)psHIDDevice, psInst->pui8Report,
+                           psInst->ui8ReportSize, true))
+    {
+        psInst->iCustomHidState = eHIDCustomHidStateIdle;
+        return(CUSTOMHID_ERR_TX_ERROR);
+    }
+
+    //
+    // The report is now in the endpoint FIFO so its slot can be reused.
+    //
+    psInst->ui8TxRead = (psInst->ui8TxRead + 1) % CUSTOMHID_TX_SLOTS;
+    psInst->ui8TxCount--;
+
+    return(CUSTOMHID_SUCCESS);
+}
+
 
 //*****************************************************************************
 //
@@ -442,6 +802,12 @@ HIDCustomHidRxHandler(void *pvCustomHidDevice, uint32_t ui32Event,
         {
             psInst->ui8USBConfigured = false;
 
+            //
+            // Anything still queued was meant for the old connection.
+            //
+            psInst->ui8TxCount = 0;
+            psInst->iCustomHidState = eHIDCustomHidStateUnconfigured;
+
             //
             // Pass the information on to the client.
             //
@@ -458,13 +824,26 @@ HIDCustomHidRxHandler(void *pvCustomHidDevice, uint32_t ui32Event,
         case USBD_HID_EVENT_IDLE_TIMEOUT:
         case USBD_HID_EVENT_GET_REPORT:
         {
+            //
+            // Feature reports belong to the client, which sets the report
+            // pointer and returns the length, or 0 if it has no such report.
+            //
+            if((ui32Event == USBD_HID_EVENT_GET_REPORT) &&
+               ((ui32MsgData >> 8) == USB_HID_REPORT_FEATURE))
+            {
+                return(psCustomHidDevice->pfnCallback(
+                                            psCustomHidDevice->pvCBData,
+                                            ui32Event, ui32MsgData,
+                                            pvMsgData));
+            }
+
             //
             // We only support a single input report so we don't need to check
             // the ui32MsgValue parameter in this case.  Set the report pointer
             // in *pvMsgData and return the length of the report in bytes.
             //
             *(uint8_t **)pvMsgData = psInst->pui8Report;
-            return(8);
+            return(psInst->ui8ReportSize);
         }
 
         //
@@ -481,17 +860,27 @@ HIDCustomHidRxHandler(void *pvCustomHidDevice, uint32_t ui32Event,
 
         //
         // This event is sent in response to a host Set_Report request.  The
-        // customhid device has no output reports so we return a NULL pointer and
-        // zero length to cause this request to be stalled.
+        // customhid device has no output reports of its own, so the client
+        // is asked for a buffer.  ui32MsgData holds the report type and ID
+        // and pvMsgData the length.  A NULL pointer from the client causes
+        // the request to be stalled.
         //
         case USBD_HID_EVENT_GET_REPORT_BUFFER:
         {
-            //
-            // We are being asked for a report that does not exist for
-            // this device.  Return 0 to indicate that we are not providing
-            // a buffer.
-            //
-            return(0);
+            return(psCustomHidDevice->pfnCallback(psCustomHidDevice->pvCBData,
+                                              ui32Event, ui32MsgData,
+                                              pvMsgData));
+        }
+
+        //
+        // The data for a Set_Report request has arrived in the buffer given
+        // out above.  Pass it to the client.
+        //
+        case USBD_HID_EVENT_SET_REPORT:
+        {
+            return(psCustomHidDevice->pfnCallback(psCustomHidDevice->pvCBData,
+                                              ui32Event, ui32MsgData,
+                                              pvMsgData));
         }
 
         //
@@ -588,6 +977,11 @@ HIDCustomHidTxHandler(void *pvCustomHidDevice, uint32_t ui32Event,
             //
             psInst->iCustomHidState = eHIDCustomHidStateIdle;
 
+            //
+            // Move straight on to the next queued report, if any.
+            //
+            HIDCustomHidTxNext(psCustomHidDevice);
+
             //
             // Pass the event on to the client.
             //
@@ -728,6 +1122,7 @@ USBDHIDCustomHidCompositeInit(uint32_t ui32Index,
     ASSERT(psCustomHidDevice);
     ASSERT(psCustomHidDevice->ppui8StringDescriptors);
     ASSERT(psCustomHidDevice->pfnCallback);
+    ASSERT(psCustomHidDevice->ui32Interface < CUSTOMHID_NUM_IFACES);
 
     //
     // Get a pointer to our instance data
@@ -749,6 +1144,9 @@ USBDHIDCustomHidCompositeInit(uint32_t ui32Index,
     psInst->sReportIdle.ui32TimeSinceReportmS = 0;
     psInst->sReportIdle.ui16TimeTillNextmS = 0;
     psInst->iCustomHidState = eHIDCustomHidStateUnconfigured;
+    psInst->ui8TxRead = 0;
+    psInst->ui8TxCount = 0;
+    psInst->ui8ReportSize = CUSTOMHID_REPORT_SIZE;
 
     //
     // Initialize the HID device class instance structure based on input from
@@ -767,13 +1165,16 @@ USBDHIDCustomHidCompositeInit(uint32_t ui32Index,
     psHIDDevice->pfnTxCallback = HIDCustomHidTxHandler;
     psHIDDevice->pvTxCBData = (void *)psCustomHidDevice;
     psHIDDevice->bUseOutEndpoint = false;
-    psHIDDevice->psHIDDescriptor = &g_sCustomHidHIDDescriptor;
-    psHIDDevice->ppui8ClassDescriptors = g_pui8CustomHidClassDescriptors;
+    psHIDDevice->psHIDDescriptor =
+                &g_psCustomHidHIDDescriptors[psCustomHidDevice->ui32Interface];
+    psHIDDevice->ppui8ClassDescriptors =
+            g_pppui8CustomHidClassDescriptors[psCustomHidDevice->ui32Interface];
     psHIDDevice->ppui8StringDescriptors =
                                     psCustomHidDevice->ppui8StringDescriptors;
     psHIDDevice->ui32NumStringDescriptors =
                                     psCustomHidDevice->ui32NumStringDescriptors;
-    psHIDDevice->ppsConfigDescriptor = g_ppsHIDConfigDescriptors;
+    psHIDDevice->ppsConfigDescriptor =
+                g_pppsHIDConfigDescriptors[psCustomHidDevice->ui32Interface];
 
     //
     // Initialize the lower layer HID driver and pass it the various structures
@@ -876,17 +1277,35 @@ USBDHIDCustomHidSetCBData(void *pvCustomHidDevice, void *pvCBData)
 
 //*****************************************************************************
 //
-// Reports a customhid state change, pointer movement or button press
+//! Reports a customhid state change, pointer movement or button press.
+//!
+//! \param pvCustomHidDevice is the pointer to the customhid device instance
+//! structure.
+//! \param ReportID is the ID of the report being sent, or 0 if the report
+//! descriptor does not use report IDs.
+//! \param HIDData is the report payload, not including the report ID.
+//!
+//! The report is placed in the transmit queue and this function returns
+//! without waiting for the host.  If a report with the same ID is still
+//! queued it is replaced by the new state, so the host always receives the
+//! most recent state for each ID.  Queued reports are sent one per
+//! transaction as the host acknowledges the previous one.
+//!
+//! \return Returns \b CUSTOMHID_SUCCESS if the report was queued,
+//! \b CUSTOMHID_ERR_QUEUE_FULL if there is no slot for it,
+//! \b CUSTOMHID_ERR_TX_ERROR if it was queued but the lower layer refused to
+//! start sending it, or \b CUSTOMHID_ERR_NOT_CONFIGURED if the host has not
+//! configured the device.
 //
 //*****************************************************************************
 uint32_t
 USBDHIDCustomHidStateChange(void *pvCustomHidDevice, uint8_t ReportID, signed char HIDData[])
 {
-    uint32_t ui32Retcode, ui32Count;
-    uint8_t i;
+    uint32_t ui32Retcode;
+    uint8_t i, ui8Slot, ui8Size, *pui8Slot;
+    bool bIntsOff;
     tHIDCustomHidInstance *psInst;
     tUSBDHIDCustomHidDevice *psCustomHidDevice;
-    tUSBDHIDDevice *psHIDDevice;
 
     //
     // Get a pointer to the device.
@@ -894,77 +1313,186 @@ USBDHIDCustomHidStateChange(void *pvCustomHidDevice, uint8_t ReportID, signed ch
     psCustomHidDevice = (tUSBDHIDCustomHidDevice *)pvCustomHidDevice;
 
     //
-    // Get a pointer to the HID device data.
+    // Get a pointer to our instance data
     //
-    psHIDDevice = &psCustomHidDevice->sPrivateData.sHIDDevice;
+    psInst = &psCustomHidDevice->sPrivateData;
 
     //
-    // Get a pointer to our instance data
+    // If we are not configured, return an error here before trying to queue
+    // anything.
     //
-    psInst = &psCustomHidDevice->sPrivateData;
+    if(!psInst->ui8USBConfigured)
+    {
+        return(CUSTOMHID_ERR_NOT_CONFIGURED);
+    }
+
+    //
+    // The queue is shared with the transmit handler so keep the USB
+    // interrupt out while it is being updated.
+    //
+    bIntsOff = IntMasterDisable();
+
+    //
+    // Reuse the slot of a queued report with the same ID, otherwise take the
+    // next free one.
+    //
+    for(i = 0; i < psInst->ui8TxCount; i++)
+    {
+        ui8Slot = (psInst->ui8TxRead + i) % CUSTOMHID_TX_SLOTS;
+        if((ReportID == 0) || (psInst->ppui8TxQueue[ui8Slot][0] == ReportID))
+        {
+            break;
+        }
+    }
+
+    if(i == psInst->ui8TxCount)
+    {
+        if(psInst->ui8TxCount == CUSTOMHID_TX_SLOTS)
+        {
+            if(!bIntsOff)
+            {
+                IntMasterEnable();
+            }
+            return(CUSTOMHID_ERR_QUEUE_FULL);
+        }
+        psInst->ui8TxCount++;
+    }
+
+    ui8Slot = (psInst->ui8TxRead + i) % CUSTOMHID_TX_SLOTS;
+    pui8Slot = psInst->ppui8TxQueue[ui8Slot];
 
 	if (ReportID > 0)
 	{
-		psInst->pui8Report[0] = ReportID; //ReportID
+		ui8Size = HIDCustomHidReportSize(ReportID);
+		pui8Slot[0] = ReportID; //ReportID
 
-		for(i = 1; i < CUSTOMHID_REPORT_SIZE; i++)
+		for(i = 1; i < ui8Size; i++)
 		{
-			psInst->pui8Report[i] = HIDData[i-1];; //Data is offset by 1 due to the ReportID
+			pui8Slot[i] = HIDData[i-1]; //Data is offset by 1 due to the ReportID
 		}
 	}
 	else
 	{
-		for(i = 0; i < CUSTOMHID_REPORT_SIZE; i++)
+		ui8Size = CUSTOMHID_REPORT_SIZE;
+		for(i = 0; i < ui8Size; i++)
 		{
-			psInst->pui8Report[i] = HIDData[i];; //No ReportID so no offset
+			pui8Slot[i] = HIDData[i]; //No ReportID so no offset
 		}
 	}
+	psInst->pui8TxSize[ui8Slot] = ui8Size;
 
     //
-    // If we are not configured, return an error here before trying to send
-    // anything.
+    // Start sending straight away if the endpoint is idle.
     //
-    if(!psInst->ui8USBConfigured)
+    ui32Retcode = HIDCustomHidTxNext(psCustomHidDevice);
+
+    if(!bIntsOff)
     {
-        return(CUSTOMHID_ERR_NOT_CONFIGURED);
+        IntMasterEnable();
     }
 
     //
-    // Only send a report if the transmitter is currently free.
+    // Return the relevant error code to the caller.
     //
-    if(USBDHIDTxPacketAvailable((void *)psHIDDevice))
-    {
-        //
-        // Send the report to the host.
-        //
-        psInst->iCustomHidState = eHIDCustomHidStateSend;
-        ui32Count = USBDHIDReportWrite((void *)psHIDDevice,
-                                       psInst->pui8Report, CUSTOMHID_REPORT_SIZE,
-                                       true);
+    return(ui32Retcode);
+}
 
-        //
-        // Did we schedule a packet for transmission correctly?
-        //
-        if(!ui32Count)
-        {
-            //
-            // No - report the error to the caller.
-            //
-            ui32Retcode = CUSTOMHID_ERR_TX_ERROR;
-        }
-        else
+//*****************************************************************************
+//
+//! Returns the number of reports waiting to be sent.
+//!
+//! \param pvCustomHidDevice is the pointer to the customhid device instance
+//! structure.
+//!
+//! This does not include a report that has already been handed to the
+//! endpoint and is waiting for the host to acknowledge it.
+//!
+//! \return Returns the number of queued reports.
+//
+//*****************************************************************************
+uint32_t
+USBDHIDCustomHidTxPending(void *pvCustomHidDevice)
+{
+    tUSBDHIDCustomHidDevice *psCustomHidDevice;
+
+    ASSERT(pvCustomHidDevice);
+
+    psCustomHidDevice = (tUSBDHIDCustomHidDevice *)pvCustomHidDevice;
+
+    return(psCustomHidDevice->sPrivateData.ui8TxCount);
+}
+
+//*****************************************************************************
+//
+//! Returns true if no report is queued or waiting for the host.
+//!
+//! \param pvCustomHidDevice is the pointer to the customhid device instance
+//! structure.
+//!
+//! When this returns true the next USB_EVENT_TX_COMPLETE will be for the
+//! next report passed to USBDHIDCustomHidStateChange().
+//!
+//! \return Returns true if the interrupt IN endpoint is idle.
+//
+//*****************************************************************************
+bool
+USBDHIDCustomHidTxIdle(void *pvCustomHidDevice)
+{
+    tHIDCustomHidInstance *psInst;
+
+    ASSERT(pvCustomHidDevice);
+
+    psInst = &((tUSBDHIDCustomHidDevice *)pvCustomHidDevice)->sPrivateData;
+
+    return(!psInst->ui8TxCount &&
+           (psInst->iCustomHidState != eHIDCustomHidStateSend));
+}
+
+//*****************************************************************************
+//
+//! Returns true if a report with the given ID is queued.
+//!
+//! \param pvCustomHidDevice is the pointer to the customhid device instance
+//! structure.
+//! \param ui8ReportID is the report ID to look for.
+//!
+//! A queued report is replaced by the next report with the same ID passed to
+//! USBDHIDCustomHidStateChange().  Reports that carry relative values should
+//! only be passed once this returns false, since a replaced report is never
+//! sent.  Only the transmit handler removes reports from the queue, so once
+//! this has returned false it stays false until the caller queues the ID.
+//!
+//! \return Returns true if a report with the ID is waiting to be sent.
+//
+//*****************************************************************************
+bool
+USBDHIDCustomHidTxQueued(void *pvCustomHidDevice, uint8_t ui8ReportID)
+{
+    tHIDCustomHidInstance *psInst;
+    uint8_t i;
+    bool bIntsOff, bQueued;
+
+    ASSERT(pvCustomHidDevice);
+
+    psInst = &((tUSBDHIDCustomHidDevice *)pvCustomHidDevice)->sPrivateData;
+
+    bIntsOff = IntMasterDisable();
+    bQueued = false;
+    for(i = 0; i < psInst->ui8TxCount; i++)
+    {
+        if(psInst->ppui8TxQueue[(psInst->ui8TxRead + i) %
+                                CUSTOMHID_TX_SLOTS][0] == ui8ReportID)
         {
-            ui32Retcode = CUSTOMHID_SUCCESS;
+            bQueued = true;
+            break;
         }
     }
-    else
+    if(!bIntsOff)
     {
-        ui32Retcode = CUSTOMHID_ERR_TX_ERROR;
+        IntMasterEnable();
     }
-    //
-    // Return the relevant error code to the caller.
-    //
-    return(ui32Retcode);
+
+    return(bQueued);
 }
 
 //*****************************************************************************
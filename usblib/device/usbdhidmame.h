@@ -44,6 +44,8 @@ extern "C"
 //
 //*****************************************************************************
 
+#include "usblib/device/usbdhidmamecfg.h"
+
 //*****************************************************************************
 //
 // PRIVATE
@@ -58,10 +60,30 @@ extern "C"
 //
 // PRIVATE
 //
-// The size of the customhid input report sent to the host.
+// The size of the largest customhid input report sent to the host, including
+// the report ID.
+//
+//*****************************************************************************
+#if CUSTOMHID_COMBINED_REPORT
+#define CUSTOMHID_INPUT_SIZE        CUSTOMHID_COMBINED_SIZE
+#else
+#define CUSTOMHID_INPUT_SIZE        CUSTOMHID_MOUSE_SIZE
+#endif
+
+#if CUSTOMHID_ANALOG_SIZE > CUSTOMHID_INPUT_SIZE
+#define CUSTOMHID_REPORT_SIZE       (CUSTOMHID_ANALOG_SIZE + 1)
+#else
+#define CUSTOMHID_REPORT_SIZE       (CUSTOMHID_INPUT_SIZE + 1)
+#endif
+
+//*****************************************************************************
+//
+// PRIVATE
+//
+// The number of reports that can be queued for the interrupt IN endpoint.
 //
 //*****************************************************************************
-#define CUSTOMHID_REPORT_SIZE       4
+#define CUSTOMHID_TX_SLOTS          4
 
 //*****************************************************************************
 //
@@ -123,6 +145,25 @@ typedef struct
     //
     uint8_t pui8Report[CUSTOMHID_REPORT_SIZE];
 
+    //
+    // The length of the report held in pui8Report.
+    //
+    uint8_t ui8ReportSize;
+
+    //
+    // Reports waiting for the interrupt IN endpoint.  Each slot holds one
+    // complete report and a newer report for an ID that is already queued
+    // replaces the older one in place.
+    //
+    uint8_t ppui8TxQueue[CUSTOMHID_TX_SLOTS][CUSTOMHID_REPORT_SIZE];
+    uint8_t pui8TxSize[CUSTOMHID_TX_SLOTS];
+
+    //
+    // The oldest queued slot and the number of slots in use.
+    //
+    volatile uint8_t ui8TxRead;
+    volatile uint8_t ui8TxCount;
+
     //
     // The current state of the customhid interrupt IN endpoint.
     //
@@ -203,6 +244,12 @@ typedef struct
     //
     const uint32_t ui32NumStringDescriptors;
 
+    //
+    //! Which of the driver's HID interfaces this instance presents, one of
+    //! the CUSTOMHID_IFACE_ values.
+    //
+    const uint32_t ui32Interface;
+
     //
     //! The private instance data for this device.  This memory must
     //! remain accessible for as long as the customhid device is in use and must
@@ -238,6 +285,15 @@ tUSBDHIDCustomHidDevice;
 #define CUSTOMHID_ERR_NOT_CONFIGURED \
                                 4
 
+//*****************************************************************************
+//
+//! USBDHIDCustomHidStateChange returns this value if every transmit slot is
+//! already holding a report for a different report ID.  The state passed on
+//! the call has been ignored and should be offered again later.
+//
+//*****************************************************************************
+#define CUSTOMHID_ERR_QUEUE_FULL    8
+
 //*****************************************************************************
 //
 // API Function Prototypes
@@ -251,6 +307,10 @@ extern void *USBDHIDCustomHidCompositeInit(uint32_t ui32Index,
 extern void USBDHIDCustomHidTerm(void *pvCustomHidDevice);
 extern void *USBDHIDCustomHidSetCBData(void *pvCustomHidDevice, void *pvCBData);
 extern uint32_t USBDHIDCustomHidStateChange(void *pvCustomHidDevice, uint8_t ReportID, signed char HIDData[]);
+extern uint32_t USBDHIDCustomHidTxPending(void *pvCustomHidDevice);
+extern bool USBDHIDCustomHidTxIdle(void *pvCustomHidDevice);
+extern bool USBDHIDCustomHidTxQueued(void *pvCustomHidDevice,
+                                     uint8_t ui8ReportID);
 extern void USBDHIDCustomHidPowerStatusSet(void *pvCustomHidDevice,
                                        uint8_t ui8Power);
 extern bool USBDHIDCustomHidRemoteWakeupRequest(void *pvCustomHidDevice);
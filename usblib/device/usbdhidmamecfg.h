@@ -0,0 +1,215 @@
+//*****************************************************************************
+//
+// usbdhidmamecfg.h - Build options and report layout for the Mame HID device
+//                    class driver
+//
+// These are plain definitions with no dependency on the rest of the USB
+// library so that code shared with the host build can use them.
+//
+//*****************************************************************************
+
+#ifndef __USBDHIDMAMECFG_H__
+#define __USBDHIDMAMECFG_H__
+
+//*****************************************************************************
+//
+//! \addtogroup hid_customhid_device_class_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Set CUSTOMHID_COMBINED_REPORT to 1, in both the usblib and the application
+//! projects, to replace the separate gamepad and mouse reports with a single
+//! report that carries both players and the trackball in one packet.
+//
+//*****************************************************************************
+#ifndef CUSTOMHID_COMBINED_REPORT
+#define CUSTOMHID_COMBINED_REPORT   0
+#endif
+
+//*****************************************************************************
+//
+//! Set CUSTOMHID_MOUSE_16BIT to 1, in both the usblib and the application
+//! projects, to report trackball motion as 16 bit rather than 8 bit relative
+//! values, in the mouse report and in the combined report.
+//
+//*****************************************************************************
+#ifndef CUSTOMHID_MOUSE_16BIT
+#define CUSTOMHID_MOUSE_16BIT       0
+#endif
+
+//*****************************************************************************
+//
+//! Set CUSTOMHID_SPINNER to 1, in both the usblib and the application
+//! projects, to report a spinner as a third relative axis, the wheel of the
+//! mouse report or the dial of the combined report.
+//
+//*****************************************************************************
+#ifndef CUSTOMHID_SPINNER
+#define CUSTOMHID_SPINNER           0
+#endif
+
+//*****************************************************************************
+//
+//! The number of relative axes, the bytes each takes and the largest motion
+//! each can carry in one report.
+//
+//*****************************************************************************
+#if CUSTOMHID_SPINNER
+#define CUSTOMHID_MOUSE_AXES        3
+#else
+#define CUSTOMHID_MOUSE_AXES        2
+#endif
+#if CUSTOMHID_MOUSE_16BIT
+#define CUSTOMHID_MOUSE_AXIS_BYTES  2
+#define CUSTOMHID_MOUSE_MAX         32767
+#else
+#define CUSTOMHID_MOUSE_AXIS_BYTES  1
+#define CUSTOMHID_MOUSE_MAX         127
+#endif
+
+//*****************************************************************************
+//
+//! The report ID and payload size, not including the ID, of the mouse report.
+//
+//*****************************************************************************
+#define CUSTOMHID_REPORT_ID_MOUSE   3
+#define CUSTOMHID_MOUSE_SIZE                                                  \
+                                (1 + (CUSTOMHID_MOUSE_AXES *                  \
+                                      CUSTOMHID_MOUSE_AXIS_BYTES))
+
+//*****************************************************************************
+//
+//! The report ID and payload size, not including the ID, of the combined
+//! report.
+//
+//*****************************************************************************
+#define CUSTOMHID_REPORT_ID_COMBINED                                          \
+                                4
+#define CUSTOMHID_COMBINED_SIZE                                               \
+                                (4 + (CUSTOMHID_MOUSE_AXES *                  \
+                                      CUSTOMHID_MOUSE_AXIS_BYTES))
+
+//*****************************************************************************
+//
+//! Set CUSTOMHID_ANALOG_AXES to 1, 2 or 4, in both the usblib and the
+//! application projects, to report that many analog inputs as the absolute
+//! axes of a joystick.  Each axis is 16 bits and runs from 0 to
+//! CUSTOMHID_ANALOG_MAX.
+//
+//*****************************************************************************
+#ifndef CUSTOMHID_ANALOG_AXES
+#define CUSTOMHID_ANALOG_AXES       0
+#endif
+
+#if (CUSTOMHID_ANALOG_AXES != 0) && (CUSTOMHID_ANALOG_AXES != 1) &&           \
+    (CUSTOMHID_ANALOG_AXES != 2) && (CUSTOMHID_ANALOG_AXES != 4)
+#error "CUSTOMHID_ANALOG_AXES must be 0, 1, 2 or 4"
+#endif
+
+//*****************************************************************************
+//
+//! The report ID and payload size, not including the ID, of the analog
+//! report, and the largest value of an axis.
+//
+//*****************************************************************************
+#define CUSTOMHID_REPORT_ID_ANALOG  8
+#define CUSTOMHID_ANALOG_SIZE       (CUSTOMHID_ANALOG_AXES * 2)
+#define CUSTOMHID_ANALOG_MAX        4095
+
+//*****************************************************************************
+//
+//! The report ID and payload size, not including the ID, of the vendor
+//! feature report that carries the latency statistics.  Feature reports are
+//! passed to the client callback as USBD_HID_EVENT_GET_REPORT,
+//! USBD_HID_EVENT_GET_REPORT_BUFFER and USBD_HID_EVENT_SET_REPORT.
+//
+//*****************************************************************************
+#define CUSTOMHID_REPORT_ID_LATENCY 5
+#define CUSTOMHID_LATENCY_SIZE      99
+
+//*****************************************************************************
+//
+//! The report ID and payload size, not including the ID, of the vendor
+//! feature report that carries the cycle counts of the firmware's hot paths.
+//! The application only answers it when built with CYCLE_PROFILE_ENABLE.
+//
+//*****************************************************************************
+#define CUSTOMHID_REPORT_ID_CYCLES  6
+#define CUSTOMHID_CYCLES_SIZE       66
+
+//*****************************************************************************
+//
+//! The report ID and payload size, not including the ID, of the vendor
+//! feature report that reads and writes the trackball settings.
+//
+//*****************************************************************************
+#define CUSTOMHID_REPORT_ID_MOUSE_CONFIG                                      \
+                                7
+#define CUSTOMHID_MOUSE_CONFIG_SIZE 6
+
+//*****************************************************************************
+//
+//! The report ID and payload size, not including the ID, of the vendor
+//! feature report that reads and selects the settings profile in use.
+//
+//*****************************************************************************
+#define CUSTOMHID_REPORT_ID_PROFILE_SELECT                                    \
+                                9
+#define CUSTOMHID_PROFILE_SELECT_SIZE                                         \
+                                2
+
+//*****************************************************************************
+//
+//! The report ID and payload size, not including the ID, of the vendor
+//! feature report through which the host reads and writes the settings.
+//
+//*****************************************************************************
+#define CUSTOMHID_REPORT_ID_SETTINGS                                          \
+                                10
+#define CUSTOMHID_SETTINGS_SIZE     63
+
+//*****************************************************************************
+//
+//! Set CUSTOMHID_COMPOSITE to 1, in both the usblib and the application
+//! projects, to present gamepad one, gamepad two and the mouse as three HID
+//! interfaces of a composite device.  Each interface then has its own
+//! interrupt IN endpoint so one device can not hold up the reports of
+//! another.
+//
+//*****************************************************************************
+#ifndef CUSTOMHID_COMPOSITE
+#define CUSTOMHID_COMPOSITE         0
+#endif
+
+#if CUSTOMHID_COMPOSITE && CUSTOMHID_COMBINED_REPORT
+#error "CUSTOMHID_COMPOSITE and CUSTOMHID_COMBINED_REPORT can not be combined"
+#endif
+
+//*****************************************************************************
+//
+//! Values for the ui32Interface member of tUSBDHIDCustomHidDevice.  The
+//! single interface build only has CUSTOMHID_IFACE_ALL.  The composite build
+//! has one interface for each device.
+//
+//*****************************************************************************
+#if CUSTOMHID_COMPOSITE
+#define CUSTOMHID_IFACE_PAD1        0
+#define CUSTOMHID_IFACE_PAD2        1
+#define CUSTOMHID_IFACE_MOUSE       2
+#define CUSTOMHID_NUM_IFACES        3
+#else
+#define CUSTOMHID_IFACE_ALL         0
+#define CUSTOMHID_NUM_IFACES        1
+#endif
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
+
+#endif // __USBDHIDMAMECFG_H__
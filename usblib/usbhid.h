@@ -114,6 +114,8 @@ extern "C"
 #define USB_HID_RX              0x33
 #define USB_HID_RY              0x34
 #define USB_HID_RZ              0x35
+#define USB_HID_DIAL            0x37
+#define USB_HID_WHEEL           0x38
 #define USB_HID_HAT             0x39
 
 #define USB_HID_POINTER         0x01